@@ -20,6 +20,7 @@
 
 #include "activeproject.h"
 #include "coreutils.h"
+#include "lookuptable.h"
 
 #ifdef ANDROID
 #include "position/tracking/androidtrackingbroadcast.h"
@@ -103,6 +104,9 @@ bool ActiveProject::forceLoad( const QString &filePath, bool force )
   // clear autosync
   setAutosyncEnabled( false );
 
+  // stop precomputing checksums of the previous project
+  mChecksumIndexer.reset();
+
   // clear position tracking broadcast listeners
 #ifdef ANDROID
   disconnect( &AndroidTrackingBroadcast::getInstance() );
@@ -189,6 +193,9 @@ bool ActiveProject::forceLoad( const QString &filePath, bool force )
     updateActiveLayer();
     updateMapSettingsLayers();
 
+    // read lookup layers of value relations and relation references in the background, forms then open faster
+    LookupTable::prepareProjectTables( mQgsProject );
+
     emit localProjectChanged( mLocalProject );
     emit projectReloaded( mQgsProject );
     emit positionTrackingSupportedChanged();
@@ -221,6 +228,12 @@ bool ActiveProject::forceLoad( const QString &filePath, bool force )
     setAutosyncEnabled( true );
   }
 
+  // keep checksums of project files warm for the next sync
+  if ( mLocalProject.hasMerginMetadata() )
+  {
+    mChecksumIndexer = std::make_unique<ProjectChecksumIndexer>( mQgsProject, mLocalProject.projectDir );
+  }
+
   // in case tracking is running, we want to show the UI
 #ifdef ANDROID
   if ( positionTrackingSupported() )
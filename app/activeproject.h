@@ -21,6 +21,7 @@
 #include "layersproxymodel.h"
 #include "localprojectsmanager.h"
 #include "autosynccontroller.h"
+#include "projectchecksumindexer.h"
 #include "inputmapsettings.h"
 #include "merginprojectmetadata.h"
 
@@ -188,6 +189,7 @@ class ActiveProject: public QObject
     LocalProjectsManager &mLocalProjectsManager;
     InputMapSettings *mMapSettings = nullptr;
     std::unique_ptr<AutosyncController> mAutosyncController;
+    std::unique_ptr<ProjectChecksumIndexer> mChecksumIndexer;
 
     QString mProjectLoadingLog;
     QString mProjectRole;
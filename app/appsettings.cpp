@@ -32,6 +32,7 @@ AppSettings::AppSettings( QObject *parent ): QObject( parent )
   double gpsHeight = settings.value( "gpsHeight", 0 ).toDouble();
   QString ignoreMigrateVersion = settings.value( QStringLiteral( "ignoreMigrateVersion" ) ).toString();
   bool autolockPosition = settings.value( QStringLiteral( "autolockPosition" ), true ).toBool();
+  bool renderProfilerEnabled = settings.value( QStringLiteral( "renderProfilerEnabled" ), false ).toBool();
 
   settings.endGroup();
 
@@ -48,6 +49,7 @@ AppSettings::AppSettings( QObject *parent ): QObject( parent )
   setGpsAntennaHeight( gpsHeight );
   setIgnoreMigrateVersion( ignoreMigrateVersion );
   setAutolockPosition( autolockPosition );
+  setRenderProfilerEnabled( renderProfilerEnabled );
 }
 
 QString AppSettings::defaultLayer() const
@@ -296,6 +298,21 @@ void AppSettings::setAutolockPosition( bool autolockPosition )
   emit autolockPositionChanged( mAutolockPosition );
 }
 
+bool AppSettings::renderProfilerEnabled() const
+{
+  return mRenderProfilerEnabled;
+}
+
+void AppSettings::setRenderProfilerEnabled( bool renderProfilerEnabled )
+{
+  if ( mRenderProfilerEnabled == renderProfilerEnabled )
+    return;
+
+  mRenderProfilerEnabled = renderProfilerEnabled;
+  setValue( QStringLiteral( "renderProfilerEnabled" ), renderProfilerEnabled );
+  emit renderProfilerEnabledChanged( mRenderProfilerEnabled );
+}
+
 double AppSettings::gpsAntennaHeight() const
 {
   return mGpsAntennaHeight;
@@ -35,6 +35,7 @@ class AppSettings: public QObject
     Q_PROPERTY( double gpsAntennaHeight READ gpsAntennaHeight WRITE setGpsAntennaHeight NOTIFY gpsAntennaHeightChanged )
     Q_PROPERTY( QString ignoreMigrateVersion READ ignoreMigrateVersion WRITE setIgnoreMigrateVersion NOTIFY ignoreMigrateVersionChanged )
     Q_PROPERTY( bool autolockPosition READ autolockPosition WRITE setAutolockPosition NOTIFY autolockPositionChanged )
+    Q_PROPERTY( bool renderProfilerEnabled READ renderProfilerEnabled WRITE setRenderProfilerEnabled NOTIFY renderProfilerEnabledChanged )
 
   public:
     explicit AppSettings( QObject *parent = nullptr );
@@ -86,6 +87,9 @@ class AppSettings: public QObject
     bool autolockPosition() const;
     void setAutolockPosition( bool autolockPosition );
 
+    bool renderProfilerEnabled() const;
+    void setRenderProfilerEnabled( bool renderProfilerEnabled );
+
   public slots:
     void setReuseLastEnteredValues( bool reuseLastEnteredValues );
 
@@ -104,6 +108,7 @@ class AppSettings: public QObject
 
     void autosyncAllowedChanged( bool autosyncAllowed );
     void autolockPositionChanged( bool autolockPosition );
+    void renderProfilerEnabledChanged( bool renderProfilerEnabled );
 
     void ignoreMigrateVersionChanged();
 
@@ -138,6 +143,8 @@ class AppSettings: public QObject
     QString mActivePositionProviderId;
     bool mAutosyncAllowed = false;
     bool mAutolockPosition = true;
+    // shows map rendering statistics above the map
+    bool mRenderProfilerEnabled = false;
     double mGpsAntennaHeight = 0;
     QString mIgnoreMigrateVersion;
 };
@@ -16,11 +16,13 @@
 #include "attributecontroller.h"
 #include "attributeformmodel.h"
 #include "attributetabmodel.h"
+#include "attributeformtemplate.h"
 #include "fieldvalidator.h"
 
 #include <QDebug>
 #include <QSet>
 
+#include "qgsapplication.h"
 #include "qgsproject.h"
 #include "qgsvectorlayer.h"
 #include "qgsattributeeditorfield.h"
@@ -32,6 +34,7 @@
 #include "qgsattributeeditorhtmlelement.h"
 #include "qgsvectorlayereditbuffer.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsfeaturerequest.h"
 #include "qgsrelation.h"
 #include "inpututils.h"
 #include "coreutils.h"
@@ -40,6 +43,14 @@ AttributeController::AttributeController( QObject *parent )
   : QObject( parent )
   , mAttributeTabProxyModel( new AttributeTabProxyModel() )
 {
+  // values of global and project variables are taken when the expressions are prepared
+  auto onVariablesChanged = [this]()
+  {
+    if ( mFeatureLayerPair.layer() )
+      prepareExpressions();
+  };
+  connect( QgsApplication::instance(), &QgsApplication::customVariablesChanged, this, onVariablesChanged );
+  connect( QgsProject::instance(), &QgsProject::customVariablesChanged, this, onVariablesChanged );
 }
 
 void AttributeController::reset()
@@ -458,6 +469,11 @@ void AttributeController::clearAll()
   mTabItems.clear();
   mExpressionFieldsOutsideForm.clear();
   mVirtualFieldsOutsideForm.clear();
+  mFieldDependencies.clear();
+  mFormItemDependencies.clear();
+  mTabItemDependencies.clear();
+  mDefaultValueExpressions.clear();
+  mVirtualFieldExpressions.clear();
   mHasTabs = false;
 }
 
@@ -469,6 +485,45 @@ void AttributeController::updateOnLayerChange()
     return;
 
   // 1) DATA
+  // the form configuration is parsed only for the first form of the layer, next forms clone its layout
+  AttributeFormTemplate *formTemplate = AttributeFormTemplate::forLayer( layer );
+  if ( formTemplate->hasLayout() )
+  {
+    setFormLayout( formTemplate->cloneLayout() );
+  }
+  else
+  {
+    createFormLayout();
+    formTemplate->setLayout( formLayout() );
+  }
+
+  if ( mRememberAttributesController )
+    mRememberAttributesController->storeLayerFields( layer );
+
+
+  // 2) MODELS
+  // for all other models, ownership is managed by Qt parent system
+  AttributeTabModel *tabModel = new AttributeTabModel( mAttributeTabProxyModel.get(), this, mTabItems.size() );
+  mAttributeTabProxyModel->setSourceModel( tabModel );
+  mAttributeFormProxyModelForTabItem.resize( mTabItems.size() );
+  QVector<std::shared_ptr<TabItem>>::iterator tabItemsIterator = mTabItems.begin();
+  while ( tabItemsIterator != mTabItems.end() )
+  {
+    std::shared_ptr<TabItem> item = *tabItemsIterator;
+    const QVector<QUuid> &formItems = item->formItems();
+
+    AttributeFormProxyModel *proxyFormModel = new AttributeFormProxyModel( mAttributeTabProxyModel.get() );
+    AttributeFormModel *formModel = new AttributeFormModel( mAttributeTabProxyModel.get(), this, formItems );
+    proxyFormModel->setSourceModel( formModel );
+    mAttributeFormProxyModelForTabItem[item->tabIndex()] = proxyFormModel;
+    ++tabItemsIterator;
+  }
+}
+
+void AttributeController::createFormLayout()
+{
+  QgsVectorLayer *layer = mFeatureLayerPair.layer();
+
   if ( layer->editFormConfig().layout() == Qgis::AttributeFormLayout::DragAndDrop )
   {
     QgsAttributeEditorContainer *root = layer->editFormConfig().invisibleRootContainer();
@@ -513,28 +568,6 @@ void AttributeController::updateOnLayerChange()
     createTab( tab );
   }
 
-  if ( mRememberAttributesController )
-    mRememberAttributesController->storeLayerFields( layer );
-
-
-  // 2) MODELS
-  // for all other models, ownership is managed by Qt parent system
-  AttributeTabModel *tabModel = new AttributeTabModel( mAttributeTabProxyModel.get(), this, mTabItems.size() );
-  mAttributeTabProxyModel->setSourceModel( tabModel );
-  mAttributeFormProxyModelForTabItem.resize( mTabItems.size() );
-  QVector<std::shared_ptr<TabItem>>::iterator tabItemsIterator = mTabItems.begin();
-  while ( tabItemsIterator != mTabItems.end() )
-  {
-    std::shared_ptr<TabItem> item = *tabItemsIterator;
-    const QVector<QUuid> &formItems = item->formItems();
-
-    AttributeFormProxyModel *proxyFormModel = new AttributeFormProxyModel( mAttributeTabProxyModel.get() );
-    AttributeFormModel *formModel = new AttributeFormModel( mAttributeTabProxyModel.get(), this, formItems );
-    proxyFormModel->setSourceModel( formModel );
-    mAttributeFormProxyModelForTabItem[item->tabIndex()] = proxyFormModel;
-    ++tabItemsIterator;
-  }
-
   // collect fields which have default value expression and are not in the form
   QSet<int> fieldIndexes;
   QMap<QUuid, std::shared_ptr<FormItem>>::iterator formItemsIterator = mFormItems.begin();
@@ -568,6 +601,182 @@ void AttributeController::updateOnLayerChange()
     }
   }
 
+  buildDependencyGraph();
+  prepareExpressions();
+}
+
+AttributeFormTemplate::Layout AttributeController::formLayout() const
+{
+  AttributeFormTemplate::Layout layout;
+  layout.formItems = mFormItems;
+  layout.tabItems = mTabItems;
+  layout.hasTabs = mHasTabs;
+  layout.expressionFieldsOutsideForm = mExpressionFieldsOutsideForm;
+  layout.virtualFieldsOutsideForm = mVirtualFieldsOutsideForm;
+  layout.fieldDependencies = mFieldDependencies;
+  layout.formItemDependencies = mFormItemDependencies;
+  layout.tabItemDependencies = mTabItemDependencies;
+  layout.defaultValueExpressions = mDefaultValueExpressions;
+  layout.virtualFieldExpressions = mVirtualFieldExpressions;
+  return layout;
+}
+
+void AttributeController::setFormLayout( const AttributeFormTemplate::Layout &layout )
+{
+  mFormItems = layout.formItems;
+  mTabItems = layout.tabItems;
+  mHasTabs = layout.hasTabs;
+  mExpressionFieldsOutsideForm = layout.expressionFieldsOutsideForm;
+  mVirtualFieldsOutsideForm = layout.virtualFieldsOutsideForm;
+  mFieldDependencies = layout.fieldDependencies;
+  mFormItemDependencies = layout.formItemDependencies;
+  mTabItemDependencies = layout.tabItemDependencies;
+  mDefaultValueExpressions = layout.defaultValueExpressions;
+  mVirtualFieldExpressions = layout.virtualFieldExpressions;
+}
+
+void AttributeController::prepareExpressions()
+{
+  QgsVectorLayer *layer = mFeatureLayerPair.layer();
+  const QgsFields fields = layer->fields();
+
+  QgsExpressionContext context = layer->createExpressionContext();
+  context.setFields( fields );
+
+  for ( int i = 0; i < fields.count(); ++i )
+  {
+    if ( fields.fieldOrigin( i ) == QgsFields::OriginExpression )
+    {
+      QgsExpression exp( layer->expressionField( i ) );
+      exp.prepare( &context );
+      mVirtualFieldExpressions.insert( i, exp );
+    }
+
+    const QString defaultValueExpression = fields.at( i ).defaultValueDefinition().expression();
+    if ( !defaultValueExpression.isEmpty() )
+    {
+      QgsExpression exp( defaultValueExpression );
+      exp.prepare( &context );
+      mDefaultValueExpressions.insert( i, exp );
+    }
+  }
+
+  QMap<QUuid, std::shared_ptr<FormItem>>::iterator formItemsIterator = mFormItems.begin();
+  while ( formItemsIterator != mFormItems.end() )
+  {
+    formItemsIterator.value()->prepareExpressions( &context );
+    ++formItemsIterator;
+  }
+
+  for ( const std::shared_ptr<TabItem> &tab : std::as_const( mTabItems ) )
+  {
+    tab->prepareExpressions( &context );
+  }
+}
+
+void AttributeController::buildDependencyGraph()
+{
+  QgsVectorLayer *layer = mFeatureLayerPair.layer();
+  const QgsFields fields = layer->fields();
+
+  for ( int i = 0; i < fields.count(); ++i )
+  {
+    QSet<int> dependencies;
+
+    if ( fields.fieldOrigin( i ) == QgsFields::OriginExpression )
+    {
+      dependencies.unite( referencedFields( layer->expressionField( i ) ) );
+    }
+
+    const QgsDefaultValue defaultDefinition = fields.at( i ).defaultValueDefinition();
+    if ( !defaultDefinition.expression().isEmpty() )
+    {
+      QSet<int> defaultDependencies = referencedFields( defaultDefinition.expression() );
+
+      // values like now() or uuid() applied on update must be refreshed on any change
+      if ( defaultDefinition.applyOnUpdate() && defaultDependencies.isEmpty() )
+        defaultDependencies << ANY_FIELD;
+
+      dependencies.unite( defaultDependencies );
+    }
+
+    if ( !dependencies.isEmpty() )
+      mFieldDependencies.insert( i, dependencies );
+  }
+
+  QMap<QUuid, std::shared_ptr<FormItem>>::iterator formItemsIterator = mFormItems.begin();
+  while ( formItemsIterator != mFormItems.end() )
+  {
+    std::shared_ptr<FormItem> item = formItemsIterator.value();
+
+    QSet<int> dependencies = referencedFields( item->visibilityExpression().expression() );
+    dependencies.unite( referencedFields( item->nameExpression().expression() ) );
+    dependencies.unite( referencedFields( item->editableExpression().expression() ) );
+
+    if ( item->type() == FormItem::Field )
+    {
+      // the value itself is validated too
+      dependencies << item->fieldIndex();
+      dependencies.unite( referencedFields( item->field().constraints().constraintExpression() ) );
+    }
+    else if ( item->type() == FormItem::RichText )
+    {
+      const QStringList expressions = item->richTextExpressions();
+      for ( const QString &expression : expressions )
+      {
+        dependencies.unite( referencedFields( expression ) );
+      }
+    }
+
+    mFormItemDependencies.insert( item->id(), dependencies );
+    ++formItemsIterator;
+  }
+
+  mTabItemDependencies.resize( mTabItems.size() );
+  for ( const std::shared_ptr<TabItem> &tab : std::as_const( mTabItems ) )
+  {
+    mTabItemDependencies[tab->tabIndex()] = referencedFields( tab->visibilityExpression().expression() );
+  }
+}
+
+QSet<int> AttributeController::referencedFields( const QString &expression ) const
+{
+  QSet<int> result;
+  if ( expression.isEmpty() )
+    return result;
+
+  QgsExpression exp( expression );
+  if ( exp.hasParserError() )
+    return result;
+
+  const QSet<QString> columns = exp.referencedColumns();
+  const QSet<QString> variables = exp.referencedVariables();
+
+  // aggregates, attribute(@current_feature, ...) and similar can read any attribute
+  if ( columns.contains( QgsFeatureRequest::ALL_ATTRIBUTES ) ||
+       variables.contains( QStringLiteral( "current_feature" ) ) ||
+       variables.contains( QStringLiteral( "feature" ) ) )
+  {
+    result << ANY_FIELD;
+  }
+
+  const QgsFields fields = mFeatureLayerPair.layer()->fields();
+  for ( const QString &column : columns )
+  {
+    const int index = fields.lookupField( column );
+    if ( index >= 0 )
+      result << index;
+  }
+
+  return result;
+}
+
+bool AttributeController::dependsOn( const QSet<int> &dependencies, const QSet<int> *changedFields )
+{
+  if ( !changedFields )
+    return true;
+
+  return dependencies.contains( ANY_FIELD ) || dependencies.intersects( *changedFields );
 }
 
 void AttributeController::updateOnFeatureChange()
@@ -667,12 +876,9 @@ void AttributeController::acquireId()
   disconnect( mFeatureLayerPair.layer(), &QgsVectorLayer::featureAdded, this, &AttributeController::onFeatureAdded );
 }
 
-void AttributeController::evaluateExpressionAndUpdateValue( QSet<QUuid> &changedFormItems,
-    const QString &expressionString, QgsExpressionContext &expressionContext, int fieldIndex, const QgsField &field, std::shared_ptr<FormItem> formItem )
+bool AttributeController::evaluateExpressionAndUpdateValue( QSet<QUuid> &changedFormItems,
+    QgsExpression &exp, QgsExpressionContext &expressionContext, int fieldIndex, const QgsField &field, std::shared_ptr<FormItem> formItem )
 {
-  QgsExpression exp( expressionString );
-
-  exp.prepare( &expressionContext );
   if ( exp.hasParserError() )
   {
     QString msg( QStringLiteral( "Expression for %1:%2 has parser error: %3" ).arg(
@@ -680,7 +886,7 @@ void AttributeController::evaluateExpressionAndUpdateValue( QSet<QUuid> &changed
                    field.name(),
                    exp.parserErrorString() ) );
     CoreUtils::log( QStringLiteral( "Attribute Controller" ), msg );
-    return;
+    return false;
   }
 
   QVariant value = exp.evaluate( &expressionContext );
@@ -692,7 +898,7 @@ void AttributeController::evaluateExpressionAndUpdateValue( QSet<QUuid> &changed
                    field.name(),
                    exp.evalErrorString() ) );
     CoreUtils::log( QStringLiteral( "Attribute Controller" ), msg );
-    return;
+    return false;
   }
 
   QVariant val( value );
@@ -705,7 +911,7 @@ void AttributeController::evaluateExpressionAndUpdateValue( QSet<QUuid> &changed
                    value.isNull() ? "NULL" : "NOT NULL" )
                );
     CoreUtils::log( QStringLiteral( "Attribute Controller" ), msg );
-    return;
+    return false;
   }
 
   QVariant oldVal = mFeatureLayerPair.feature().attribute( fieldIndex );
@@ -724,14 +930,18 @@ void AttributeController::evaluateExpressionAndUpdateValue( QSet<QUuid> &changed
 
     // Update also expression context after an attribute change
     expressionContext.setFeature( featureLayerPair().featureRef() );
+    return true;
   }
+
+  return false;
 }
 
 void AttributeController::recalculateDefaultValues(
   QSet<QUuid> &changedFormItems,
   QgsExpressionContext &expressionContext,
   bool isFormValueChange,
-  bool isFirstUpdateOfNewFeature
+  bool isFirstUpdateOfNewFeature,
+  QSet<int> *changedFields
 )
 {
   // update default values for fields which are not in the form
@@ -742,16 +952,18 @@ void AttributeController::recalculateDefaultValues(
 
     bool shouldApplyDefaultValue =
       !defaultDefinition.expression().isEmpty() &&
-      ( isFirstUpdateOfNewFeature || ( isFormValueChange && defaultDefinition.applyOnUpdate() ) );
+      ( isFirstUpdateOfNewFeature || ( isFormValueChange && defaultDefinition.applyOnUpdate() && dependsOn( mFieldDependencies.value( idx ), changedFields ) ) );
 
     if ( shouldApplyDefaultValue )
     {
-      evaluateExpressionAndUpdateValue( changedFormItems,
-                                        defaultDefinition.expression(),
-                                        expressionContext,
-                                        idx,
-                                        f,
-                                        nullptr );
+      bool changed = evaluateExpressionAndUpdateValue( changedFormItems,
+                     mDefaultValueExpressions[idx],
+                     expressionContext,
+                     idx,
+                     f,
+                     nullptr );
+      if ( changed && changedFields )
+        changedFields->insert( idx );
     }
   }
 
@@ -766,16 +978,18 @@ void AttributeController::recalculateDefaultValues(
 
     bool shouldApplyDefaultValue =
       !defaultDefinition.expression().isEmpty() &&
-      ( isFirstUpdateOfNewFeature || ( isFormValueChange && defaultDefinition.applyOnUpdate() ) );
+      ( isFirstUpdateOfNewFeature || ( isFormValueChange && defaultDefinition.applyOnUpdate() && dependsOn( mFieldDependencies.value( item->fieldIndex() ), changedFields ) ) );
 
     if ( shouldApplyDefaultValue )
     {
-      evaluateExpressionAndUpdateValue( changedFormItems,
-                                        defaultDefinition.expression(),
-                                        expressionContext,
-                                        item->fieldIndex(),
-                                        field,
-                                        item );
+      bool changed = evaluateExpressionAndUpdateValue( changedFormItems,
+                     mDefaultValueExpressions[item->fieldIndex()],
+                     expressionContext,
+                     item->fieldIndex(),
+                     field,
+                     item );
+      if ( changed && changedFields )
+        changedFields->insert( item->fieldIndex() );
     }
 
     if ( isFirstUpdateOfNewFeature )
@@ -807,19 +1021,23 @@ void AttributeController::recalculateDefaultValues(
   }
 }
 
-void AttributeController::recalculateVirtualFields( QSet<QUuid> &changedFormItems, QgsExpressionContext &expressionContext )
+void AttributeController::recalculateVirtualFields( QSet<QUuid> &changedFormItems, QgsExpressionContext &expressionContext, QSet<int> *changedFields )
 {
   // update default values for fields which are not in the form
   for ( const int idx : mVirtualFieldsOutsideForm )
   {
+    if ( !dependsOn( mFieldDependencies.value( idx ), changedFields ) )
+      continue;
+
     QgsField f = mFeatureLayerPair.layer()->fields().at( idx );
-    QString expressionString = mFeatureLayerPair.layer()->expressionField( idx );
-    evaluateExpressionAndUpdateValue( changedFormItems,
-                                      expressionString,
-                                      expressionContext,
-                                      idx,
-                                      f,
-                                      nullptr );
+    bool changed = evaluateExpressionAndUpdateValue( changedFormItems,
+                   mVirtualFieldExpressions[idx],
+                   expressionContext,
+                   idx,
+                   f,
+                   nullptr );
+    if ( changed && changedFields )
+      changedFields->insert( idx );
   }
 
   // evaluate virtual fields in the form
@@ -830,24 +1048,31 @@ void AttributeController::recalculateVirtualFields( QSet<QUuid> &changedFormItem
 
     const QgsField field = item->field();
 
-    if ( mFeatureLayerPair.layer()->fields().fieldOrigin( item->fieldIndex() ) == QgsFields::OriginExpression )
+    if ( mFeatureLayerPair.layer()->fields().fieldOrigin( item->fieldIndex() ) == QgsFields::OriginExpression &&
+         dependsOn( mFieldDependencies.value( item->fieldIndex() ), changedFields ) )
     {
-      QString expressionString = mFeatureLayerPair.layer()->expressionField( item->fieldIndex() );
-      evaluateExpressionAndUpdateValue( changedFormItems,
-                                        expressionString,
-                                        expressionContext,
-                                        item->fieldIndex(),
-                                        field,
-                                        item );
+      bool changed = evaluateExpressionAndUpdateValue( changedFormItems,
+                     mVirtualFieldExpressions[item->fieldIndex()],
+                     expressionContext,
+                     item->fieldIndex(),
+                     field,
+                     item );
+      if ( changed && changedFields )
+        changedFields->insert( item->fieldIndex() );
     }
     ++formItemsIterator;
   }
 }
 
-void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool isFirstUpdateOfNewFeature )
+void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool isFirstUpdateOfNewFeature, const QSet<int> &changedFields )
 {
   QSet<QUuid> changedFormItems;
 
+  // fields changed so far, grows as virtual fields and default values get updated;
+  // nullptr when everything needs to be recalculated
+  QSet<int> dirtyFields = changedFields;
+  QSet<int> *changedFieldsPtr = changedFields.isEmpty() ? nullptr : &dirtyFields;
+
   QgsVectorLayer *layer = mFeatureLayerPair.layer();
   if ( !layer || !layer->isValid() )
     return;
@@ -866,14 +1091,14 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
   expressionContext.setFeature( featureLayerPair().featureRef() );
 
   // Evaluate virtual fields
-  recalculateVirtualFields( changedFormItems, expressionContext );
+  recalculateVirtualFields( changedFormItems, expressionContext, changedFieldsPtr );
 
   // Evaluate default values
-  recalculateDefaultValues( changedFormItems, expressionContext, isFormValueChange, isFirstUpdateOfNewFeature );
+  recalculateDefaultValues( changedFormItems, expressionContext, isFormValueChange, isFirstUpdateOfNewFeature, changedFieldsPtr );
 
 
   // Evaluate HTML and Text element expressions
-  recalculateRichTextWidgets( changedFormItems, expressionContext );
+  recalculateRichTextWidgets( changedFormItems, expressionContext, changedFieldsPtr );
 
   // Evaluate tab items visiblity
   {
@@ -881,8 +1106,13 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
     while ( tabItemsIterator != mTabItems.end() )
     {
       std::shared_ptr<TabItem> item = *tabItemsIterator;
-      QgsExpression exp = item->visibilityExpression();
-      exp.prepare( &expressionContext );
+      if ( !dependsOn( mTabItemDependencies.value( item->tabIndex() ), changedFieldsPtr ) )
+      {
+        ++tabItemsIterator;
+        continue;
+      }
+
+      QgsExpression &exp = item->visibilityExpressionRef();
       bool visible = true;
       if ( exp.isValid() )
       {
@@ -904,6 +1134,12 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
     while ( formItemsIterator != mFormItems.end() )
     {
       std::shared_ptr<FormItem> item = formItemsIterator.value();
+      if ( !dependsOn( mFormItemDependencies.value( item->id() ), changedFieldsPtr ) )
+      {
+        ++formItemsIterator;
+        continue;
+      }
+
       bool visible = true;
       if ( item->editorWidgetType() == QLatin1String( "Hidden" ) )
       {
@@ -911,8 +1147,7 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
       }
       else
       {
-        QgsExpression exp = item->visibilityExpression();
-        exp.prepare( &expressionContext );
+        QgsExpression &exp = item->visibilityExpressionRef();
 
         if ( exp.isValid() )
           visible = exp.evaluate( &expressionContext ).toInt();
@@ -933,12 +1168,11 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
     while ( formItemsIterator != mFormItems.end() )
     {
       std::shared_ptr<FormItem> item = formItemsIterator.value();
-      QgsExpression exp = item->editableExpression();
+      QgsExpression &exp = item->editableExpressionRef();
 
-      if ( !exp.expression().isEmpty() )
+      if ( !exp.expression().isEmpty() && dependsOn( mFormItemDependencies.value( item->id() ), changedFieldsPtr ) )
       {
         bool editable = item->isEditable();
-        exp.prepare( &expressionContext );
 
         if ( exp.isValid() )
         {
@@ -962,12 +1196,11 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
     while ( formItemsIterator != mFormItems.end() )
     {
       std::shared_ptr<FormItem> item = formItemsIterator.value();
-      QgsExpression exp = item->nameExpression();
+      QgsExpression &exp = item->nameExpressionRef();
 
-      if ( !exp.expression().isEmpty() )
+      if ( !exp.expression().isEmpty() && dependsOn( mFormItemDependencies.value( item->id() ), changedFieldsPtr ) )
       {
         QString name = item->name();
-        exp.prepare( &expressionContext );
 
         if ( exp.isValid() )
         {
@@ -993,25 +1226,26 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
       while ( formItemsIterator != mFormItems.end() )
       {
         std::shared_ptr<FormItem> item = formItemsIterator.value();
-        if ( item->type() == FormItem::Field )
+        if ( item->type() == FormItem::Field && dependsOn( mFormItemDependencies.value( item->id() ), changedFieldsPtr ) )
         {
           QString validationMessage;
           FieldValidator::ValidationStatus validationStatus;
 
           validationStatus = FieldValidator::validate( featureLayerPair(), *item, validationMessage );
 
-          if ( validationStatus == FieldValidator::Error )
-          {
-            containsValidationError = true;
-          }
-
-          if ( validationMessage != item->validationMessage() )
+          if ( validationMessage != item->validationMessage() || validationStatus != item->validationStatus() )
           {
             item->setValidationStatus( validationStatus );
             item->setValidationMessage( validationMessage );
             changedFormItems.insert( item->id() );
           }
         }
+
+        // items which were not validated again keep their status
+        if ( item->type() == FormItem::Field && item->validationStatus() == FieldValidator::Error )
+        {
+          containsValidationError = true;
+        }
         ++formItemsIterator;
       }
     }
@@ -1052,51 +1286,16 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
     emit formRecalculated();
 }
 
-void AttributeController::recalculateRichTextWidgets( QSet<QUuid> &changedFormItems, QgsExpressionContext &context )
+void AttributeController::recalculateRichTextWidgets( QSet<QUuid> &changedFormItems, QgsExpressionContext &context, const QSet<int> *changedFields )
 {
   QMap<QUuid, std::shared_ptr<FormItem>>::iterator formItemsIterator = mFormItems.begin();
   while ( formItemsIterator != mFormItems.end() )
   {
     std::shared_ptr<FormItem> itemData = formItemsIterator.value();
-    if ( itemData->type() == FormItem::RichText )
+    if ( itemData->type() == FormItem::RichText && dependsOn( mFormItemDependencies.value( itemData->id() ), changedFields ) )
     {
-      QString newValue;
-      QString definition = itemData->editorWidgetConfig().value( QStringLiteral( "Definition" ) ).toString();
-      bool isHTML = itemData->editorWidgetConfig().value( QStringLiteral( "UseHtml" ) ).toBool();
-      if ( isHTML )
-      {
-        // evaluate texts like: <script>document.write(expression.evaluate("\TextField\""));</script>
-
-        // QML Text does not support document.write, so just remove it
-        const thread_local QRegularExpression sRegEx1( "<script>\\s*document\\.write\\(\\s*(.*)\\s*\\)\\s*;\\s*</script>", QRegularExpression::MultilineOption | QRegularExpression::DotMatchesEverythingOption );
-        QRegularExpressionMatch match1 = sRegEx1.match( definition );
-        while ( match1.hasMatch() )
-        {
-          QString expression = match1.captured( 1 );
-          definition = QStringLiteral( "<span>%1</span>" ).arg( definition.mid( 0, match1.capturedStart( 0 ) ) + expression + definition.mid( match1.capturedEnd( 0 ) ) );
-          match1 = sRegEx1.match( definition );
-        }
-
-        // Not evaluate expression with the engine
-        const thread_local QRegularExpression sRegEx( "expression\\.evaluate\\(\\s*\\\"(.*?[^\\\\])\\\"\\s*\\)", QRegularExpression::MultilineOption | QRegularExpression::DotMatchesEverythingOption );
-        QRegularExpressionMatch match = sRegEx.match( definition );
-        while ( match.hasMatch() )
-        {
-          QString expression = match.captured( 1 );
-          expression = expression.replace( QStringLiteral( "\\\"" ), QStringLiteral( "\"" ) );
-
-          QgsExpression exp = QgsExpression( expression );
-          exp.prepare( &context );
-          QString resultString = exp.evaluate( &context ).toString();
-          definition = definition.mid( 0, match.capturedStart( 0 ) ) + resultString + definition.mid( match.capturedEnd( 0 ) );
-          match = sRegEx.match( definition );
-        }
-        newValue = definition;
-      }
-      else
-      {
-        newValue = QgsExpression::replaceExpressionText( definition, &context );
-      }
+      // the text is parsed and its expressions prepared when the layer is loaded
+      const QString newValue = itemData->evaluateRichText( &context );
       if ( itemData->rawValue() != newValue )
       {
         changedFormItems.insert( itemData->id() );
@@ -1105,7 +1304,6 @@ void AttributeController::recalculateRichTextWidgets( QSet<QUuid> &changedFormIt
     }
     ++formItemsIterator;
   }
-
 }
 
 bool AttributeController::hasValidationErrors() const
@@ -1471,7 +1669,7 @@ bool AttributeController::setFormValue( const QUuid &id, QVariant value )
       mFeatureLayerPair.featureRef().setAttribute( item->fieldIndex(), val );
       emit formDataChanged( item->id(), { AttributeFormModel::AttributeValue, AttributeFormModel::RawValueIsNull } );
     }
-    recalculateDerivedItems( true, false );
+    recalculateDerivedItems( true, false, { item->fieldIndex() } );
     return true;
   }
   else
@@ -21,6 +21,8 @@
 #include <QVariant>
 #include <memory>
 #include <QMap>
+#include <QHash>
+#include <QSet>
 #include <QVector>
 #include <QUuid>
 
@@ -29,6 +31,7 @@
 #include "attributedata.h"
 #include "attributeformproxymodel.h"
 #include "attributetabproxymodel.h"
+#include "attributeformtemplate.h"
 #include "rememberattributescontroller.h"
 
 #include "qgsfeature.h"
@@ -184,6 +187,13 @@ class  AttributeController : public QObject
     void updateOnLayerChange();
     void updateOnFeatureChange();
 
+    //! Parses form configuration of the layer into tabs and form items, prepares their expressions and dependencies
+    void createFormLayout();
+
+    //! Returns the parsed form layout, see AttributeFormTemplate
+    AttributeFormTemplate::Layout formLayout() const;
+    void setFormLayout( const AttributeFormTemplate::Layout &layout );
+
     bool isNewFeature() const;
 
     /**
@@ -191,13 +201,39 @@ class  AttributeController : public QObject
      * Note that reevaluate default values is needed only when an attribnute has changed.
      * Evaluation of default values for a new feature is done in digitizing controller when a feature is created.
      * @param isFormValueChange True if recalculation has to be done after an attribute has changed (called by setFormValue function).
+     * @param changedFields Indices of changed fields, only items depending on them are recalculated. Everything is recalculated if empty.
+     */
+    void recalculateDerivedItems( bool isFormValueChange = false, bool isFirstUpdateOfNewFeature = false, const QSet<int> &changedFields = QSet<int>() );
+
+    // changedFields is nullptr for full recalculation, otherwise fields with updated values are added to it
+    void recalculateRichTextWidgets( QSet<QUuid> &changedFormItems, QgsExpressionContext &context, const QSet<int> *changedFields = nullptr );
+    void recalculateDefaultValues( QSet<QUuid> &changedFormItems, QgsExpressionContext &context, bool isFormValueChange = false, bool isFirstUpdateOfNewFeature = false, QSet<int> *changedFields = nullptr );
+    void recalculateVirtualFields( QSet<QUuid> &changedFormItems, QgsExpressionContext &expressionContext, QSet<int> *changedFields = nullptr );
+
+    //! Evaluates prepared expression \a exp, returns true if the value of the field has changed
+    bool evaluateExpressionAndUpdateValue( QSet<QUuid> &changedFormItems,
+                                           QgsExpression &exp, QgsExpressionContext &expressionContext, int fieldIndex, const QgsField &field, std::shared_ptr<FormItem> formItem );
+
+    /**
+     * Prepares expressions of form items, tabs, default values and virtual fields once per layer,
+     * recalculation then only evaluates them with the current feature.
+     * Form and position scopes are left out of the preparation, their variables must not be evaluated as static.
+     * Global and project variables are static for the preparation, expressions are prepared again when they change.
+     */
+    void prepareExpressions();
+
+    /**
+     * Builds the dependency graph of the form - indices of fields referenced by virtual field and default value
+     * expressions and by expressions of form items and tabs. A form value change then recalculates only what depends on it.
      */
-    void recalculateDerivedItems( bool isFormValueChange = false, bool isFirstUpdateOfNewFeature = false );
-    void recalculateRichTextWidgets( QSet<QUuid> &changedFormItems, QgsExpressionContext &context );
-    void recalculateDefaultValues( QSet<QUuid> &changedFormItems, QgsExpressionContext &context, bool isFormValueChange = false, bool isFirstUpdateOfNewFeature = false );
-    void recalculateVirtualFields( QSet<QUuid> &changedFormItems, QgsExpressionContext &expressionContext );
-    void evaluateExpressionAndUpdateValue( QSet<QUuid> &changedFormItems,
-                                           const QString &expressionString, QgsExpressionContext &expressionContext, int fieldIndex, const QgsField &field, std::shared_ptr<FormItem> formItem );
+    void buildDependencyGraph();
+
+    //! Returns indices of fields referenced by the \a expression, contains ANY_FIELD if it may depend on any field
+    QSet<int> referencedFields( const QString &expression ) const;
+
+    //! Returns true if \a dependencies need to be recalculated after \a changedFields have changed (nullptr means everything changed)
+    static bool dependsOn( const QSet<int> &dependencies, const QSet<int> *changedFields );
+
 
     // generate tab
     void createTab( QgsAttributeEditorContainer *container );
@@ -245,5 +281,17 @@ class  AttributeController : public QObject
 
     AttributeController *mParentController = nullptr; // not owned
     QgsRelation mLinkedRelation;
+
+    // dependency graph of the form, see buildDependencyGraph()
+    static constexpr int ANY_FIELD = -1;
+    QHash<int, QSet<int>> mFieldDependencies; // field index -> fields referenced by its virtual field or default value expression
+    QHash<QUuid, QSet<int>> mFormItemDependencies; // form item -> fields referenced by its expressions and constraints
+    QVector<QSet<int>> mTabItemDependencies; // tab row -> fields referenced by its visibility expression
+
+    // prepared expressions of fields, see prepareExpressions()
+    QHash<int, QgsExpression> mDefaultValueExpressions; // field index -> default value expression
+    QHash<int, QgsExpression> mVirtualFieldExpressions; // field index -> virtual field expression
+
+    friend class TestAttributeController;
 };
 #endif // ATTRIBUTECONTROLLER_H
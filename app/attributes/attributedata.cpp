@@ -16,6 +16,10 @@
 
 #include "attributedata.h"
 
+#include "qgsexpressioncontext.h"
+
+#include <QRegularExpression>
+
 FormItem::FormItem( const QUuid &id,
                     const QgsField &field,
                     const QString &groupName,
@@ -174,9 +178,122 @@ FormItem *FormItem::createRichTextItem(
   );
 
   fi->setRawValue( text );
+  fi->parseRichText( text, isHtml );
   return fi;
 }
 
+void FormItem::parseRichText( const QString &text, bool isHtml )
+{
+  mRichTextParts.clear();
+  mRichTextIsHtml = isHtml;
+
+  QString definition = text;
+  QRegularExpression regEx;
+
+  if ( isHtml )
+  {
+    // evaluate texts like: <script>document.write(expression.evaluate("\TextField\""));</script>
+
+    // QML Text does not support document.write, so just remove it
+    const thread_local QRegularExpression sRegEx1( "<script>\\s*document\\.write\\(\\s*(.*)\\s*\\)\\s*;\\s*</script>", QRegularExpression::MultilineOption | QRegularExpression::DotMatchesEverythingOption );
+    QRegularExpressionMatch match1 = sRegEx1.match( definition );
+    while ( match1.hasMatch() )
+    {
+      QString expression = match1.captured( 1 );
+      definition = QStringLiteral( "<span>%1</span>" ).arg( definition.mid( 0, match1.capturedStart( 0 ) ) + expression + definition.mid( match1.capturedEnd( 0 ) ) );
+      match1 = sRegEx1.match( definition );
+    }
+
+    const thread_local QRegularExpression sRegEx( "expression\\.evaluate\\(\\s*\\\"(.*?[^\\\\])\\\"\\s*\\)", QRegularExpression::MultilineOption | QRegularExpression::DotMatchesEverythingOption );
+    regEx = sRegEx;
+  }
+  else
+  {
+    // evaluate texts like: [% "TextField" %], same as QgsExpression::replaceExpressionText()
+    const thread_local QRegularExpression sRegEx( "\\[%(.*?)%\\]", QRegularExpression::MultilineOption | QRegularExpression::DotMatchesEverythingOption );
+    regEx = sRegEx;
+  }
+
+  int position = 0;
+  QRegularExpressionMatchIterator it = regEx.globalMatch( definition );
+  while ( it.hasNext() )
+  {
+    const QRegularExpressionMatch match = it.next();
+
+    QString expression = match.captured( 1 );
+    if ( isHtml )
+      expression.replace( QStringLiteral( "\\\"" ), QStringLiteral( "\"" ) );
+    else
+      expression = expression.trimmed();
+
+    if ( !isHtml && expression.isEmpty() )
+    {
+      // nothing to evaluate, QgsExpression::replaceExpressionText() keeps the text as it is
+      continue;
+    }
+
+    RichTextPart part;
+    part.text = definition.mid( position, match.capturedStart( 0 ) - position );
+    part.expressionText = match.captured( 0 );
+    part.expression = QgsExpression( expression );
+    mRichTextParts << part;
+
+    position = match.capturedEnd( 0 );
+  }
+
+  mRichTextTail = definition.mid( position );
+}
+
+void FormItem::prepareExpressions( const QgsExpressionContext *context )
+{
+  if ( !mVisibilityExpression.expression().isEmpty() )
+    mVisibilityExpression.prepare( context );
+
+  if ( !mNameExpression.expression().isEmpty() )
+    mNameExpression.prepare( context );
+
+  if ( !mEditableExpression.expression().isEmpty() )
+    mEditableExpression.prepare( context );
+
+  for ( RichTextPart &part : mRichTextParts )
+  {
+    part.expression.prepare( context );
+  }
+}
+
+QStringList FormItem::richTextExpressions() const
+{
+  QStringList expressions;
+  for ( const RichTextPart &part : mRichTextParts )
+  {
+    expressions << part.expression.expression();
+  }
+  return expressions;
+}
+
+QString FormItem::evaluateRichText( QgsExpressionContext *context )
+{
+  QString result;
+
+  for ( RichTextPart &part : mRichTextParts )
+  {
+    result += part.text;
+
+    const QVariant value = part.expression.evaluate( context );
+    if ( !mRichTextIsHtml && ( part.expression.hasParserError() || part.expression.hasEvalError() ) )
+    {
+      // keep the original text, like QgsExpression::replaceExpressionText() does
+      result += part.expressionText;
+    }
+    else if ( !value.isNull() )
+    {
+      result += value.toString();
+    }
+  }
+
+  return result + mRichTextTail;
+}
+
 FormItem::FormItemType FormItem::type() const
 {
   return mType;
@@ -275,6 +392,21 @@ QgsExpression FormItem::editableExpression() const
   return mEditableExpression;
 }
 
+QgsExpression &FormItem::visibilityExpressionRef()
+{
+  return mVisibilityExpression;
+}
+
+QgsExpression &FormItem::nameExpressionRef()
+{
+  return mNameExpression;
+}
+
+QgsExpression &FormItem::editableExpressionRef()
+{
+  return mEditableExpression;
+}
+
 bool FormItem::visible() const
 {
   return mVisible;
@@ -357,6 +489,17 @@ QgsExpression TabItem::visibilityExpression() const
   return mVisibilityExpression;
 }
 
+void TabItem::prepareExpressions( const QgsExpressionContext *context )
+{
+  if ( !mVisibilityExpression.expression().isEmpty() )
+    mVisibilityExpression.prepare( context );
+}
+
+QgsExpression &TabItem::visibilityExpressionRef()
+{
+  return mVisibilityExpression;
+}
+
 const QVector<QUuid> TabItem::formItems() const
 {
   return mFormItems;
@@ -141,6 +141,23 @@ class FormItem
     QgsExpression nameExpression() const;
     QgsExpression editableExpression() const;
 
+    /**
+     * Prepares visibility, name, editability and rich text expressions for evaluation with contexts
+     * created from the same layer. Prepared expressions are then only evaluated with a new feature.
+     */
+    void prepareExpressions( const QgsExpressionContext *context );
+
+    // prepared expressions for evaluation, see prepareExpressions()
+    QgsExpression &visibilityExpressionRef();
+    QgsExpression &nameExpressionRef();
+    QgsExpression &editableExpressionRef();
+
+    //! Returns texts of the expressions of the rich text widget
+    QStringList richTextExpressions() const;
+
+    //! Evaluates prepared expressions of the rich text widget and returns the resulting text
+    QString evaluateRichText( QgsExpressionContext *context );
+
     bool visible() const;
 
     QgsField field() const;
@@ -160,6 +177,17 @@ class FormItem
 
   private:
 
+    //! Splits text or HTML of a rich text widget into literal texts and expressions
+    void parseRichText( const QString &text, bool isHtml );
+
+    //! Literal text of a rich text widget followed by an expression
+    struct RichTextPart
+    {
+      QString text;
+      QString expressionText; //!< matched expression including its delimiters, kept in text widgets if the expression fails
+      QgsExpression expression;
+    };
+
     const QUuid mId;
     const QgsField mField;
     const QString mGroupName; //empty for no group, group/tab name if widget is in container
@@ -168,9 +196,13 @@ class FormItem
     const bool mShowName = true; // "Show label" in Widget Display group in QGIS widget settings
     const QgsEditorWidgetSetup mEditorWidgetSetup;
     const int mFieldIndex;
-    const QgsExpression mVisibilityExpression;
-    const QgsExpression mNameExpression; // Expression to define field’s display name (alias)
-    const QgsExpression mEditableExpression; // Expression to determine whether the field is editable
+    QgsExpression mVisibilityExpression;
+    QgsExpression mNameExpression; // Expression to define field’s display name (alias)
+    QgsExpression mEditableExpression; // Expression to determine whether the field is editable
+
+    QVector<RichTextPart> mRichTextParts; // Only used for FormItemType::RichText
+    QString mRichTextTail; // text after the last expression
+    bool mRichTextIsHtml = false;
 
     QString mName;
     QString mValidationMessage;
@@ -202,11 +234,15 @@ class  TabItem
 
     QgsExpression visibilityExpression() const;
 
+    //! Prepares the visibility expression, see FormItem::prepareExpressions()
+    void prepareExpressions( const QgsExpressionContext *context );
+    QgsExpression &visibilityExpressionRef();
+
   private:
     const int mTabIndex;
     const QString mName;
     const QVector<QUuid> mFormItems;
-    const QgsExpression mVisibilityExpression;
+    QgsExpression mVisibilityExpression;
     bool mVisible = false;
 };
 
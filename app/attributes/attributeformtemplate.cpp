@@ -0,0 +1,85 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "attributeformtemplate.h"
+
+#include "qgsapplication.h"
+#include "qgsproject.h"
+#include "qgsrelationmanager.h"
+#include "qgsvectorlayer.h"
+
+AttributeFormTemplate *AttributeFormTemplate::forLayer( QgsVectorLayer *layer )
+{
+  if ( !layer )
+    return nullptr;
+
+  AttributeFormTemplate *formTemplate = layer->findChild<AttributeFormTemplate *>( QString(), Qt::FindDirectChildrenOnly );
+  if ( !formTemplate )
+  {
+    formTemplate = new AttributeFormTemplate( layer );
+  }
+  return formTemplate;
+}
+
+AttributeFormTemplate::AttributeFormTemplate( QgsVectorLayer *layer )
+  : QObject( layer )
+{
+  connect( layer, &QgsVectorLayer::editFormConfigChanged, this, &AttributeFormTemplate::invalidate );
+  connect( layer, &QgsVectorLayer::updatedFields, this, &AttributeFormTemplate::invalidate );
+
+  // relation widgets and relation references are discovered from the project relations
+  QgsRelationManager *relationManager = QgsProject::instance()->relationManager();
+  connect( relationManager, &QgsRelationManager::changed, this, &AttributeFormTemplate::invalidate );
+  connect( relationManager, &QgsRelationManager::relationsLoaded, this, &AttributeFormTemplate::invalidate );
+
+  // global and project variables are static for the preparation of expressions, e.g. @mergin_username
+  // set by VariablesManager after sign in would stay in the prepared default values
+  connect( QgsApplication::instance(), &QgsApplication::customVariablesChanged, this, &AttributeFormTemplate::invalidate );
+  connect( QgsProject::instance(), &QgsProject::customVariablesChanged, this, &AttributeFormTemplate::invalidate );
+}
+
+bool AttributeFormTemplate::hasLayout() const
+{
+  return mHasLayout;
+}
+
+AttributeFormTemplate::Layout AttributeFormTemplate::cloneLayout() const
+{
+  return copyLayout( mLayout );
+}
+
+void AttributeFormTemplate::setLayout( const Layout &layout )
+{
+  mLayout = copyLayout( layout );
+  mHasLayout = true;
+}
+
+void AttributeFormTemplate::invalidate()
+{
+  mLayout = Layout();
+  mHasLayout = false;
+}
+
+AttributeFormTemplate::Layout AttributeFormTemplate::copyLayout( const Layout &layout )
+{
+  // prepared expressions are implicitly shared by the copies, only feature values differ
+  Layout copy = layout;
+
+  for ( auto it = copy.formItems.begin(); it != copy.formItems.end(); ++it )
+  {
+    it.value() = std::make_shared<FormItem>( *it.value() );
+  }
+
+  for ( std::shared_ptr<TabItem> &tab : copy.tabItems )
+  {
+    tab = std::make_shared<TabItem>( *tab );
+  }
+
+  return copy;
+}
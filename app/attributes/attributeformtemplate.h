@@ -0,0 +1,81 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ATTRIBUTEFORMTEMPLATE_H
+#define ATTRIBUTEFORMTEMPLATE_H
+
+#include <QObject>
+#include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QUuid>
+#include <memory>
+
+#include "inputconfig.h"
+#include "attributedata.h"
+
+#include "qgsexpression.h"
+
+class QgsVectorLayer;
+
+/**
+ * Form layout of a vector layer - tabs, form items with prepared expressions and their dependencies - as parsed
+ * by AttributeController from the layer's form configuration. The first form opened for a layer stores its layout
+ * here, following forms only clone it and bind their feature values.
+ *
+ * The template is owned by the layer (use forLayer() to get it) and it is dropped whenever the form configuration,
+ * fields, relations or global and project variables change.
+ */
+class AttributeFormTemplate : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    struct Layout
+    {
+      QMap<QUuid, std::shared_ptr<FormItem>> formItems;
+      QVector<std::shared_ptr<TabItem>> tabItems;
+      bool hasTabs = false;
+      QSet<int> expressionFieldsOutsideForm;
+      QSet<int> virtualFieldsOutsideForm;
+      QHash<int, QSet<int>> fieldDependencies;
+      QHash<QUuid, QSet<int>> formItemDependencies;
+      QVector<QSet<int>> tabItemDependencies;
+      QHash<int, QgsExpression> defaultValueExpressions;
+      QHash<int, QgsExpression> virtualFieldExpressions;
+    };
+
+    //! Returns form template of the \a layer, creates an empty one if it does not exist yet
+    static AttributeFormTemplate *forLayer( QgsVectorLayer *layer );
+
+    //! Returns true if a layout is stored and it is still up to date with the layer
+    bool hasLayout() const;
+
+    //! Returns a copy of the stored layout, items of the copy can be modified by the caller
+    Layout cloneLayout() const;
+
+    //! Stores a copy of the \a layout, it must not have any feature values bound yet
+    void setLayout( const Layout &layout );
+
+  private slots:
+    void invalidate();
+
+  private:
+    explicit AttributeFormTemplate( QgsVectorLayer *layer );
+
+    //! Returns copy of the \a layout with copies of all form and tab items
+    static Layout copyLayout( const Layout &layout );
+
+    Layout mLayout;
+    bool mHasLayout = false;
+};
+
+#endif // ATTRIBUTEFORMTEMPLATE_H
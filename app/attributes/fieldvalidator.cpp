@@ -10,8 +10,10 @@
 #include "fieldvalidator.h"
 #include "attributedata.h"
 #include "featurelayerpair.h"
+#include "uniquevaluesindex.h"
 
 #include "qgsfield.h"
+#include "qgsvectordataprovider.h"
 #include "qgsvectorlayerutils.h"
 
 #include <QRegularExpression>
@@ -57,7 +59,16 @@ FieldValidator::ValidationStatus FieldValidator::validate( const FeatureLayerPai
   // Continue to check hard and soft QGIS constraints
   QStringList errors;
 
-  bool hardConstraintSatisfied = QgsVectorLayerUtils::validateAttribute( pair.layer(),  pair.feature(), item.fieldIndex(), errors, QgsFieldConstraints::ConstraintStrengthHard );
+  // unique values are looked up in memory once the index of the field is built
+  const UniqueValuesIndex *uniqueIndex = nullptr;
+  if ( field.constraints().constraints() & QgsFieldConstraints::ConstraintUnique )
+  {
+    uniqueIndex = UniqueValuesIndex::forField( pair.layer(), item.fieldIndex() );
+    if ( uniqueIndex && !uniqueIndex->isReady() )
+      uniqueIndex = nullptr;
+  }
+
+  bool hardConstraintSatisfied = validateConstraints( pair, item.fieldIndex(), errors, QgsFieldConstraints::ConstraintStrengthHard, uniqueIndex );
   if ( !hardConstraintSatisfied )
   {
     validationMessage = constructConstraintValidationMessage( item, errors );
@@ -66,7 +77,7 @@ FieldValidator::ValidationStatus FieldValidator::validate( const FeatureLayerPai
 
   errors.clear();
 
-  bool softConstraintSatisfied = QgsVectorLayerUtils::validateAttribute( pair.layer(),  pair.feature(), item.fieldIndex(), errors, QgsFieldConstraints::ConstraintStrengthSoft );
+  bool softConstraintSatisfied = validateConstraints( pair, item.fieldIndex(), errors, QgsFieldConstraints::ConstraintStrengthSoft, uniqueIndex );
   if ( !softConstraintSatisfied )
   {
     validationMessage = constructConstraintValidationMessage( item, errors );
@@ -184,6 +195,55 @@ FieldValidator::ValidationStatus FieldValidator::validateGenericField( const For
   return Valid;
 }
 
+bool FieldValidator::validateConstraints( const FeatureLayerPair &pair, int fieldIndex, QStringList &errors, QgsFieldConstraints::ConstraintStrength strength, const UniqueValuesIndex *uniqueIndex )
+{
+  QgsVectorLayer *layer = pair.layer();
+  const QgsFields fields = layer->fields();
+  const QgsFieldConstraints constraints = fields.at( fieldIndex ).constraints();
+  const QVariant value = pair.feature().attribute( fieldIndex );
+
+  if ( !uniqueIndex || value.isNull() ||
+       !( constraints.constraints() & QgsFieldConstraints::ConstraintUnique ) ||
+       constraints.constraintStrength( QgsFieldConstraints::ConstraintUnique ) != strength )
+  {
+    return QgsVectorLayerUtils::validateAttribute( layer, pair.feature(), fieldIndex, errors, strength );
+  }
+
+  // QgsVectorLayerUtils::validateAttribute() checks constraints of a single origin when asked to,
+  // so constraints of the other origin are left to it and only the unique one is looked up in the index
+  const QgsFieldConstraints::ConstraintOrigin uniqueOrigin = constraints.constraintOrigin( QgsFieldConstraints::ConstraintUnique );
+  const QgsFieldConstraints::ConstraintOrigin otherOrigin = uniqueOrigin == QgsFieldConstraints::ConstraintOriginProvider ?
+      QgsFieldConstraints::ConstraintOriginLayer : QgsFieldConstraints::ConstraintOriginProvider;
+
+  bool valid = QgsVectorLayerUtils::validateAttribute( layer, pair.feature(), fieldIndex, errors, strength, otherOrigin );
+
+  // NOT NULL is met by a non-NULL value, but an expression sharing the origin with the unique constraint
+  // can not be checked separately - QGIS then checks that origin including the unique constraint
+  const bool hasExpression = constraints.constraints() & QgsFieldConstraints::ConstraintExpression &&
+                             !constraints.constraintExpression().isEmpty() &&
+                             constraints.constraintStrength( QgsFieldConstraints::ConstraintExpression ) == strength &&
+                             constraints.constraintOrigin( QgsFieldConstraints::ConstraintExpression ) == uniqueOrigin;
+  if ( hasExpression )
+  {
+    return QgsVectorLayerUtils::validateAttribute( layer, pair.feature(), fieldIndex, errors, strength, uniqueOrigin ) && valid;
+  }
+
+  if ( uniqueOrigin == QgsFieldConstraints::ConstraintOriginProvider &&
+       layer->dataProvider()->skipConstraintCheck( fields.fieldOriginIndex( fieldIndex ), QgsFieldConstraints::ConstraintUnique, value ) )
+  {
+    return valid;
+  }
+
+  if ( uniqueIndex->valueExists( value, pair.feature().id() ) )
+  {
+    // same text as QgsVectorLayerUtils::validateAttribute(), see constructConstraintValidationMessage()
+    errors << QStringLiteral( "value is not unique" );
+    valid = false;
+  }
+
+  return valid;
+}
+
 QString FieldValidator::constructConstraintValidationMessage( const FormItem &item, const QStringList &unmetConstraints )
 {
   /* BEWARE: this method uses QStringList of errors coming from QGIS validation function
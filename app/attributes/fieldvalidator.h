@@ -16,8 +16,11 @@
 
 #include "inputconfig.h"
 
+#include "qgsfieldconstraints.h"
+
 class FormItem;
 class FeatureLayerPair;
+class UniqueValuesIndex;
 
 class FieldValidator : public QObject
 {
@@ -51,6 +54,12 @@ class FieldValidator : public QObject
 
   private:
     static QString constructConstraintValidationMessage( const FormItem &item, const QStringList &unmetConstraints );
+
+    /**
+     * Checks QGIS constraints of the \a strength with QgsVectorLayerUtils::validateAttribute(), but unique constraint
+     * of a non-NULL value is looked up in the in-memory \a uniqueIndex (when set) instead of querying the data provider.
+     */
+    static bool validateConstraints( const FeatureLayerPair &pair, int fieldIndex, QStringList &errors, QgsFieldConstraints::ConstraintStrength strength, const UniqueValuesIndex *uniqueIndex );
 };
 
 namespace ValidationTexts
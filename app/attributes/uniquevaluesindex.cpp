@@ -0,0 +1,280 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "uniquevaluesindex.h"
+#include "coreutils.h"
+
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayereditbuffer.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+UniqueValuesIndex *UniqueValuesIndex::forField( QgsVectorLayer *layer, int fieldIndex )
+{
+  if ( !layer || !layer->isValid() || fieldIndex < 0 || fieldIndex >= layer->fields().count() )
+    return nullptr;
+
+  // values of virtual and joined fields are not in the provider
+  if ( layer->fields().fieldOrigin( fieldIndex ) != QgsFields::OriginProvider )
+    return nullptr;
+
+  const QString fieldName = layer->fields().at( fieldIndex ).name();
+
+  const QList<UniqueValuesIndex *> indexes = layer->findChildren<UniqueValuesIndex *>( QString(), Qt::FindDirectChildrenOnly );
+  for ( UniqueValuesIndex *index : indexes )
+  {
+    if ( index->mFieldName == fieldName )
+      return index;
+  }
+
+  return new UniqueValuesIndex( layer, fieldName );
+}
+
+UniqueValuesIndex::UniqueValuesIndex( QgsVectorLayer *layer, const QString &fieldName )
+  : QObject( layer )
+  , mLayer( layer )
+  , mFieldName( fieldName )
+{
+  connect( &mBuildWatcher, &QFutureWatcher<QHash<QgsFeatureId, ValueKey>>::finished, this, &UniqueValuesIndex::onBuildFinished );
+
+  // only committed values are indexed, the edit buffer is merged in when a value is looked up
+  connect( mLayer, &QgsVectorLayer::committedFeaturesAdded, this, &UniqueValuesIndex::onCommittedFeaturesAdded );
+  connect( mLayer, &QgsVectorLayer::committedFeaturesRemoved, this, &UniqueValuesIndex::onCommittedFeaturesRemoved );
+  connect( mLayer, &QgsVectorLayer::committedAttributeValuesChanges, this, &UniqueValuesIndex::onCommittedAttributeValuesChanges );
+  connect( mLayer, &QgsVectorLayer::updatedFields, this, &UniqueValuesIndex::rebuild );
+
+  rebuild();
+}
+
+UniqueValuesIndex::~UniqueValuesIndex()
+{
+  // the worker owns its feature source, it finishes on its own without blocking the UI thread
+  cancelBuild();
+}
+
+bool UniqueValuesIndex::isReady() const
+{
+  return mIsReady;
+}
+
+bool UniqueValuesIndex::valueExists( const QVariant &value, QgsFeatureId ignoredFeature ) const
+{
+  if ( value.isNull() )
+    return false;
+
+  const ValueKey key = valueKey( value, mField );
+  int count = mValueCounts.value( key );
+
+  if ( hasCommittedValue( ignoredFeature, key ) )
+    count--;
+
+  // QgsVectorLayerUtils::valueExists() sees the uncommitted edits too
+  const QgsVectorLayerEditBuffer *editBuffer = mLayer->editBuffer();
+  if ( editBuffer )
+  {
+    const int fieldIndex = mLayer->fields().indexOf( mFieldName );
+    const QgsFeatureIds deletedFeatures = editBuffer->deletedFeatureIds();
+    for ( QgsFeatureId fid : deletedFeatures )
+    {
+      if ( fid != ignoredFeature && hasCommittedValue( fid, key ) )
+        count--;
+    }
+
+    const QgsChangedAttributesMap changedValues = editBuffer->changedAttributeValues();
+    for ( auto it = changedValues.constBegin(); it != changedValues.constEnd(); ++it )
+    {
+      if ( it.key() == ignoredFeature || deletedFeatures.contains( it.key() ) || !it.value().contains( fieldIndex ) )
+        continue;
+
+      if ( hasCommittedValue( it.key(), key ) )
+        count--;
+
+      const QVariant changedValue = it.value().value( fieldIndex );
+      if ( !changedValue.isNull() && valueKey( changedValue, mField ) == key )
+        count++;
+    }
+
+    const QgsFeatureMap addedFeatures = editBuffer->addedFeatures();
+    for ( auto it = addedFeatures.constBegin(); it != addedFeatures.constEnd(); ++it )
+    {
+      const QVariant addedValue = it.value().attribute( fieldIndex );
+      if ( it.key() != ignoredFeature && !addedValue.isNull() && valueKey( addedValue, mField ) == key )
+        count++;
+    }
+  }
+
+  return count > 0;
+}
+
+bool UniqueValuesIndex::hasCommittedValue( QgsFeatureId fid, const ValueKey &key ) const
+{
+  auto it = mFeatureValues.constFind( fid );
+  return it != mFeatureValues.constEnd() && it.value() == key;
+}
+
+UniqueValuesIndex::ValueKey UniqueValuesIndex::valueKey( const QVariant &value, const QgsField &field )
+{
+  // values read from the provider, typed in the form and stored in the edit buffer may differ in type
+  QVariant converted = value;
+  if ( !field.convertCompatible( converted ) )
+    converted = value;
+
+  return ValueKey( converted.userType(), converted.toString() );
+}
+
+void UniqueValuesIndex::rebuild()
+{
+  mIsReady = false;
+  cancelBuild();
+
+  const int fieldIndex = mLayer->fields().indexOf( mFieldName );
+  if ( fieldIndex < 0 || mLayer->fields().fieldOrigin( fieldIndex ) != QgsFields::OriginProvider )
+    return; // the field is gone, the index stays not ready
+
+  mField = mLayer->fields().at( fieldIndex );
+  mBuildCanceled = std::make_shared<std::atomic_bool>( false );
+
+  // committed values only, the feature source of the layer would include the edit buffer
+  QgsAbstractFeatureSource *source = mLayer->dataProvider()->featureSource();
+  mBuildWatcher.setFuture( QtConcurrent::run( &UniqueValuesIndex::readValues, source, mLayer->fields().fieldOriginIndex( fieldIndex ), mField, mBuildCanceled ) );
+}
+
+void UniqueValuesIndex::cancelBuild()
+{
+  if ( mBuildCanceled )
+    *mBuildCanceled = true;
+}
+
+void UniqueValuesIndex::onBuildFinished()
+{
+  if ( mBuildWatcher.isCanceled() || !mBuildCanceled || *mBuildCanceled )
+    return;
+
+  mFeatureValues = mBuildWatcher.result();
+
+  mValueCounts.clear();
+  for ( auto it = mFeatureValues.constBegin(); it != mFeatureValues.constEnd(); ++it )
+  {
+    mValueCounts[it.value()]++;
+  }
+
+  mIsReady = true;
+  emit ready();
+}
+
+QHash<QgsFeatureId, UniqueValuesIndex::ValueKey> UniqueValuesIndex::readValues( QgsAbstractFeatureSource *source, int providerFieldIndex, const QgsField &field, std::shared_ptr<std::atomic_bool> canceled )
+{
+  std::unique_ptr<QgsAbstractFeatureSource> fs( source );
+  QHash<QgsFeatureId, ValueKey> values;
+
+  QElapsedTimer t;
+  t.start();
+
+  QgsFeatureRequest request;
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+  request.setSubsetOfAttributes( QgsAttributeList() << providerFieldIndex );
+
+  QgsFeatureIterator it = fs->getFeatures( request );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( *canceled )
+    {
+      CoreUtils::log( QStringLiteral( "Unique values index" ), QStringLiteral( "Indexing canceled after %1 values" ).arg( values.count() ) );
+      return values;
+    }
+
+    const QVariant value = f.attribute( providerFieldIndex );
+    if ( !value.isNull() )
+      values.insert( f.id(), valueKey( value, field ) );
+  }
+
+  CoreUtils::log( QStringLiteral( "Unique values index" ), QStringLiteral( "Indexed %1 values in %2 ms" ).arg( values.count() ).arg( t.elapsed() ) );
+  return values;
+}
+
+void UniqueValuesIndex::addValue( QgsFeatureId fid, const QVariant &value )
+{
+  removeValue( fid );
+
+  if ( value.isNull() )
+    return;
+
+  const ValueKey key = valueKey( value, mField );
+  mFeatureValues.insert( fid, key );
+  mValueCounts[key]++;
+}
+
+void UniqueValuesIndex::removeValue( QgsFeatureId fid )
+{
+  auto it = mFeatureValues.find( fid );
+  if ( it == mFeatureValues.end() )
+    return;
+
+  auto countIt = mValueCounts.find( it.value() );
+  if ( countIt != mValueCounts.end() && --countIt.value() <= 0 )
+    mValueCounts.erase( countIt );
+
+  mFeatureValues.erase( it );
+}
+
+void UniqueValuesIndex::onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &addedFeatures )
+{
+  Q_UNUSED( layerId )
+
+  if ( !mIsReady )
+  {
+    // the running build might have missed the commit
+    rebuild();
+    return;
+  }
+
+  const int fieldIndex = mLayer->fields().indexOf( mFieldName );
+  for ( const QgsFeature &f : addedFeatures )
+  {
+    addValue( f.id(), f.attribute( fieldIndex ) );
+  }
+}
+
+void UniqueValuesIndex::onCommittedFeaturesRemoved( const QString &layerId, const QgsFeatureIds &deletedFeatureIds )
+{
+  Q_UNUSED( layerId )
+
+  if ( !mIsReady )
+  {
+    // the running build might have missed the commit
+    rebuild();
+    return;
+  }
+
+  for ( QgsFeatureId fid : deletedFeatureIds )
+  {
+    removeValue( fid );
+  }
+}
+
+void UniqueValuesIndex::onCommittedAttributeValuesChanges( const QString &layerId, const QgsChangedAttributesMap &changedAttributesValues )
+{
+  Q_UNUSED( layerId )
+
+  if ( !mIsReady )
+  {
+    // the running build might have missed the commit
+    rebuild();
+    return;
+  }
+
+  const int fieldIndex = mLayer->fields().indexOf( mFieldName );
+  for ( auto it = changedAttributesValues.constBegin(); it != changedAttributesValues.constEnd(); ++it )
+  {
+    if ( it.value().contains( fieldIndex ) )
+      addValue( it.key(), it.value().value( fieldIndex ) );
+  }
+}
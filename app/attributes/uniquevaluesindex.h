@@ -0,0 +1,108 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef UNIQUEVALUESINDEX_H
+#define UNIQUEVALUESINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QFutureWatcher>
+
+#include <atomic>
+#include <memory>
+
+#include "qgsfeature.h"
+#include "qgsfeatureid.h"
+#include "qgsvectorlayer.h"
+
+#include "inputconfig.h"
+
+class QgsAbstractFeatureSource;
+
+/**
+ * In-memory index of committed values of a field with a unique constraint, so that
+ * form validation does not need to query the data provider on every change of the value.
+ * Uncommitted edits of the layer are merged in when a value is looked up.
+ *
+ * The index is built in the background and then kept up to date with commits of the layer.
+ * There is a single index per provider field (owned by the layer), use forField() to get it.
+ * A running build is canceled (not waited for) when the index is destroyed or rebuilt.
+ */
+class UniqueValuesIndex : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    /**
+     * Returns index of the field with \a fieldIndex of the \a layer, creates it (and starts to build it) if it does not exist yet.
+     * Only fields of the data provider can be indexed.
+     */
+    static UniqueValuesIndex *forField( QgsVectorLayer *layer, int fieldIndex );
+
+    virtual ~UniqueValuesIndex();
+
+    //! Returns true once the index has been built and can be queried
+    bool isReady() const;
+
+    /**
+     * Returns true if a feature other than \a ignoredFeature has the \a value, including uncommitted features
+     * and values in the edit buffer of the layer. NULL values never exist.
+     */
+    bool valueExists( const QVariant &value, QgsFeatureId ignoredFeature ) const;
+
+  signals:
+    void ready();
+
+  private slots:
+    void onBuildFinished();
+    void onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &addedFeatures );
+    void onCommittedFeaturesRemoved( const QString &layerId, const QgsFeatureIds &deletedFeatureIds );
+    void onCommittedAttributeValuesChanges( const QString &layerId, const QgsChangedAttributesMap &changedAttributesValues );
+    void rebuild();
+
+  private:
+    UniqueValuesIndex( QgsVectorLayer *layer, const QString &fieldName );
+
+    //! Type and text of a value converted to the field type, so that e.g. 1 and 1.0 of a real field are the same value
+    typedef QPair<int, QString> ValueKey;
+
+    //! Returns key of the \a value of the \a field in the index
+    static ValueKey valueKey( const QVariant &value, const QgsField &field );
+
+    /**
+     * Reads values of the field with \a providerFieldIndex from the provider \a source, runs in a worker thread.
+     * Stops early (with incomplete values) once \a canceled is set.
+     */
+    static QHash<QgsFeatureId, ValueKey> readValues( QgsAbstractFeatureSource *source, int providerFieldIndex, const QgsField &field, std::shared_ptr<std::atomic_bool> canceled );
+
+    //! Asks the running build (if any) to stop, its result is discarded
+    void cancelBuild();
+
+    //! Returns true if the committed value of \a fid is \a key
+    bool hasCommittedValue( QgsFeatureId fid, const ValueKey &key ) const;
+
+    void addValue( QgsFeatureId fid, const QVariant &value );
+    void removeValue( QgsFeatureId fid );
+
+    QgsVectorLayer *mLayer = nullptr; // parent
+    QString mFieldName;
+    QgsField mField;
+
+    QHash<QgsFeatureId, ValueKey> mFeatureValues; //!< keys of non-NULL committed values of features
+    QHash<ValueKey, int> mValueCounts; //!< number of committed features with the value
+
+    QFutureWatcher<QHash<QgsFeatureId, ValueKey>> mBuildWatcher;
+    std::shared_ptr<std::atomic_bool> mBuildCanceled;
+    bool mIsReady = false;
+
+    friend class TestAttributeController;
+};
+
+#endif // UNIQUEVALUESINDEX_H
@@ -0,0 +1,266 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "featuresearchindex.h"
+#include "coreutils.h"
+
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
+
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QtConcurrent>
+
+FeatureSearchIndex *FeatureSearchIndex::forLayer( QgsVectorLayer *layer )
+{
+  if ( !layer || !layer->isValid() )
+    return nullptr;
+
+  FeatureSearchIndex *index = layer->findChild<FeatureSearchIndex *>( QString(), Qt::FindDirectChildrenOnly );
+  if ( !index )
+  {
+    index = new FeatureSearchIndex( layer );
+  }
+  return index;
+}
+
+FeatureSearchIndex::FeatureSearchIndex( QgsVectorLayer *layer )
+  : QObject( layer )
+  , mLayer( layer )
+{
+  connect( &mBuildWatcher, &QFutureWatcher<Tokens>::finished, this, &FeatureSearchIndex::onBuildFinished );
+
+  connect( mLayer, &QgsVectorLayer::featureAdded, this, &FeatureSearchIndex::onFeatureChanged );
+  connect( mLayer, &QgsVectorLayer::featureDeleted, this, &FeatureSearchIndex::onFeatureChanged );
+  connect( mLayer, &QgsVectorLayer::attributeValueChanged, this, &FeatureSearchIndex::onFeatureChanged );
+  connect( mLayer, &QgsVectorLayer::committedFeaturesAdded, this, &FeatureSearchIndex::onCommittedFeaturesAdded );
+  connect( mLayer, &QgsVectorLayer::updatedFields, this, &FeatureSearchIndex::rebuild );
+
+  rebuild();
+}
+
+FeatureSearchIndex::~FeatureSearchIndex()
+{
+  // the worker owns its feature source, it finishes on its own without blocking the UI thread
+  cancelBuild();
+}
+
+bool FeatureSearchIndex::isReady() const
+{
+  return mIsReady;
+}
+
+void FeatureSearchIndex::rebuild()
+{
+  mIsReady = false;
+  mPendingChangedFeatures.clear();
+  cancelBuild();
+
+  mBuildCanceled = std::make_shared<std::atomic_bool>( false );
+  QgsVectorLayerFeatureSource *source = new QgsVectorLayerFeatureSource( mLayer );
+  mBuildWatcher.setFuture( QtConcurrent::run( &FeatureSearchIndex::buildTokens, source, mLayer->fields(), mBuildCanceled ) );
+}
+
+void FeatureSearchIndex::cancelBuild()
+{
+  if ( mBuildCanceled )
+    *mBuildCanceled = true;
+}
+
+void FeatureSearchIndex::onBuildFinished()
+{
+  if ( mBuildWatcher.isCanceled() || !mBuildCanceled || *mBuildCanceled )
+    return;
+
+  mTokens = mBuildWatcher.result();
+  mIsReady = true;
+  emit ready();
+}
+
+FeatureSearchIndex::Tokens FeatureSearchIndex::buildTokens( QgsVectorLayerFeatureSource *source, const QgsFields &fields, std::shared_ptr<std::atomic_bool> canceled )
+{
+  std::unique_ptr<QgsVectorLayerFeatureSource> fs( source );
+  Tokens tokens;
+
+  QElapsedTimer t;
+  t.start();
+
+  QgsFeatureRequest request;
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+
+  QgsFeatureIterator it = fs->getFeatures( request );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( *canceled )
+    {
+      CoreUtils::log( QStringLiteral( "Search index" ), QStringLiteral( "Indexing canceled after %1 features" ).arg( tokens.tokensByFeature.count() ) );
+      return tokens;
+    }
+
+    addFeature( tokens, f.id(), featureTokens( f, fields ) );
+  }
+
+  CoreUtils::log( QStringLiteral( "Search index" ), QStringLiteral( "Indexed %1 features (%2 tokens) in %3 ms" )
+                  .arg( tokens.tokensByFeature.count() ).arg( tokens.featuresByToken.count() ).arg( t.elapsed() ) );
+  return tokens;
+}
+
+QStringList FeatureSearchIndex::tokenize( const QString &value )
+{
+  static const QRegularExpression sWhitespace( QStringLiteral( "\\s+" ) );
+  static const QRegularExpression sNonWord( QStringLiteral( "[^\\w]+" ), QRegularExpression::UseUnicodePropertiesOption );
+
+  QStringList tokens;
+  const QStringList parts = value.toLower().split( sWhitespace, Qt::SkipEmptyParts );
+  for ( const QString &part : parts )
+  {
+    tokens << part;
+
+    // also index alphanumeric sub-parts, so that "hand" finds "second-hand"
+    const QStringList subParts = part.split( sNonWord, Qt::SkipEmptyParts );
+    if ( subParts.count() > 1 || ( subParts.count() == 1 && subParts.first() != part ) )
+      tokens << subParts;
+  }
+
+  tokens.removeDuplicates();
+  return tokens;
+}
+
+QStringList FeatureSearchIndex::featureTokens( const QgsFeature &feature, const QgsFields &fields )
+{
+  QStringList tokens;
+  for ( int i = 0; i < fields.count(); ++i )
+  {
+    const QgsField field = fields.at( i );
+    if ( field.configurationFlags().testFlag( Qgis::FieldConfigurationFlag::NotSearchable ) )
+      continue;
+
+    if ( field.type() != QVariant::String && !field.isNumeric() )
+      continue;
+
+    const QVariant value = feature.attribute( i );
+    if ( value.isNull() )
+      continue;
+
+    tokens << tokenize( value.toString() );
+  }
+
+  tokens.removeDuplicates();
+  return tokens;
+}
+
+void FeatureSearchIndex::addFeature( Tokens &tokens, QgsFeatureId fid, const QStringList &featureTokens )
+{
+  for ( const QString &token : featureTokens )
+  {
+    tokens.featuresByToken[token].insert( fid );
+  }
+  tokens.tokensByFeature.insert( fid, featureTokens );
+}
+
+void FeatureSearchIndex::removeFeature( Tokens &tokens, QgsFeatureId fid )
+{
+  const QStringList featureTokens = tokens.tokensByFeature.take( fid );
+  for ( const QString &token : featureTokens )
+  {
+    auto it = tokens.featuresByToken.find( token );
+    if ( it == tokens.featuresByToken.end() )
+      continue;
+
+    it->remove( fid );
+    if ( it->isEmpty() )
+      tokens.featuresByToken.erase( it );
+  }
+}
+
+void FeatureSearchIndex::onFeatureChanged( QgsFeatureId fid )
+{
+  // changes are applied lazily before the next query, so a burst of edits is read from the layer only once
+  mPendingChangedFeatures.insert( fid );
+}
+
+void FeatureSearchIndex::onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &addedFeatures )
+{
+  Q_UNUSED( layerId )
+
+  // features got their final ids, forget the temporary ones
+  const QList<QgsFeatureId> fids = mTokens.tokensByFeature.keys();
+  for ( QgsFeatureId fid : fids )
+  {
+    if ( FID_IS_NEW( fid ) )
+      removeFeature( mTokens, fid );
+  }
+
+  for ( const QgsFeature &f : addedFeatures )
+  {
+    mPendingChangedFeatures.insert( f.id() );
+  }
+}
+
+void FeatureSearchIndex::applyPendingChanges()
+{
+  if ( mPendingChangedFeatures.isEmpty() )
+    return;
+
+  for ( QgsFeatureId fid : std::as_const( mPendingChangedFeatures ) )
+  {
+    removeFeature( mTokens, fid );
+  }
+
+  // deleted features are not returned, so they stay removed
+  QgsFeatureRequest request;
+  request.setFilterFids( mPendingChangedFeatures );
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+
+  const QgsFields fields = mLayer->fields();
+  QgsFeatureIterator it = mLayer->getFeatures( request );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    addFeature( mTokens, f.id(), featureTokens( f, fields ) );
+  }
+
+  mPendingChangedFeatures.clear();
+}
+
+QgsFeatureIds FeatureSearchIndex::matchingFeatures( const QStringList &words )
+{
+  if ( !mIsReady )
+    return QgsFeatureIds();
+
+  applyPendingChanges();
+
+  QgsFeatureIds result;
+  bool firstWord = true;
+
+  for ( const QString &word : words )
+  {
+    const QString prefix = word.toLower();
+
+    QgsFeatureIds wordMatches;
+    const QMap<QString, QgsFeatureIds> &featuresByToken = mTokens.featuresByToken;
+    for ( auto it = featuresByToken.lowerBound( prefix ); it != featuresByToken.constEnd() && it.key().startsWith( prefix ); ++it )
+    {
+      wordMatches.unite( it.value() );
+    }
+
+    if ( firstWord )
+      result = wordMatches;
+    else
+      result.intersect( wordMatches );
+
+    firstWord = false;
+
+    if ( result.isEmpty() )
+      break;
+  }
+
+  return result;
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FEATURESEARCHINDEX_H
+#define FEATURESEARCHINDEX_H
+
+#include <QObject>
+#include <QMap>
+#include <QHash>
+#include <QFutureWatcher>
+
+#include <atomic>
+#include <memory>
+
+#include "qgsfeature.h"
+#include "qgsfeatureid.h"
+
+#include "inputconfig.h"
+
+class QgsVectorLayer;
+class QgsVectorLayerFeatureSource;
+
+/**
+ * In-memory inverted index of searchable attribute values of a vector layer.
+ *
+ * Values of string and numeric fields (not flagged as NotSearchable) are split into lower-case
+ * tokens mapped to feature ids, search words are matched as token prefixes. The index is built
+ * in the background and then kept up to date with edits of the layer.
+ *
+ * There is a single index per layer (owned by the layer), use forLayer() to get it.
+ * A running build is canceled (not waited for) when the index is destroyed or rebuilt.
+ */
+class FeatureSearchIndex : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    //! Returns search index of the \a layer, creates it (and starts to build it) if it does not exist yet
+    static FeatureSearchIndex *forLayer( QgsVectorLayer *layer );
+
+    virtual ~FeatureSearchIndex();
+
+    //! Returns true once the index has been built and can be queried
+    bool isReady() const;
+
+    /**
+     * Returns ids of features which contain all the \a words - each word has to be
+     * a prefix of some token of a searchable attribute value (case insensitive).
+     */
+    QgsFeatureIds matchingFeatures( const QStringList &words );
+
+    //! Splits \a value into lower-case tokens - whitespace separated parts and their alphanumeric sub-parts
+    static QStringList tokenize( const QString &value );
+
+  signals:
+    void ready();
+
+  private slots:
+    void onBuildFinished();
+    void onFeatureChanged( QgsFeatureId fid );
+    void onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &addedFeatures );
+    void rebuild();
+
+  private:
+    explicit FeatureSearchIndex( QgsVectorLayer *layer );
+
+    struct Tokens
+    {
+      QMap<QString, QgsFeatureIds> featuresByToken; //!< sorted to allow prefix lookups
+      QHash<QgsFeatureId, QStringList> tokensByFeature; //!< for removal of changed features
+    };
+
+    /**
+     * Tokenizes all features of the \a source, runs in a worker thread.
+     * Stops early (with incomplete tokens) once \a canceled is set.
+     */
+    static Tokens buildTokens( QgsVectorLayerFeatureSource *source, const QgsFields &fields, std::shared_ptr<std::atomic_bool> canceled );
+
+    //! Asks the running build (if any) to stop, its result is discarded
+    void cancelBuild();
+
+    //! Returns tokens of searchable attribute values of the \a feature
+    static QStringList featureTokens( const QgsFeature &feature, const QgsFields &fields );
+
+    static void addFeature( Tokens &tokens, QgsFeatureId fid, const QStringList &featureTokens );
+    static void removeFeature( Tokens &tokens, QgsFeatureId fid );
+
+    //! Re-reads features changed since the last query from the layer
+    void applyPendingChanges();
+
+    QgsVectorLayer *mLayer = nullptr; // parent
+    Tokens mTokens;
+    QgsFeatureIds mPendingChangedFeatures;
+    QFutureWatcher<Tokens> mBuildWatcher;
+    std::shared_ptr<std::atomic_bool> mBuildCanceled;
+    bool mIsReady = false;
+
+    friend class TestModels;
+};
+
+#endif // FEATURESEARCHINDEX_H
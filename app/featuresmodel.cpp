@@ -8,6 +8,7 @@
  ***************************************************************************/
 
 #include "featuresmodel.h"
+#include "featuresearchindex.h"
 #include "coreutils.h"
 
 #include "inpututils.h"
@@ -25,6 +26,15 @@ FeaturesModel::FeaturesModel( QObject *parent )
     mLayer( nullptr )
 {
   connect( &mSearchResultWatcher, &QFutureWatcher<QgsFeatureList>::finished, this, &FeaturesModel::onFutureFinished );
+  connect( QgsProject::instance(), &QgsProject::customVariablesChanged, this, &FeaturesModel::invalidateFeatureTitles );
+
+  mPendingChangesTimer.setSingleShot( true );
+  mPendingChangesTimer.setInterval( 0 );
+  connect( &mPendingChangesTimer, &QTimer::timeout, this, &FeaturesModel::applyPendingChanges );
+
+  mPageLoadTimer.setSingleShot( true );
+  mPageLoadTimer.setInterval( 0 );
+  connect( &mPageLoadTimer, &QTimer::timeout, this, &FeaturesModel::loadRequestedPages );
 }
 
 FeaturesModel::~FeaturesModel() = default;
@@ -33,7 +43,11 @@ void FeaturesModel::populateStaticModel( FeatureLayerPairs pairs )
 {
   beginResetModel();
   mFeatures.clear();
+  mFeatureTitles.clear();
+  mDisplayExpressions.clear();
+  mFeatureRows.clear();
   mFeatures.append( pairs );
+  watchStaticLayers();
   endResetModel();
   emit countChanged( rowCount() );
 }
@@ -44,13 +58,34 @@ void FeaturesModel::populate()
   {
     mFetchingResults = true;
     emit fetchingResultsChanged( mFetchingResults );
+    mPartialFeatures = false;
+
+    if ( mUseSearchIndex )
+    {
+      // starts to build the index in the background, so it is ready by the time user searches
+      FeatureSearchIndex::forLayer( mLayer );
+    }
+    mPendingChangesTimer.stop();
+    mPendingChangedFeatures.clear();
+
     beginResetModel();
     mFeatures.clear();
+    mFeatureTitles.clear();
+    mFeatureRows.clear();
+    resetPages();
     endResetModel();
 
     QgsFeatureRequest req;
     setupFeatureRequest( req );
 
+    if ( mPagedFetching )
+    {
+      // only ordered ids of all matching features are fetched here, attributes are loaded in pages later
+      req.setLimit( -1 );
+      req.setFlags( req.flags() | QgsFeatureRequest::NoGeometry );
+      req.setNoAttributes();
+    }
+
     int searchId = mNextSearchId.fetchAndAddOrdered( 1 );
     QgsVectorLayerFeatureSource *source = new QgsVectorLayerFeatureSource( mLayer );
     mSearchResultWatcher.setFuture( QtConcurrent::run( &FeaturesModel::fetchFeatures, this, source, req, searchId ) );
@@ -98,14 +133,39 @@ QgsFeatureList FeaturesModel::fetchFeatures( QgsVectorLayerFeatureSource *source
 
 void FeaturesModel::onFutureFinished()
 {
+  if ( !mFetchingResults )
+    return; // features were set by setFeatures() in the meantime
+
   QFutureWatcher<QgsFeatureList> *watcher = static_cast< QFutureWatcher<QgsFeatureList> *>( sender() );
   const QgsFeatureList features = watcher->future().result();
   beginResetModel();
   mFeatures.clear();
-  for ( const auto &f : features )
+  mFeatureTitles.clear();
+  resetPages();
+  if ( mPagedFetching )
   {
-    mFeatures << FeatureLayerPair( f, mLayer );
+    for ( const auto &f : features )
+    {
+      mFeatureIds << f.id();
+    }
+
+    // rows of the first page only hold the feature id until their attributes are loaded in the background
+    const int firstPageSize = std::min( PAGE_SIZE, static_cast<int>( mFeatureIds.count() ) );
+    for ( int row = 0; row < firstPageSize; ++row )
+    {
+      mFeatures << FeatureLayerPair( QgsFeature( mFeatureIds.at( row ) ), mLayer );
+    }
+    if ( !mFeatures.isEmpty() )
+      requestPage( 0 );
   }
+  else
+  {
+    for ( const auto &f : features )
+    {
+      mFeatures << FeatureLayerPair( f, mLayer );
+    }
+  }
+  updateFeatureRows();
   emit layerFeaturesCountChanged( layerFeaturesCount() );
   emit countChanged( rowCount() );
   endResetModel();
@@ -114,6 +174,37 @@ void FeaturesModel::onFutureFinished()
 }
 
 
+void FeaturesModel::setFeatures( const FeatureLayerPairs &pairs, bool partialFeatures )
+{
+  mPendingChangesTimer.stop();
+  mPendingChangedFeatures.clear();
+
+  beginResetModel();
+  mFeatures = pairs;
+  mFeatureTitles.clear();
+  resetPages();
+  if ( mPagedFetching )
+  {
+    // all features are listed, the ids keep track of rows of the edited features
+    for ( const FeatureLayerPair &pair : pairs )
+    {
+      mFeatureIds << pair.feature().id();
+    }
+  }
+  mPartialFeatures = partialFeatures;
+  updateFeatureRows();
+  endResetModel();
+
+  emit layerFeaturesCountChanged( layerFeaturesCount() );
+  emit countChanged( rowCount() );
+
+  if ( mFetchingResults )
+  {
+    mFetchingResults = false;
+    emit fetchingResultsChanged( mFetchingResults );
+  }
+}
+
 void FeaturesModel::setup()
 {
   // define in submodels
@@ -130,17 +221,59 @@ QVariant FeaturesModel::data( const QModelIndex &index, int role ) const
 
   const FeatureLayerPair pair = mFeatures.at( index.row() );
 
+  if ( mPagedFetching && ( role == FeatureTitle || role == Qt::DisplayRole || role == SearchResult ) )
+  {
+    const int page = row / PAGE_SIZE;
+
+    // keep the next page ready while the list is being scrolled
+    if ( ( page + 1 ) * PAGE_SIZE < mFeatures.count() && !mFeatures.at( ( page + 1 ) * PAGE_SIZE ).feature().isValid() )
+      requestPage( page + 1 );
+
+    if ( !pair.feature().isValid() )
+    {
+      // attributes of the row are not loaded, they are never queried here on the UI thread
+      requestPage( page );
+
+      if ( role == SearchResult )
+        return QString();
+
+      // titles of evicted rows stay memoized
+      return mFeatureTitles.value( qMakePair( pair.layer(), pair.feature().id() ) );
+    }
+
+    if ( mLoadedPages.isEmpty() || mLoadedPages.first() != page )
+    {
+      mLoadedPages.removeOne( page );
+      mLoadedPages.prepend( page );
+      evictPages();
+    }
+  }
+
   switch ( role )
   {
-    case FeatureTitle: return featureTitle( pair );
+    case FeatureTitle: return cachedFeatureTitle( pair );
     case FeatureId: return QVariant( pair.feature().id() );
-    case Feature: return QVariant::fromValue<QgsFeature>( pair.feature() );
-    case FeaturePair: return QVariant::fromValue<FeatureLayerPair>( pair );
+    case Feature:
+    case FeaturePair:
+    {
+      // partial features (e.g. from a lookup table) carry the attributes their models read through the Feature role,
+      // only the pair (used to open the feature) is read from the layer
+      if ( pair.layer() && ( mPagedFetching || ( mPartialFeatures && role == FeaturePair ) ) )
+      {
+        // rows are fetched without geometry and with a subset of attributes (or just the id), provide the complete feature
+        FeatureLayerPair completePair( pair.layer()->getFeature( pair.feature().id() ), pair.layer() );
+        if ( !completePair.feature().isValid() )
+          return QVariant();
+
+        return role == Feature ? QVariant::fromValue<QgsFeature>( completePair.feature() ) : QVariant::fromValue<FeatureLayerPair>( completePair );
+      }
+      return role == Feature ? QVariant::fromValue<QgsFeature>( pair.feature() ) : QVariant::fromValue<FeatureLayerPair>( pair );
+    }
     case Description: return QVariant( QString( "Feature ID %1" ).arg( pair.feature().id() ) );
     case SearchResult: return searchResultPair( pair );
     case LayerName: return pair.layer() ? pair.layer()->name() : QString();
     case LayerIcon: return pair.layer() ? InputUtils::loadIconFromLayer( pair.layer() ) : QString();
-    case Qt::DisplayRole: return featureTitle( pair );
+    case Qt::DisplayRole: return cachedFeatureTitle( pair );
   }
 
   return QVariant();
@@ -156,6 +289,195 @@ int FeaturesModel::rowCount( const QModelIndex &parent ) const
   return mFeatures.count();
 }
 
+bool FeaturesModel::canFetchMore( const QModelIndex &parent ) const
+{
+  if ( parent.isValid() || !mPagedFetching )
+    return false;
+
+  return mFeatures.count() < mFeatureIds.count();
+}
+
+void FeaturesModel::fetchMore( const QModelIndex &parent )
+{
+  if ( !canFetchMore( parent ) )
+    return;
+
+  // rows only hold the feature id until their attributes are loaded in the background
+  const int fromRow = mFeatures.count();
+  const int toRow = std::min( fromRow + PAGE_SIZE, static_cast<int>( mFeatureIds.count() ) ) - 1;
+
+  beginInsertRows( QModelIndex(), fromRow, toRow );
+  for ( int row = fromRow; row <= toRow; ++row )
+  {
+    mFeatures << FeatureLayerPair( QgsFeature( mFeatureIds.at( row ) ), mLayer );
+  }
+  endInsertRows();
+
+  requestPage( fromRow / PAGE_SIZE );
+
+  emit countChanged( rowCount() );
+}
+
+QgsFeatureRequest FeaturesModel::pageRequest( const QList<QgsFeatureId> &ids ) const
+{
+  QgsFeatureRequest request;
+  request.setFilterFids( QgsFeatureIds( ids.constBegin(), ids.constEnd() ) );
+
+  // the list needs only attributes for the feature title and the search result
+  QgsExpression displayExpression( mLayer->displayExpression() );
+  if ( !displayExpression.needsGeometry() )
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+
+  QSet<QString> attributes = displayExpression.referencedColumns();
+  if ( !mSearchExpression.isEmpty() )
+  {
+    const QgsFields fields = mLayer->fields();
+    for ( const QgsField &field : fields )
+    {
+      if ( !field.configurationFlags().testFlag( Qgis::FieldConfigurationFlag::NotSearchable ) )
+        attributes.insert( field.name() );
+    }
+  }
+  if ( !attributes.contains( QgsFeatureRequest::ALL_ATTRIBUTES ) )
+    request.setSubsetOfAttributes( attributes, mLayer->fields() );
+
+  return request;
+}
+
+void FeaturesModel::requestPage( int page ) const
+{
+  if ( mRequestedPages.contains( page ) || mLoadingPages.contains( page ) )
+    return;
+
+  // requests of all data() calls of the current event loop iteration are loaded together
+  mRequestedPages.insert( page );
+  mPageLoadTimer.start();
+}
+
+void FeaturesModel::loadRequestedPages()
+{
+  const QSet<int> pages = mRequestedPages;
+  mRequestedPages.clear();
+
+  if ( !mLayer )
+    return;
+
+  for ( int page : pages )
+  {
+    const int fromRow = page * PAGE_SIZE;
+    const int toRow = std::min( fromRow + PAGE_SIZE, static_cast<int>( mFeatures.count() ) );
+    if ( fromRow >= toRow )
+      continue;
+
+    const QList<QgsFeatureId> ids = mFeatureIds.mid( fromRow, toRow - fromRow );
+    const QgsFeatureRequest request = pageRequest( ids );
+    QgsVectorLayerFeatureSource *source = new QgsVectorLayerFeatureSource( mLayer );
+
+    QFutureWatcher<QgsFeatureList> *watcher = new QFutureWatcher<QgsFeatureList>( this );
+    connect( watcher, &QFutureWatcher<QgsFeatureList>::finished, this, [this, watcher, page, ids, generation = mPagesGeneration]()
+    {
+      watcher->deleteLater();
+      if ( generation == mPagesGeneration )
+        onPageLoaded( page, ids, watcher->future().result() );
+    } );
+
+    mLoadingPages.insert( page );
+    watcher->setFuture( QtConcurrent::run( &FeaturesModel::fetchPageFeatures, source, request ) );
+  }
+}
+
+QgsFeatureList FeaturesModel::fetchPageFeatures( QgsVectorLayerFeatureSource *source, QgsFeatureRequest request )
+{
+  std::unique_ptr<QgsVectorLayerFeatureSource> fs( source );
+
+  QgsFeatureList features;
+  QgsFeatureIterator it = fs->getFeatures( request );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    features << f;
+  }
+  return features;
+}
+
+void FeaturesModel::onPageLoaded( int page, const QList<QgsFeatureId> &ids, const QgsFeatureList &features )
+{
+  mLoadingPages.remove( page );
+
+  QHash<QgsFeatureId, QgsFeature> loadedFeatures;
+  for ( const QgsFeature &feature : features )
+  {
+    loadedFeatures.insert( feature.id(), feature );
+  }
+
+  // rows could have moved by edits in the meantime, so the features are matched by their id
+  int firstRow = -1;
+  int lastRow = -1;
+  for ( QgsFeatureId id : ids )
+  {
+    const int row = mFeatureRows.value( id, -1 );
+    if ( row < 0 || row >= mFeatures.count() || mFeatures.at( row ).feature().isValid() )
+      continue;
+
+    QgsFeature feature = loadedFeatures.value( id, QgsFeature( id ) );
+    if ( !feature.isValid() )
+    {
+      // the feature has been deleted in the meantime, the row goes away with featuresDeleted, do not request it again
+      feature.setValid( true );
+    }
+
+    mFeatures[row] = FeatureLayerPair( feature, mLayer );
+    firstRow = firstRow < 0 ? row : std::min( firstRow, row );
+    lastRow = std::max( lastRow, row );
+  }
+
+  mLoadedPages.removeOne( page );
+  mLoadedPages.prepend( page );
+  evictPages();
+
+  if ( firstRow >= 0 )
+  {
+    emit dataChanged( index( firstRow ), index( lastRow ), { FeatureTitle, Qt::DisplayRole, SearchResult } );
+  }
+}
+
+void FeaturesModel::resetPages()
+{
+  mFeatureIds.clear();
+  mLoadedPages.clear();
+  mRequestedPages.clear();
+  mLoadingPages.clear();
+
+  // page loads still running in the background are dropped once they finish
+  ++mPagesGeneration;
+}
+
+void FeaturesModel::evictPages() const
+{
+  while ( mLoadedPages.count() > MAX_LOADED_PAGES )
+  {
+    const int page = mLoadedPages.takeLast();
+    const int toRow = std::min( ( page + 1 ) * PAGE_SIZE, static_cast<int>( mFeatures.count() ) );
+    for ( int row = page * PAGE_SIZE; row < toRow; ++row )
+    {
+      // keep just the feature id, titles stay memoized
+      mFeatures[row] = FeatureLayerPair( QgsFeature( mFeatures.at( row ).feature().id() ), mLayer );
+    }
+  }
+}
+
+QVariant FeaturesModel::rowAttribute( int row, const QString &fieldName ) const
+{
+  if ( row < 0 || row >= mFeatures.count() )
+    return QVariant();
+
+  const QgsFeature &feature = mFeatures.at( row ).feature();
+  if ( !feature.isValid() )
+    return data( index( row ), Feature ).value<QgsFeature>().attribute( fieldName );
+
+  return feature.attribute( fieldName );
+}
+
 QVariant FeaturesModel::featureTitle( const FeatureLayerPair &featurePair ) const
 {
   if ( !featurePair.layer() || !featurePair.layer()->isValid() )
@@ -164,12 +486,18 @@ QVariant FeaturesModel::featureTitle( const FeatureLayerPair &featurePair ) cons
     return tr( "Unknown title" );
   }
 
-  QString title;
+  auto it = mDisplayExpressions.find( featurePair.layer()->id() );
+  if ( it == mDisplayExpressions.end() )
+  {
+    DisplayExpression displayExpression;
+    displayExpression.context = QgsExpressionContext( QgsExpressionContextUtils::globalProjectLayerScopes( featurePair.layer() ) );
+    displayExpression.expression = QgsExpression( featurePair.layer()->displayExpression() );
+    displayExpression.expression.prepare( &displayExpression.context );
+    it = mDisplayExpressions.insert( featurePair.layer()->id(), displayExpression );
+  }
 
-  QgsExpressionContext context( QgsExpressionContextUtils::globalProjectLayerScopes( featurePair.layer() ) );
-  context.setFeature( featurePair.feature() );
-  QgsExpression expr( featurePair.layer()->displayExpression() );
-  title = expr.evaluate( &context ).toString();
+  it->context.setFeature( featurePair.feature() );
+  QString title = it->expression.evaluate( &it->context ).toString();
 
   if ( title.isEmpty() )
     return featurePair.feature().id();
@@ -177,6 +505,249 @@ QVariant FeaturesModel::featureTitle( const FeatureLayerPair &featurePair ) cons
   return title;
 }
 
+QVariant FeaturesModel::cachedFeatureTitle( const FeatureLayerPair &featurePair ) const
+{
+  const QPair<QgsVectorLayer *, QgsFeatureId> key( featurePair.layer(), featurePair.feature().id() );
+
+  auto it = mFeatureTitles.constFind( key );
+  if ( it != mFeatureTitles.constEnd() )
+    return it.value();
+
+  QVariant title = featureTitle( featurePair );
+  mFeatureTitles.insert( key, title );
+  return title;
+}
+
+void FeaturesModel::updateFeatureRows( int fromRow )
+{
+  if ( fromRow == 0 )
+    mFeatureRows.clear();
+
+  if ( mPagedFetching )
+  {
+    // also features which are not fetched to the model yet
+    for ( int row = fromRow; row < mFeatureIds.count(); ++row )
+    {
+      mFeatureRows.insert( mFeatureIds.at( row ), row );
+    }
+    return;
+  }
+
+  for ( int row = fromRow; row < mFeatures.count(); ++row )
+  {
+    mFeatureRows.insert( mFeatures.at( row ).feature().id(), row );
+  }
+}
+
+void FeaturesModel::onFeatureChanged( QgsFeatureId fid )
+{
+  if ( FID_IS_NEW( fid ) || FID_IS_NULL( fid ) )
+  {
+    return; // uncommited features are not listed, they will come with committedFeaturesAdded
+  }
+
+  mPendingChangedFeatures.insert( fid );
+  mPendingChangesTimer.start();
+}
+
+void FeaturesModel::onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &addedFeatures )
+{
+  Q_UNUSED( layerId )
+
+  for ( const QgsFeature &f : addedFeatures )
+  {
+    onFeatureChanged( f.id() );
+  }
+}
+
+void FeaturesModel::onFeaturesDeleted( const QgsFeatureIds &fids )
+{
+  if ( mFetchingResults )
+  {
+    populate(); // running fetch could still return the deleted features
+    return;
+  }
+
+  QList<int> rows;
+  for ( QgsFeatureId fid : fids )
+  {
+    mPendingChangedFeatures.remove( fid );
+
+    auto it = mFeatureRows.constFind( fid );
+    if ( it != mFeatureRows.constEnd() )
+      rows << it.value();
+  }
+
+  if ( rows.isEmpty() )
+    return;
+
+  // remove from the bottom so that rows of the remaining features stay valid
+  std::sort( rows.begin(), rows.end(), std::greater<int>() );
+  for ( int row : std::as_const( rows ) )
+  {
+    if ( mPagedFetching && row >= mFeatures.count() )
+    {
+      // paged fetching: feature not fetched to the model yet
+      mFeatureRows.remove( mFeatureIds.takeAt( row ) );
+      continue;
+    }
+
+    beginRemoveRows( QModelIndex(), row, row );
+    mFeatureTitles.remove( qMakePair( mLayer, mFeatures.at( row ).feature().id() ) );
+    mFeatureRows.remove( mFeatures.at( row ).feature().id() );
+    mFeatures.removeAt( row );
+    if ( mPagedFetching )
+      mFeatureIds.removeAt( row );
+    endRemoveRows();
+  }
+  updateFeatureRows( rows.last() );
+
+  emit layerFeaturesCountChanged( layerFeaturesCount() );
+  emit countChanged( rowCount() );
+}
+
+void FeaturesModel::applyPendingChanges()
+{
+  if ( !mLayer || mPendingChangedFeatures.isEmpty() )
+  {
+    mPendingChangedFeatures.clear();
+    return;
+  }
+
+  QgsFeatureRequest modelRequest;
+  setupFeatureRequest( modelRequest );
+
+  // position of a changed feature depends on the order by and a new feature could push
+  // others out of the limit, let's query the layer again in these cases
+  if ( mFetchingResults || !modelRequest.orderBy().isEmpty() || ( !mPagedFetching && mFeatures.count() >= FEATURES_LIMIT ) )
+  {
+    populate();
+    return;
+  }
+
+  const QgsFeatureIds fids = mPendingChangedFeatures;
+  mPendingChangedFeatures.clear();
+
+  QHash<QgsFeatureId, QgsFeature> changedFeatures;
+  QgsFeatureIterator it = mLayer->getFeatures( QgsFeatureRequest().setFilterFids( fids ) );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    changedFeatures.insert( f.id(), f );
+  }
+
+  bool countHasChanged = false;
+  for ( QgsFeatureId fid : fids )
+  {
+    auto changed = changedFeatures.constFind( fid );
+    // the model request filter (search expression, relation, value relation filter, ...) decides if the feature is listed
+    const bool accepted = changed != changedFeatures.constEnd() && modelRequest.acceptFeature( changed.value() );
+    const int row = mFeatureRows.value( fid, -1 );
+    const bool listed = row >= 0 && row < mFeatures.count();
+
+    mFeatureTitles.remove( qMakePair( mLayer, fid ) );
+
+    if ( listed && accepted )
+    {
+      mFeatures[row] = FeatureLayerPair( changed.value(), mLayer );
+      emit dataChanged( index( row ), index( row ) );
+    }
+    else if ( listed )
+    {
+      beginRemoveRows( QModelIndex(), row, row );
+      mFeatures.removeAt( row );
+      mFeatureRows.remove( fid );
+      if ( mPagedFetching )
+        mFeatureIds.removeAt( row );
+      endRemoveRows();
+      updateFeatureRows( row );
+      countHasChanged = true;
+    }
+    else if ( row >= 0 )
+    {
+      // paged fetching: the feature is not fetched to the model yet, it gets fresh attributes when fetched
+      if ( !accepted )
+      {
+        mFeatureIds.removeAt( row );
+        mFeatureRows.remove( fid );
+        updateFeatureRows( row );
+      }
+    }
+    else if ( accepted && canFetchMore( QModelIndex() ) )
+    {
+      // will be listed after the features not fetched yet
+      mFeatureIds << fid;
+      mFeatureRows.insert( fid, mFeatureIds.count() - 1 );
+    }
+    else if ( accepted )
+    {
+      if ( mPagedFetching )
+        mFeatureIds << fid;
+
+      const int newRow = mFeatures.count();
+      beginInsertRows( QModelIndex(), newRow, newRow );
+      mFeatures << FeatureLayerPair( changed.value(), mLayer );
+      mFeatureRows.insert( fid, newRow );
+      endInsertRows();
+      countHasChanged = true;
+    }
+  }
+
+  if ( countHasChanged )
+  {
+    emit layerFeaturesCountChanged( layerFeaturesCount() );
+    emit countChanged( rowCount() );
+  }
+}
+
+void FeaturesModel::watchStaticLayers()
+{
+  for ( const QMetaObject::Connection &connection : std::as_const( mStaticLayersConnections ) )
+  {
+    disconnect( connection );
+  }
+  mStaticLayersConnections.clear();
+
+  QSet<QgsVectorLayer *> layers;
+  for ( const FeatureLayerPair &pair : std::as_const( mFeatures ) )
+  {
+    if ( pair.layer() )
+      layers.insert( pair.layer() );
+  }
+
+  for ( QgsVectorLayer *layer : std::as_const( layers ) )
+  {
+    const QString layerId = layer->id();
+    mStaticLayersConnections << connect( layer, &QgsVectorLayer::displayExpressionChanged, this, &FeaturesModel::invalidateFeatureTitles );
+    mStaticLayersConnections << connect( layer, &QObject::destroyed, this, [this, layer, layerId]() { removeLayerTitles( layer, layerId ); } );
+  }
+}
+
+void FeaturesModel::removeLayerTitles( QgsVectorLayer *layer, const QString &layerId )
+{
+  mDisplayExpressions.remove( layerId );
+
+  // the layer is only compared, it might be already destroyed
+  for ( auto it = mFeatureTitles.begin(); it != mFeatureTitles.end(); )
+  {
+    if ( it.key().first == layer )
+      it = mFeatureTitles.erase( it );
+    else
+      ++it;
+  }
+}
+
+void FeaturesModel::invalidateFeatureTitles()
+{
+  mDisplayExpressions.clear();
+  mFeatureTitles.clear();
+
+  if ( !mFeatures.isEmpty() )
+  {
+    emit dataChanged( index( 0 ), index( mFeatures.count() - 1 ), { FeatureTitle, Qt::DisplayRole } );
+  }
+}
+
 QString FeaturesModel::searchResultPair( const FeatureLayerPair &pair ) const
 {
   if ( mSearchExpression.isEmpty() )
@@ -195,7 +766,7 @@ QString FeaturesModel::searchResultPair( const FeatureLayerPair &pair ) const
 
       QString attrValue = pair.feature().attribute( field.name() ).toString();
 
-      if ( attrValue.toLower().indexOf( word.toLower() ) != -1 )
+      if ( attrValue.contains( word, Qt::CaseInsensitive ) )
       {
         foundPairs << field.name() + ": " + attrValue;
 
@@ -248,7 +819,15 @@ void FeaturesModel::setupFeatureRequest( QgsFeatureRequest &request )
 {
   if ( !mSearchExpression.isEmpty() )
   {
-    request.setFilterExpression( buildSearchExpression() );
+    FeatureSearchIndex *searchIndex = mUseSearchIndex ? FeatureSearchIndex::forLayer( mLayer ) : nullptr;
+    if ( searchIndex && searchIndex->isReady() )
+    {
+      request.setFilterFids( searchIndex->matchingFeatures( mSearchExpression.split( ' ', Qt::SkipEmptyParts ) ) );
+    }
+    else
+    {
+      request.setFilterExpression( buildSearchExpression() );
+    }
   }
 
   if ( mUseAttributeTableSortOrder && mLayer && !mLayer->attributeTableConfig().sortExpression().isEmpty() )
@@ -299,6 +878,11 @@ QHash<int, QByteArray> FeaturesModel::roleNames() const
 
 int FeaturesModel::rowFromRoleValue( const int role, const QVariant &value ) const
 {
+  if ( role == FeatureId && !mFeatureRows.isEmpty() )
+  {
+    return mFeatureRows.value( value.toLongLong(), -1 );
+  }
+
   for ( int i = 0; i < mFeatures.count(); ++i )
   {
     QVariant d = data( index( i, 0 ), role );
@@ -327,6 +911,13 @@ QVariant FeaturesModel::convertRoleValue( const int role, const QVariant &value,
 void FeaturesModel::reset()
 {
   mFeatures.clear();
+  watchStaticLayers();
+  mFeatureTitles.clear();
+  mDisplayExpressions.clear();
+  mFeatureRows.clear();
+  resetPages();
+  mPendingChangedFeatures.clear();
+  mPendingChangesTimer.stop();
   mLayer = nullptr;
   mSearchExpression.clear();
 }
@@ -362,20 +953,26 @@ void FeaturesModel::setLayer( QgsVectorLayer *newLayer )
   {
     if ( mLayer )
     {
-      disconnect( mLayer );
+      disconnect( mLayer, nullptr, this, nullptr );
     }
 
     mLayer = newLayer;
+    mFeatureTitles.clear();
+    mDisplayExpressions.clear();
     emit layerChanged( mLayer );
 
     if ( mLayer )
     {
       // avoid dangling pointers to mLayer when switching projects
       connect( mLayer, &QgsMapLayer::willBeDeleted, this, &FeaturesModel::reset );
-
-      connect( mLayer, &QgsVectorLayer::featureAdded, this, &FeaturesModel::populate );
-      connect( mLayer, &QgsVectorLayer::featuresDeleted, this, &FeaturesModel::populate );
-      connect( mLayer, &QgsVectorLayer::attributeValueChanged, this, &FeaturesModel::populate );
+      connect( mLayer, &QgsVectorLayer::displayExpressionChanged, this, &FeaturesModel::invalidateFeatureTitles );
+
+      // edits are applied to the fetched rows, the layer is queried again only if the order could change
+      connect( mLayer, &QgsVectorLayer::featureAdded, this, &FeaturesModel::onFeatureChanged );
+      connect( mLayer, &QgsVectorLayer::committedFeaturesAdded, this, &FeaturesModel::onCommittedFeaturesAdded );
+      connect( mLayer, &QgsVectorLayer::featuresDeleted, this, &FeaturesModel::onFeaturesDeleted );
+      connect( mLayer, &QgsVectorLayer::featureDeleted, this, [this]( QgsFeatureId fid ) { onFeaturesDeleted( QgsFeatureIds() << fid ); } );
+      connect( mLayer, &QgsVectorLayer::attributeValueChanged, this, &FeaturesModel::onFeatureChanged );
     }
 
     emit layerFeaturesCountChanged( layerFeaturesCount() );
@@ -13,8 +13,11 @@
 #include <QAbstractListModel>
 #include <QFutureWatcher>
 #include <QAtomicInt>
+#include <QTimer>
 
 #include "qgsvectorlayer.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
 #include "featurelayerpair.h"
 
 #include "inputconfig.h"
@@ -55,6 +58,14 @@ class FeaturesModel : public QAbstractListModel
     // Returns if the model should be sorted according to the layer's attribute table configuration sort order
     Q_PROPERTY( bool useAttributeTableSortOrder MEMBER mUseAttributeTableSortOrder )
 
+    // Returns if the model lists all matching features of the layer (not limited by featuresLimit) and loads
+    // their attributes in pages as the view scrolls (canFetchMore/fetchMore). Meant for browsing large layers.
+    Q_PROPERTY( bool pagedFetching MEMBER mPagedFetching )
+
+    // Returns if the search expression should be evaluated with the layer's in-memory search index (prefix match of words)
+    // instead of a filter expression. The index is built in the background, the filter expression is used until it is ready.
+    Q_PROPERTY( bool useSearchIndex MEMBER mUseSearchIndex )
+
   public:
 
     enum ModelRoles
@@ -77,6 +88,9 @@ class FeaturesModel : public QAbstractListModel
     QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+    bool canFetchMore( const QModelIndex &parent ) const override;
+    void fetchMore( const QModelIndex &parent ) override;
+
     /**
      * \brief populateStatic populates a static model using the supplied \a pairs
      * \param pairs to populate the model with
@@ -142,12 +156,83 @@ class FeaturesModel : public QAbstractListModel
 
     virtual QVariant featureTitle( const FeatureLayerPair &featurePair ) const;
 
+    /**
+     * Fills the model with \a pairs of the current layer instead of fetching them, e.g. from a cache.
+     * With \a partialFeatures the features do not need to have geometry and all attributes,
+     * FeaturePair role then reads the complete feature from the layer.
+     */
+    void setFeatures( const FeatureLayerPairs &pairs, bool partialFeatures );
+
+    /**
+     * Returns attribute \a fieldName of the feature in \a row as stored in the model, e.g. a key of a partial feature.
+     * The layer is queried only for rows without loaded attributes (paged fetching).
+     */
+    QVariant rowAttribute( int row, const QString &fieldName ) const;
+
   private slots:
     void onFutureFinished();
 
+    //! Drops prepared display expressions and memoized titles, e.g. when display expression or project variables change
+    void invalidateFeatureTitles();
+
+    //! Schedules update of a single feature of the layer, changes are applied in batches by applyPendingChanges()
+    void onFeatureChanged( QgsFeatureId fid );
+    void onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &addedFeatures );
+    void onFeaturesDeleted( const QgsFeatureIds &fids );
+
+    /**
+     * Applies scheduled feature changes as targeted row inserts, removals and dataChanged.
+     * Falls back to full populate() when the order of rows could change (sorted request),
+     * when results are still being fetched or when the model is at its features limit.
+     */
+    void applyPendingChanges();
+
   private:
     QString buildSearchExpression();
 
+    //! Returns memoized title of the feature, evaluates it via featureTitle() on the first request
+    QVariant cachedFeatureTitle( const FeatureLayerPair &featurePair ) const;
+
+    //! Updates feature id -> row index for rows starting at \a fromRow
+    void updateFeatureRows( int fromRow = 0 );
+
+    /**
+     * Paged fetching: returns request of the features with \a ids. Features are fetched without geometry
+     * and only with attributes needed for the list (title and search result).
+     */
+    QgsFeatureRequest pageRequest( const QList<QgsFeatureId> &ids ) const;
+
+    //! Paged fetching: schedules loading of attributes of the \a page in the background, unless it is already being loaded
+    void requestPage( int page ) const;
+
+    //! Paged fetching: starts background loading of the requested pages
+    void loadRequestedPages();
+
+    //! Paged fetching: fills rows of features with \a ids with the loaded \a features and marks the \a page as recently used
+    void onPageLoaded( int page, const QList<QgsFeatureId> &ids, const QgsFeatureList &features );
+
+    //! Paged fetching: forgets all ids and pages, loads still running in the background are dropped
+    void resetPages();
+
+    //! Returns features of the \a request, runs in a worker thread. Takes ownership of \a source.
+    static QgsFeatureList fetchPageFeatures( QgsVectorLayerFeatureSource *source, QgsFeatureRequest request );
+
+    //! Paged fetching: keeps at most MAX_LOADED_PAGES pages with attributes, rows of older pages keep only their feature id
+    void evictPages() const;
+
+    //! Static model: watches the layers of the listed features, so that their cached titles do not go stale
+    void watchStaticLayers();
+
+    //! Drops the cached display expression and titles of the layer, e.g. when it is destroyed
+    void removeLayerTitles( QgsVectorLayer *layer, const QString &layerId );
+
+    //! Display expression of a layer prepared together with its expression context, reused for all its features
+    struct DisplayExpression
+    {
+      QgsExpression expression;
+      QgsExpressionContext context;
+    };
+
     //! Performs getFeatures on layer. Takes ownership of \a layer and tries to move it to current thread.
     QgsFeatureList fetchFeatures( QgsVectorLayerFeatureSource *layer, QgsFeatureRequest req, int searchId );
 
@@ -155,8 +240,17 @@ class FeaturesModel : public QAbstractListModel
     QString searchResultPair( const FeatureLayerPair &feat ) const;
 
     const int FEATURES_LIMIT = 10000; //!< Number of maximum features loaded from layer
+    const int PAGE_SIZE = 200; //!< Number of features loaded at once with paged fetching
+    const int MAX_LOADED_PAGES = 10; //!< Number of pages kept with attributes with paged fetching
 
-    FeatureLayerPairs mFeatures;
+    mutable FeatureLayerPairs mFeatures; //!< with paged fetching, rows of evicted pages hold invalid features with only feature id
+    mutable QHash<QPair<QgsVectorLayer *, QgsFeatureId>, QVariant> mFeatureTitles; //!< memoized titles of features in mFeatures
+    mutable QHash<QString, DisplayExpression> mDisplayExpressions; //!< prepared display expressions per layer id
+    QList<QMetaObject::Connection> mStaticLayersConnections; //!< connections to the layers of the static model
+    QHash<QgsFeatureId, int> mFeatureRows; //!< feature id -> row in mFeatures (features of mLayer only), with paged fetching -> index in mFeatureIds
+
+    QSet<QgsFeatureId> mPendingChangedFeatures; //!< features changed in the layer that are not yet reflected in the model
+    QTimer mPendingChangesTimer; //!< coalesces bursts of layer edit signals (e.g. an attribute change per field)
     QString mSearchExpression;
     QgsVectorLayer *mLayer = nullptr;
 
@@ -165,6 +259,16 @@ class FeaturesModel : public QAbstractListModel
     bool mFetchingResults = false;
     bool mUseAttributeTableSortOrder = false;
 
+    bool mPagedFetching = false;
+    bool mPartialFeatures = false; //!< features set by setFeatures() are not complete
+    bool mUseSearchIndex = false;
+    QList<QgsFeatureId> mFeatureIds; //!< paged fetching: ordered ids of all matching features, first rowCount() of them are in mFeatures
+    mutable QList<int> mLoadedPages; //!< paged fetching: pages with attributes loaded, most recently used first
+    mutable QSet<int> mRequestedPages; //!< paged fetching: pages waiting to be loaded in the background
+    mutable QTimer mPageLoadTimer; //!< paged fetching: coalesces page requests of data() calls
+    QSet<int> mLoadingPages; //!< paged fetching: pages being loaded in the background
+    int mPagesGeneration = 0; //!< paged fetching: increased whenever the rows are rebuilt
+
     friend class TestModels;
 };
 
@@ -18,12 +18,18 @@
 #include "qgslogger.h"
 #include "qgsrenderer.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
 
 #include "identifykit.h"
 #include "qgsexpressioncontextutils.h"
 
 #include "qgis.h"
 
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
 IdentifyKit::IdentifyKit( QObject *parent )
   : QObject( parent )
 {
@@ -66,21 +72,32 @@ FeatureLayerPairs IdentifyKit::identify( const QPointF &point, QgsVectorLayer *l
   }
   else
   {
+    QList<LayerQuery> queries;
     for ( QgsMapLayer *layer : mMapSettings->mapSettings().layers() )
     {
       if ( mMapSettings->project() && !layer->flags().testFlag( QgsMapLayer::Identifiable ) )
         continue;
 
       QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer );
-      if ( vl )
-      {
-        QgsFeatureList featureList = identifyVectorLayer( vl, mapPoint );
+      LayerQuery query;
+      if ( vl && prepareQuery( vl, mapPoint, query ) )
+        queries << query;
+    }
+
+    // layers are queried in parallel, results keep the order of layers
+    QList<QgsFeatureList> featureLists;
+    if ( queries.count() == 1 )
+      featureLists << fetchFeatures( queries.first() );
+    else if ( queries.count() > 1 )
+      featureLists = QtConcurrent::blockingMapped<QList<QgsFeatureList>>( queries, &IdentifyKit::fetchFeatures );
 
-        for ( const QgsFeature &feature : featureList )
-        {
-          results.append( FeatureLayerPair( feature, vl ) );
-        }
+    for ( int i = 0; i < featureLists.count(); ++i )
+    {
+      for ( const QgsFeature &feature : featureLists.at( i ) )
+      {
+        results.append( FeatureLayerPair( feature, queries.at( i ).layer ) );
       }
+
       if ( mIdentifyMode == IdentifyMode::TopDownStopAtFirst && !results.isEmpty() )
       {
         QgsDebugMsgLevel( QStringLiteral( "IdentifyKit identified %1 results with TopDownStopAtFirst mode." ).arg( results.count() ), 2 );
@@ -94,21 +111,45 @@ FeatureLayerPairs IdentifyKit::identify( const QPointF &point, QgsVectorLayer *l
   return results;
 }
 
+static double _distanceToRectangle( const QgsRectangle &rect, const QgsPointXY &point )
+{
+  const double dx = std::max( { rect.xMinimum() - point.x(), 0.0, point.x() - rect.xMaximum() } );
+  const double dy = std::max( { rect.yMinimum() - point.y(), 0.0, point.y() - rect.yMaximum() } );
+  return std::sqrt( dx * dx + dy * dy );
+}
+
 static FeatureLayerPair _closestFeature( const FeatureLayerPairs &results, const InputMapSettings &mapSettings, const QPointF &point, double searchRadius )
 {
   QgsPointXY mapPoint = mapSettings.screenToCoordinate( point.toPoint() );
 
   QgsGeometry mapPointGeom( QgsGeometry::fromPointXY( mapPoint ) );
 
+  QHash<QgsVectorLayer *, QgsCoordinateTransform> transforms;
+
   double distMinPoint = 1e10, distMinLine = 1e10, distMinPolygon = 1e10;
   int iMinPoint = -1, iMinLine = -1, iMinPolygon = -1;
   for ( int i = 0; i < results.count(); ++i )
   {
     const FeatureLayerPair &res = results.at( i );
+    const Qgis::GeometryType type = res.feature().geometry().type();
+
+    int &iMin = type == Qgis::GeometryType::Point ? iMinPoint : ( type == Qgis::GeometryType::Line ? iMinLine : iMinPolygon );
+    double &distMin = type == Qgis::GeometryType::Point ? distMinPoint : ( type == Qgis::GeometryType::Line ? distMinLine : distMinPolygon );
+
+    auto transformIt = transforms.find( res.layer() );
+    if ( transformIt == transforms.end() )
+      transformIt = transforms.insert( res.layer(), mapSettings.mapSettings().layerTransform( res.layer() ) );
+
     QgsGeometry geom( res.feature().geometry() );
     try
     {
-      geom.transform( mapSettings.mapSettings().layerTransform( res.layer() ) );
+      // the bounding box is never farther than the geometry itself, so candidates
+      // which can not beat the closest feature so far skip the exact distance
+      const QgsRectangle bbox = transformIt->transformBoundingBox( geom.boundingBox() );
+      if ( _distanceToRectangle( bbox, mapPoint ) >= distMin )
+        continue;
+
+      geom.transform( *transformIt );
     }
     catch ( QgsCsException &e )
     {
@@ -117,31 +158,11 @@ static FeatureLayerPair _closestFeature( const FeatureLayerPairs &results, const
       continue;
     }
 
-    double dist = geom.distance( mapPointGeom );
-    Qgis::GeometryType type = geom.type();
-    if ( type == Qgis::GeometryType::Point )
-    {
-      if ( dist < distMinPoint )
-      {
-        iMinPoint = i;
-        distMinPoint = dist;
-      }
-    }
-    else if ( type == Qgis::GeometryType::Line )
+    const double dist = geom.distance( mapPointGeom );
+    if ( dist < distMin )
     {
-      if ( dist < distMinLine )
-      {
-        iMinLine = i;
-        distMinLine = dist;
-      }
-    }
-    else  // polygons
-    {
-      if ( dist < distMinPolygon )
-      {
-        iMinPolygon = i;
-        distMinPolygon = dist;
-      }
+      iMin = i;
+      distMin = dist;
     }
   }
 
@@ -167,71 +188,93 @@ FeatureLayerPair IdentifyKit::identifyOne( const QPointF &point, QgsVectorLayer
 
 QgsFeatureList IdentifyKit::identifyVectorLayer( QgsVectorLayer *layer, const QgsPointXY &point ) const
 {
-  QgsFeatureList results;
+  LayerQuery query;
+  if ( !prepareQuery( layer, point, query ) )
+    return QgsFeatureList();
+
+  return fetchFeatures( query );
+}
 
+bool IdentifyKit::prepareQuery( QgsVectorLayer *layer, const QgsPointXY &point, LayerQuery &query ) const
+{
   if ( !layer || !layer->isSpatial() )
-    return results;
+    return false;
 
-  if ( !layer->isInScaleRange( mMapSettings->mapSettings().scale() ) )
-    return results;
+  const QgsMapSettings &mapSettings = mMapSettings->mapSettings();
+  if ( !layer->isInScaleRange( mapSettings.scale() ) )
+    return false;
 
-  QgsFeatureList featureList;
+  // create the search rectangle
+  double searchRadius = searchRadiusMU();
+
+  QgsRectangle r;
+  r.setXMinimum( point.x() - searchRadius );
+  r.setXMaximum( point.x() + searchRadius );
+  r.setYMinimum( point.y() - searchRadius );
+  r.setYMaximum( point.y() + searchRadius );
+
+  // do not even start the query when the layer has no data around the point
+  const QgsRectangle layerExtent = layer->extent();
+  if ( !layerExtent.isNull() && !mapSettings.layerExtentToOutputExtent( layer, layerExtent ).intersects( r ) )
+    return false;
 
   // toLayerCoordinates will throw an exception for an 'invalid' point.
   // For example, if you project a world map onto a globe using EPSG 2163
   // and then click somewhere off the globe, an exception will be thrown.
   try
   {
-    // create the search rectangle
-    double searchRadius = searchRadiusMU();
-
-    QgsRectangle r;
-    r.setXMinimum( point.x() - searchRadius );
-    r.setXMaximum( point.x() + searchRadius );
-    r.setYMinimum( point.y() - searchRadius );
-    r.setYMaximum( point.y() + searchRadius );
-
     r = toLayerCoordinates( layer, r );
-
-    QgsFeatureRequest req;
-    req.setFilterRect( r );
-    req.setLimit( mFeaturesLimit );
-    req.setFlags( QgsFeatureRequest::ExactIntersect );
-
-    QgsFeatureIterator fit = layer->getFeatures( req );
-    QgsFeature f;
-    while ( fit.nextFeature( f ) )
-      featureList << QgsFeature( f );
   }
   catch ( QgsCsException &cse )
   {
     QgsDebugError( QStringLiteral( "Invalid point, proceed without a found features." ) );
     Q_UNUSED( cse )
+    return false;
   }
 
-  bool filter = false;
+  query.layer = layer;
+  query.source = std::make_shared<QgsVectorLayerFeatureSource>( layer );
 
-  QgsRenderContext context( QgsRenderContext::fromMapSettings( mMapSettings->mapSettings() ) );
-  context.expressionContext() << QgsExpressionContextUtils::layerScope( layer );
+  query.request.setFilterRect( r );
+  query.request.setLimit( mFeaturesLimit );
+  query.request.setFlags( QgsFeatureRequest::ExactIntersect );
+
+  query.context = QgsRenderContext::fromMapSettings( mapSettings );
+  query.context.expressionContext() << QgsExpressionContextUtils::layerScope( layer );
+
+  // renderer is not thread safe, the query gets its own copy
   QgsFeatureRenderer *renderer = layer->renderer();
-  if ( renderer && renderer->capabilities() & QgsFeatureRenderer::ScaleDependent )
+  if ( renderer && renderer->capabilities() & QgsFeatureRenderer::ScaleDependent && renderer->capabilities() & QgsFeatureRenderer::Filter )
+    query.renderer.reset( renderer->clone() );
+
+  return true;
+}
+
+QgsFeatureList IdentifyKit::fetchFeatures( const LayerQuery &query )
+{
+  QgsFeatureList results;
+
+  QgsRenderContext context( query.context );
+  QgsFeatureRenderer *renderer = query.renderer.get();
+  if ( renderer )
   {
     // setup scale for scale dependent visibility (rule based)
-    renderer->startRender( context, layer->fields() );
-    filter = renderer->capabilities() & QgsFeatureRenderer::Filter;
+    renderer->startRender( context, query.source->fields() );
   }
 
-  for ( const QgsFeature &feature : featureList )
+  QgsFeatureIterator fit = query.source->getFeatures( query.request );
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
   {
-    context.expressionContext().setFeature( feature );
+    context.expressionContext().setFeature( f );
 
-    if ( filter && !renderer->willRenderFeature( const_cast<QgsFeature &>( feature ), context ) )
+    if ( renderer && !renderer->willRenderFeature( f, context ) )
       continue;
 
-    results.append( feature );
+    results << f;
   }
 
-  if ( renderer && renderer->capabilities() & QgsFeatureRenderer::ScaleDependent )
+  if ( renderer )
   {
     renderer->stopRender( context );
   }
@@ -19,9 +19,12 @@
 #include <QObject>
 #include <QPair>
 
+#include <memory>
+
 #include "inputconfig.h"
 
 #include "qgsfeature.h"
+#include "qgsfeaturerequest.h"
 #include "qgsmapsettings.h"
 #include "qgspoint.h"
 #include "qgsrendercontext.h"
@@ -31,6 +34,8 @@
 
 class QgsMapLayer;
 class QgsVectorLayer;
+class QgsVectorLayerFeatureSource;
+class QgsFeatureRenderer;
 
 /**
  * \ingroup quick
@@ -40,6 +45,9 @@ class QgsVectorLayer;
  * - get a list of features in a defined radius from a point.
  * - get a feature with the closest distance to the point
  *
+ * Layers are queried in parallel via their feature sources, layers whose extent
+ * does not intersect the search rectangle are skipped.
+ *
  * \note QML Type: IdentifyKit
  *
  * \since QGIS 3.4
@@ -159,6 +167,17 @@ class  IdentifyKit : public QObject
     void identifyModeChanged();
 
   private:
+
+    //! Everything needed to fetch the identified features of one layer outside of the main thread
+    struct LayerQuery
+    {
+      QgsVectorLayer *layer = nullptr;
+      std::shared_ptr<QgsVectorLayerFeatureSource> source;
+      QgsFeatureRequest request;
+      std::shared_ptr<QgsFeatureRenderer> renderer; //!< set only when the renderer filters features by scale
+      QgsRenderContext context;
+    };
+
     InputMapSettings *mMapSettings = nullptr; // not owned
 
     double searchRadiusMU( const QgsRenderContext &context ) const;
@@ -167,6 +186,15 @@ class  IdentifyKit : public QObject
     QgsRectangle toLayerCoordinates( QgsMapLayer *layer, const QgsRectangle &rect ) const;
     QgsFeatureList identifyVectorLayer( QgsVectorLayer *layer, const QgsPointXY &point ) const;
 
+    /**
+     * Prepares \a query of features of the \a layer around the \a point (in map coordinates).
+     * Needs to be called from the main thread. Returns FALSE if the layer can not have any results.
+     */
+    bool prepareQuery( QgsVectorLayer *layer, const QgsPointXY &point, LayerQuery &query ) const;
+
+    //! Fetches features of the prepared \a query, safe to be called from any thread
+    static QgsFeatureList fetchFeatures( const LayerQuery &query );
+
     double mSearchRadiusMm = 5;
     int mFeaturesLimit = 100;
     IdentifyMode mIdentifyMode = IdentifyMode::TopDownAll;
@@ -0,0 +1,302 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "lookuptable.h"
+#include "coreutils.h"
+
+#include "qgis.h"
+#include "qgsproject.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
+#include "qgsexpressioncontextutils.h"
+#include "qgsrelationmanager.h"
+#include "qgsvaluerelationfieldformatter.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include <numeric>
+
+LookupTable *LookupTable::forLayer( QgsVectorLayer *layer, const QString &keyField, const QString &valueField )
+{
+  if ( !layer || !layer->isValid() || layer->fields().indexOf( keyField ) < 0 )
+    return nullptr;
+
+  if ( !valueField.isEmpty() && layer->fields().indexOf( valueField ) < 0 )
+    return nullptr;
+
+  const QList<LookupTable *> tables = layer->findChildren<LookupTable *>( QString(), Qt::FindDirectChildrenOnly );
+  for ( LookupTable *table : tables )
+  {
+    if ( table->mKeyField == keyField && table->mValueField == valueField )
+      return table;
+  }
+
+  return new LookupTable( layer, keyField, valueField );
+}
+
+void LookupTable::prepareProjectTables( QgsProject *project )
+{
+  if ( !project )
+    return;
+
+  const QList<QgsVectorLayer *> layers = project->layers<QgsVectorLayer *>();
+  for ( QgsVectorLayer *layer : layers )
+  {
+    const QgsFields fields = layer->fields();
+    for ( int i = 0; i < fields.count(); ++i )
+    {
+      const QgsEditorWidgetSetup setup = layer->editorWidgetSetup( i );
+
+      if ( setup.type() == QStringLiteral( "ValueRelation" ) )
+      {
+        const QVariantMap config = setup.config();
+        QgsVectorLayer *lookupLayer = QgsValueRelationFieldFormatter::resolveLayer( config, project );
+        forLayer( lookupLayer, config.value( QStringLiteral( "Key" ) ).toString(), config.value( QStringLiteral( "Value" ) ).toString() );
+      }
+      else if ( setup.type() == QStringLiteral( "RelationReference" ) )
+      {
+        const QgsRelation relation = project->relationManager()->relation( setup.config().value( QStringLiteral( "Relation" ) ).toString() );
+        if ( relation.isValid() && !relation.fieldPairs().isEmpty() )
+          forLayer( relation.referencedLayer(), relation.fieldPairs().at( 0 ).second, QString() );
+      }
+    }
+  }
+}
+
+LookupTable::LookupTable( QgsVectorLayer *layer, const QString &keyField, const QString &valueField )
+  : QObject( layer )
+  , mLayer( layer )
+  , mKeyField( keyField )
+  , mValueField( valueField )
+{
+  connect( &mBuildWatcher, &QFutureWatcher<Columns>::finished, this, &LookupTable::onBuildFinished );
+
+  connect( mLayer, &QgsVectorLayer::afterCommitChanges, this, &LookupTable::rebuild );
+  connect( mLayer, &QgsVectorLayer::afterRollBack, this, &LookupTable::rebuild );
+  connect( mLayer, &QgsVectorLayer::updatedFields, this, &LookupTable::rebuild );
+  connect( mLayer, &QgsVectorLayer::displayExpressionChanged, this, &LookupTable::rebuild );
+
+  rebuild();
+}
+
+LookupTable::~LookupTable()
+{
+  // the worker owns its feature source, it finishes on its own without blocking the UI thread
+  cancelBuild();
+}
+
+bool LookupTable::isReady() const
+{
+  return mIsReady;
+}
+
+int LookupTable::count() const
+{
+  return mColumns.fids.count();
+}
+
+void LookupTable::rebuild()
+{
+  mIsReady = false;
+  cancelBuild();
+
+  const int keyIndex = mLayer->fields().indexOf( mKeyField );
+  const int valueIndex = mValueField.isEmpty() ? -1 : mLayer->fields().indexOf( mValueField );
+
+  // the context needs to be created in the main thread, the worker only evaluates it
+  QgsExpressionContext context( QgsExpressionContextUtils::globalProjectLayerScopes( mLayer ) );
+  QgsVectorLayerFeatureSource *source = new QgsVectorLayerFeatureSource( mLayer );
+
+  mBuildCanceled = std::make_shared<std::atomic_bool>( false );
+  mBuildWatcher.setFuture( QtConcurrent::run( &LookupTable::readColumns, source, keyIndex, valueIndex, mLayer->displayExpression(), context, mBuildCanceled ) );
+}
+
+void LookupTable::cancelBuild()
+{
+  if ( mBuildCanceled )
+    *mBuildCanceled = true;
+}
+
+void LookupTable::onBuildFinished()
+{
+  if ( mBuildWatcher.isCanceled() || !mBuildCanceled || *mBuildCanceled )
+    return;
+
+  mColumns = mBuildWatcher.result();
+  mFilterRows.clear();
+
+  mRowByFid.clear();
+  mRowByFid.reserve( mColumns.fids.count() );
+  for ( int row = 0; row < mColumns.fids.count(); ++row )
+  {
+    mRowByFid.insert( mColumns.fids.at( row ), row );
+  }
+
+  mIsReady = true;
+  emit ready();
+}
+
+LookupTable::Columns LookupTable::readColumns( QgsVectorLayerFeatureSource *source, int keyIndex, int valueIndex, const QString &displayExpression,
+    QgsExpressionContext context, std::shared_ptr<std::atomic_bool> canceled )
+{
+  std::unique_ptr<QgsVectorLayerFeatureSource> fs( source );
+  Columns columns;
+
+  QElapsedTimer t;
+  t.start();
+
+  QgsFeatureRequest request;
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+
+  QgsExpression expression( displayExpression );
+  if ( valueIndex >= 0 )
+  {
+    request.setSubsetOfAttributes( QgsAttributeList() << keyIndex << valueIndex );
+  }
+  else
+  {
+    expression.prepare( &context );
+    if ( expression.needsGeometry() )
+      request.setFlags( QgsFeatureRequest::NoFlags );
+  }
+
+  QgsFeatureIterator it = fs->getFeatures( request );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( *canceled )
+    {
+      CoreUtils::log( QStringLiteral( "Lookup table" ), QStringLiteral( "Reading canceled after %1 rows" ).arg( columns.fids.count() ) );
+      return columns;
+    }
+
+    if ( FID_IS_NEW( f.id() ) || FID_IS_NULL( f.id() ) )
+      continue; // ignore uncommited features, like FeaturesModel does
+
+    columns.fids << f.id();
+    columns.keys << f.attribute( keyIndex );
+
+    if ( valueIndex >= 0 )
+    {
+      columns.values << f.attribute( valueIndex );
+    }
+    else
+    {
+      context.setFeature( f );
+      columns.values << expression.evaluate( &context );
+    }
+  }
+
+  CoreUtils::log( QStringLiteral( "Lookup table" ), QStringLiteral( "Read %1 rows in %2 ms" ).arg( columns.fids.count() ).arg( t.elapsed() ) );
+  return columns;
+}
+
+bool LookupTable::isCacheableFilter( const QString &filterExpression )
+{
+  // functions whose result changes between evaluations of the same expression
+  static const QSet<QString> sVolatileFunctions =
+  {
+    QStringLiteral( "now" ), QStringLiteral( "$now" ), QStringLiteral( "rand" ), QStringLiteral( "randf" ),
+    QStringLiteral( "uuid" ), QStringLiteral( "$uuid" ), QStringLiteral( "eval" )
+  };
+
+  const QgsExpression expression( filterExpression );
+  if ( expression.hasParserError() || !expression.referencedVariables().isEmpty() )
+    return false;
+
+  const QSet<QString> functions = expression.referencedFunctions();
+  for ( const QString &function : functions )
+  {
+    if ( sVolatileFunctions.contains( function.toLower() ) )
+      return false;
+  }
+
+  return true;
+}
+
+QVector<int> LookupTable::rows( const QString &filterExpression, bool orderByValue )
+{
+  QVector<int> result;
+
+  if ( filterExpression.isEmpty() )
+  {
+    result.resize( mColumns.fids.count() );
+    std::iota( result.begin(), result.end(), 0 );
+  }
+  else if ( mFilterRows.contains( filterExpression ) )
+  {
+    result = mFilterRows.value( filterExpression );
+  }
+  else
+  {
+    // evaluate a cacheable filter only once for all the widgets that share it
+    QgsFeatureRequest request;
+    request.setFilterExpression( filterExpression );
+    request.setExpressionContext( QgsExpressionContext( QgsExpressionContextUtils::globalProjectLayerScopes( mLayer ) ) );
+    request.setFlags( QgsFeatureRequest::NoGeometry );
+    request.setNoAttributes();
+
+    QgsFeatureIterator it = mLayer->getFeatures( request );
+    QgsFeature f;
+    while ( it.nextFeature( f ) )
+    {
+      const int row = mRowByFid.value( f.id(), -1 );
+      if ( row >= 0 )
+        result << row;
+    }
+
+    std::sort( result.begin(), result.end() );
+    if ( isCacheableFilter( filterExpression ) )
+      mFilterRows.insert( filterExpression, result );
+  }
+
+  if ( orderByValue )
+  {
+    std::stable_sort( result.begin(), result.end(), [this]( int a, int b )
+    {
+      return qgsVariantLessThan( mColumns.values.at( a ), mColumns.values.at( b ) );
+    } );
+  }
+
+  return result;
+}
+
+FeatureLayerPairs LookupTable::features( const QVector<int> &rows ) const
+{
+  FeatureLayerPairs pairs;
+  pairs.reserve( rows.count() );
+
+  const QgsFields fields = mLayer->fields();
+  const int keyIndex = fields.indexOf( mKeyField );
+  const int valueIndex = mValueField.isEmpty() ? -1 : fields.indexOf( mValueField );
+
+  for ( int row : rows )
+  {
+    QgsFeature f( fields, mColumns.fids.at( row ) );
+    f.initAttributes( fields.count() );
+    f.setAttribute( keyIndex, mColumns.keys.at( row ) );
+    if ( valueIndex >= 0 )
+      f.setAttribute( valueIndex, mColumns.values.at( row ) );
+    f.setValid( true );
+
+    pairs << FeatureLayerPair( f, mLayer );
+  }
+
+  return pairs;
+}
+
+QVariant LookupTable::value( QgsFeatureId fid ) const
+{
+  const int row = mRowByFid.value( fid, -1 );
+  if ( row < 0 )
+    return QVariant();
+
+  return mColumns.values.at( row );
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LOOKUPTABLE_H
+#define LOOKUPTABLE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QFutureWatcher>
+
+#include <atomic>
+#include <memory>
+
+#include "qgsfeature.h"
+#include "qgsexpressioncontext.h"
+#include "featurelayerpair.h"
+
+#include "inputconfig.h"
+
+class QgsProject;
+class QgsVectorLayer;
+class QgsVectorLayerFeatureSource;
+
+/**
+ * In-memory copy of key and value columns of a lookup layer used by value relation
+ * and relation reference editors. It is shared by all form widgets using the same layer
+ * and columns (the table is owned by the layer), use forLayer() to get it.
+ *
+ * The table is built in the background and rebuilt whenever edits of the layer are committed.
+ * A running build is canceled (not waited for) when the table is destroyed or rebuilt.
+ * Rows matching a filter expression are evaluated once per expression and kept until the table is rebuilt,
+ * unless the expression uses variables or volatile functions (like now()) and can match other rows next time.
+ */
+class LookupTable : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    /**
+     * Returns lookup table of \a layer with \a keyField and \a valueField columns, creates it if it does not exist yet.
+     * Empty \a valueField means values are evaluated from the layer's display expression.
+     */
+    static LookupTable *forLayer( QgsVectorLayer *layer, const QString &keyField, const QString &valueField );
+
+    //! Starts to build lookup tables for all value relation and relation reference widgets of the \a project
+    static void prepareProjectTables( QgsProject *project );
+
+    virtual ~LookupTable();
+
+    //! Returns true if the table is built and can be used
+    bool isReady() const;
+
+    int count() const;
+
+    /**
+     * Returns rows of the features matching \a filterExpression (all rows for an empty expression).
+     * The expression must not depend on the form scope. Rows are in the layer order or sorted by value if \a orderByValue is set.
+     */
+    QVector<int> rows( const QString &filterExpression, bool orderByValue = false );
+
+    /**
+     * Returns features of the \a rows. Features contain only the key and value attributes,
+     * full features have to be read from the layer when needed.
+     */
+    FeatureLayerPairs features( const QVector<int> &rows ) const;
+
+    //! Returns value of the feature with \a fid, invalid variant if it is not in the table
+    QVariant value( QgsFeatureId fid ) const;
+
+  signals:
+    //! Emitted whenever the table has been (re)built
+    void ready();
+
+  private slots:
+    void rebuild();
+    void onBuildFinished();
+
+  private:
+    LookupTable( QgsVectorLayer *layer, const QString &keyField, const QString &valueField );
+
+    struct Columns
+    {
+      QVector<QgsFeatureId> fids;
+      QVector<QVariant> keys;
+      QVector<QVariant> values;
+    };
+
+    //! Returns true if rows matching \a filterExpression depend only on the attributes and can be cached
+    static bool isCacheableFilter( const QString &filterExpression );
+
+    /**
+     * Reads the columns from \a source, runs in a worker thread. Takes ownership of \a source.
+     * Stops early (with incomplete columns) once \a canceled is set.
+     */
+    static Columns readColumns( QgsVectorLayerFeatureSource *source, int keyIndex, int valueIndex, const QString &displayExpression,
+                                QgsExpressionContext context, std::shared_ptr<std::atomic_bool> canceled );
+
+    //! Asks the running build (if any) to stop, its result is discarded
+    void cancelBuild();
+
+    QgsVectorLayer *mLayer = nullptr; // parent
+    QString mKeyField;
+    QString mValueField;
+
+    Columns mColumns;
+    QHash<QgsFeatureId, int> mRowByFid;
+    QHash<QString, QVector<int>> mFilterRows; //!< rows of the already evaluated cacheable filter expressions
+
+    QFutureWatcher<Columns> mBuildWatcher;
+    std::shared_ptr<std::atomic_bool> mBuildCanceled;
+    bool mIsReady = false;
+
+    friend class TestModels;
+};
+
+#endif // LOOKUPTABLE_H
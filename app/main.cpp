@@ -86,6 +86,7 @@
 
 #include "inputmapcanvasmap.h"
 #include "inputmapsettings.h"
+#include "maprenderprofiler.h"
 #include "inputmaptransform.h"
 
 #include "position/positionkit.h"
@@ -341,6 +342,7 @@ void initDeclarative()
   qmlRegisterType< InputMapSettings >( "mm", 1, 0, "MapSettings" );
   qmlRegisterType< InputMapTransform >( "mm", 1, 0, "MapTransform" );
   qmlRegisterType< InputCoordinateTransformer >( "mm", 1, 0, "CoordinateTransformer" );
+  qmlRegisterUncreatableType< MapRenderProfiler >( "mm", 1, 0, "MapRenderProfiler", "Must be accessed via MapCanvasMap" );
   qmlRegisterUncreatableType< AbstractPositionProvider >( "mm", 1, 0, "PositionProvider", "Must be instantiated via its construct method" );
 
   // map tools
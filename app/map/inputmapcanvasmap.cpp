@@ -27,6 +27,7 @@
 #include "qgsannotationlayer.h"
 #include "qgsvectorlayer.h"
 #include "qgslabelingresults.h"
+#include "qgsvectorsimplifymethod.h"
 
 #include "inputmapcanvasmap.h"
 #include "inputmapsettings.h"
@@ -36,14 +37,22 @@ InputMapCanvasMap::InputMapCanvasMap( QQuickItem *parent )
   : QQuickItem( parent )
   , mMapSettings( std::make_unique<InputMapSettings>() )
   , mCache( std::make_unique<QgsMapRendererCache>() )
+  , mRenderProfiler( std::make_unique<MapRenderProfiler>() )
+  , mTileCache( std::make_unique<MapTileCache>() )
 {
   connect( this, &QQuickItem::windowChanged, this, &InputMapCanvasMap::onWindowChanged );
   connect( &mRefreshTimer, &QTimer::timeout, this, [ = ] { refreshMap(); } );
   connect( &mMapUpdateTimer, &QTimer::timeout, this, &InputMapCanvasMap::renderJobUpdated );
+  connect( &mPreviewTimer, &QTimer::timeout, this, &InputMapCanvasMap::renderPreview );
 
   connect( mMapSettings.get(), &InputMapSettings::extentChanged, this, &InputMapCanvasMap::onExtentChanged );
   connect( mMapSettings.get(), &InputMapSettings::layersChanged, this, &InputMapCanvasMap::onLayersChanged );
   connect( mMapSettings.get(), &InputMapSettings::temporalStateChanged, this, &InputMapCanvasMap::onTemporalStateChanged );
+  connect( mMapSettings.get(), &InputMapSettings::destinationCrsChanged, this, &InputMapCanvasMap::invalidateTiles );
+  connect( mMapSettings.get(), &InputMapSettings::outputDpiChanged, this, &InputMapCanvasMap::invalidateTiles );
+  connect( mMapSettings.get(), &InputMapSettings::backgroundColorChanged, this, &InputMapCanvasMap::invalidateTiles );
+
+  connect( mTileCache.get(), &MapTileCache::tileRendered, this, &QQuickItem::update );
 
   connect( this, &InputMapCanvasMap::renderStarting, this, &InputMapCanvasMap::isRenderingChanged );
   connect( this, &InputMapCanvasMap::mapCanvasRefreshed, this, &InputMapCanvasMap::isRenderingChanged );
@@ -51,12 +60,21 @@ InputMapCanvasMap::InputMapCanvasMap( QQuickItem *parent )
   mMapUpdateTimer.setSingleShot( false );
   mMapUpdateTimer.setInterval( 250 );
   mRefreshTimer.setSingleShot( true );
+  mPreviewTimer.setSingleShot( true );
+  mPreviewTimer.setInterval( mMapUpdateTimer.interval() );
   setTransformOrigin( QQuickItem::TopLeft );
   setFlags( QQuickItem::ItemHasContents );
 }
 
 InputMapCanvasMap::~InputMapCanvasMap()
 {
+  // feature counting of the profiler runs in render threads, wait for them before the profiler is gone
+  if ( mJob && mRenderProfiler->isEnabled() )
+  {
+    disconnect( mJob, nullptr, this, nullptr );
+    mJob->cancel();
+  }
+
   stopRendering();
 }
 
@@ -98,13 +116,9 @@ void InputMapCanvasMap::pan( QPointF oldPos, QPointF newPos )
   mMapSettings->setExtent( extent );
 }
 
-void InputMapCanvasMap::refreshMap()
+QgsMapSettings InputMapCanvasMap::prepareMapSettings() const
 {
-  stopRendering(); // if any...
-
   QgsMapSettings mapSettings = mMapSettings->mapSettings();
-  if ( !mapSettings.hasValidSettings() )
-    return;
 
   //build the expression context
   QgsExpressionContext expressionContext;
@@ -131,6 +145,42 @@ void InputMapCanvasMap::refreshMap()
   // with incremental rendering - enables updates of partially rendered layers (good for WMTS, XYZ layers)
   mapSettings.setFlag( Qgis::MapSettingsFlag::RenderPartialOutput, mIncrementalRendering );
 
+  return mapSettings;
+}
+
+QgsMapSettings InputMapCanvasMap::preparePreviewMapSettings() const
+{
+  // fresh settings, the feature counter of the profiler must not count the preview
+  QgsMapSettings mapSettings = prepareMapSettings();
+
+  // fewer pixels, coarser geometries and no label placement
+  mapSettings.setDevicePixelRatio( mapSettings.devicePixelRatio() * PREVIEW_PIXEL_RATIO );
+  mapSettings.setFlag( Qgis::MapSettingsFlag::Antialiasing, false );
+  mapSettings.setFlag( Qgis::MapSettingsFlag::DrawLabeling, false );
+  mapSettings.setFlag( Qgis::MapSettingsFlag::RenderPartialOutput, false );
+
+  QgsVectorSimplifyMethod simplifyMethod = mapSettings.simplifyMethod();
+  simplifyMethod.setSimplifyHints( QgsVectorSimplifyMethod::GeometrySimplification );
+  simplifyMethod.setThreshold( PREVIEW_SIMPLIFY_THRESHOLD );
+  mapSettings.setSimplifyMethod( simplifyMethod );
+
+  return mapSettings;
+}
+
+void InputMapCanvasMap::refreshMap()
+{
+  stopRendering(); // if any...
+
+  if ( !mMapSettings->mapSettings().hasValidSettings() )
+    return;
+
+  QgsMapSettings mapSettings = prepareMapSettings();
+
+  // handlers can not be removed from map settings, the image (and tiles prefetched from it)
+  // keep the settings without the feature counter of the profiler
+  mJobMapSettings = mapSettings;
+  mRenderProfiler->prepareSettings( mapSettings );
+
   // create the renderer job
   Q_ASSERT( !mJob );
   mJob = new QgsMapRendererParallelJob( mapSettings );
@@ -140,8 +190,11 @@ void InputMapCanvasMap::refreshMap()
 
   connect( mJob, &QgsMapRendererJob::renderingLayersFinished, this, &InputMapCanvasMap::renderJobUpdated );
   connect( mJob, &QgsMapRendererJob::finished, this, &InputMapCanvasMap::renderJobFinished );
+  connect( mJob, &QgsMapRendererJob::layerRenderingStarted, this, &InputMapCanvasMap::onLayerRenderingStarted );
+  connect( mJob, &QgsMapRendererJob::layerRendered, this, &InputMapCanvasMap::onLayerRendered );
   mJob->setCache( mCache.get() );
 
+  mRenderProfiler->jobStarted( mJob, mCache.get() );
   mJob->start();
 
   if ( !mSilentRefresh )
@@ -155,9 +208,20 @@ void InputMapCanvasMap::renderJobUpdated()
   if ( !mJob )
     return;
 
+  const QgsMapSettings jobSettings = mJobMapSettings;
+  const bool sameFrame = !mImage.isNull()
+                         && mImageMapSettings.visibleExtent() == jobSettings.visibleExtent()
+                         && mImageMapSettings.deviceOutputSize() == jobSettings.deviceOutputSize();
+
   mImage = mJob->renderedImage();
-  mImageMapSettings = mJob->mapSettings();
-  mDirty = true;
+  mImageMapSettings = jobSettings;
+
+  // within the same frame only the layers rendered since the last update changed
+  if ( sameFrame )
+    mDirtyRect |= renderedLayersRect();
+  else
+    mDirty = true;
+  mRenderedLayers.clear();
   // Temporarily freeze the canvas, we only need to reset the geometry but not trigger a repaint
   bool freeze = mFreeze;
   mFreeze = true;
@@ -178,13 +242,20 @@ void InputMapCanvasMap::renderJobFinished()
     QgsMessageLog::logMessage( QStringLiteral( "%1 :: %2" ).arg( error.layerID, error.message ), QStringLiteral( "Rendering" ) );
   }
 
+  mRenderProfiler->jobFinished( mJob );
+
   // take labeling results before emitting renderComplete, so labeling map tools
   // connected to signal work with correct results
   delete mLabelingResults;
   mLabelingResults = mJob->takeLabelingResults();
 
   mImage = mJob->renderedImage();
-  mImageMapSettings = mJob->mapSettings();
+  mImageMapSettings = mJobMapSettings;
+  mRenderingLayers.clear();
+  mRenderedLayers.clear();
+
+  // the map is idle now, render tiles around the extent for the next gesture
+  mTileCache->prefetch( mImageMapSettings );
 
   // now we are in a slot called from mJob - do not delete it immediately
   // so the class is still valid when the execution returns to the class
@@ -217,8 +288,104 @@ void InputMapCanvasMap::renderJobFinished()
   }
 }
 
+void InputMapCanvasMap::onLayerRenderingStarted( const QString &layerId )
+{
+  mRenderingLayers << layerId;
+}
+
+void InputMapCanvasMap::onLayerRendered( const QString &layerId )
+{
+  mRenderingLayers.removeOne( layerId );
+  mRenderedLayers << layerId;
+}
+
+QRect InputMapCanvasMap::renderedLayersRect() const
+{
+  const QRect imageRect = mImage.rect();
+  const QgsMapToPixel &mapToPixel = mImageMapSettings.mapToPixel();
+  const double pixelRatio = mImageMapSettings.devicePixelRatio();
+  const QList<QgsMapLayer *> layers = mImageMapSettings.layers();
+
+  // layers still in progress may have drawn partial output too
+  QRect dirtyRect;
+  const QStringList layerIds = mRenderingLayers + mRenderedLayers;
+  for ( const QString &layerId : layerIds )
+  {
+    auto it = std::find_if( layers.constBegin(), layers.constEnd(), [&layerId]( const QgsMapLayer * layer ) { return layer && layer->id() == layerId; } );
+    if ( it == layers.constEnd() || ( *it )->extent().isNull() )
+      return imageRect;
+
+    // symbols may exceed the extent of the features
+    const QgsRectangle extent = mImageMapSettings.layerExtentToOutputExtent( *it, ( *it )->extent() );
+    const QgsPointXY topLeft = mapToPixel.transform( extent.xMinimum(), extent.yMaximum() );
+    const QgsPointXY bottomRight = mapToPixel.transform( extent.xMaximum(), extent.yMinimum() );
+    const QRectF layerRect( topLeft.toQPointF() * pixelRatio, bottomRight.toQPointF() * pixelRatio );
+    const int margin = static_cast<int>( std::ceil( DIRTY_RECT_MARGIN * pixelRatio ) );
+
+    dirtyRect |= layerRect.normalized().toAlignedRect().adjusted( -margin, -margin, margin, margin ) & imageRect;
+  }
+
+  return dirtyRect;
+}
+
+void InputMapCanvasMap::renderPreview()
+{
+  if ( !mFreeze || !mIncrementalRendering )
+    return;
+
+  if ( mPreviewJob )
+  {
+    // the extent changed again while rendering, render it once the current preview finishes
+    mPreviewPending = true;
+    return;
+  }
+
+  if ( !mMapSettings->mapSettings().hasValidSettings() )
+    return;
+
+  // the preview is not stored in the layer cache, its images have lower resolution than the cache expects
+  mPreviewJob = new QgsMapRendererParallelJob( preparePreviewMapSettings() );
+  connect( mPreviewJob, &QgsMapRendererJob::finished, this, &InputMapCanvasMap::previewJobFinished );
+  mPreviewJob->start();
+}
+
+void InputMapCanvasMap::previewJobFinished()
+{
+  if ( !mPreviewJob )
+    return;
+
+  mImage = mPreviewJob->renderedImage();
+  mImageMapSettings = mPreviewJob->mapSettings();
+
+  // now we are in a slot called from the job - do not delete it immediately
+  mPreviewJob->deleteLater();
+  mPreviewJob = nullptr;
+  mDirty = true;
+
+  // Temporarily freeze the canvas, we only need to reset the geometry but not trigger a repaint
+  bool freeze = mFreeze;
+  mFreeze = true;
+  updateTransform();
+  mFreeze = freeze;
+
+  update();
+  emit mapPreviewRendered();
+
+  if ( mPreviewPending )
+  {
+    mPreviewPending = false;
+    if ( !mPreviewTimer.isActive() )
+      mPreviewTimer.start();
+  }
+}
+
 void InputMapCanvasMap::layerRepaintRequested( bool deferred )
 {
+  // QgsMapRendererCache drops the image of the layer (and labels depending on it) on its own,
+  // other layers are taken from the cache. Cached tiles are outdated even if the map is not going
+  // to be refreshed now, but they are still better than nothing until they get rendered again.
+  mTileCache->setStale();
+
   if ( mMapSettings->outputSize().isNull() )
     return; // the map image size has not been set yet
 
@@ -269,6 +436,7 @@ void InputMapCanvasMap::onScreenChanged( QScreen *screen )
       mMapSettings->setDevicePixelRatio( screen->devicePixelRatio() );
     }
     mMapSettings->setOutputDpi( screen->physicalDotsPerInch() );
+    invalidateTiles();
   }
 }
 
@@ -276,6 +444,13 @@ void InputMapCanvasMap::onExtentChanged()
 {
   updateTransform();
 
+  // show cached tiles in the newly uncovered areas
+  update();
+
+  // during gestures, a quick preview is rendered at most once per update interval
+  if ( mFreeze && mIncrementalRendering && !mPreviewTimer.isActive() )
+    mPreviewTimer.start();
+
   // And trigger a new rendering job
   refresh();
 }
@@ -285,6 +460,9 @@ void InputMapCanvasMap::onTemporalStateChanged()
 {
   clearTemporalCache();
 
+  // temporal layers do not request a repaint, the layer images of the tiles would be reused
+  invalidateTiles();
+
   // And trigger a new rendering job
   refresh();
 }
@@ -311,6 +489,7 @@ void InputMapCanvasMap::setMapUpdateInterval( int mapUpdateInterval )
     return;
 
   mMapUpdateTimer.setInterval( mapUpdateInterval );
+  mPreviewTimer.setInterval( mapUpdateInterval );
 
   emit mapUpdateIntervalChanged();
 }
@@ -329,6 +508,11 @@ void InputMapCanvasMap::setIncrementalRendering( bool incrementalRendering )
   emit incrementalRenderingChanged();
 }
 
+MapRenderProfiler *InputMapCanvasMap::renderProfiler() const
+{
+  return mRenderProfiler.get();
+}
+
 bool InputMapCanvasMap::freeze() const
 {
   return mFreeze;
@@ -356,26 +540,30 @@ bool InputMapCanvasMap::isRendering() const
 
 QSGNode *InputMapCanvasMap::updatePaintNode( QSGNode *oldNode, QQuickItem::UpdatePaintNodeData * )
 {
-  if ( mDirty )
+  QSGNode *root = oldNode;
+  if ( !root )
   {
-    delete oldNode;
-    oldNode = nullptr;
-    mDirty = false;
+    // the scene graph has been (re)created, previous nodes are gone
+    root = new QSGNode();
+    mTilesNode = new QSGNode();
+    mImageNode = new QSGNode();
+    root->appendChildNode( mTilesNode );
+    root->appendChildNode( mImageNode );
+    mTileNodes.clear();
+    mImageCells.clear();
+    mImageCellsSize = QSize();
+    mDirty = true;
   }
 
-  QSGSimpleTextureNode *node = static_cast<QSGSimpleTextureNode *>( oldNode );
-  if ( !node )
-  {
-    node = new QSGSimpleTextureNode();
-    QSGTexture *texture = window()->createTextureFromImage( mImage );
-    node->setTexture( texture );
-    node->setOwnsTexture( true );
-  }
+  // tiles are below the map image, they only fill areas not covered by it
+  updateTileNodes( mTilesNode );
+
+  updateImageCells();
 
   QRectF rect( boundingRect() );
   QSizeF size = mImage.size();
   if ( !size.isEmpty() )
-    size /= mMapSettings->devicePixelRatio();
+    size /= mImageMapSettings.devicePixelRatio(); // previews have lower ratio than the map
 
   // Check for resizes that change the w/h ratio
   if ( !rect.isEmpty() && !size.isEmpty() && !qgsDoubleNear( rect.width() / rect.height(), ( size.width() ) / static_cast<double>( size.height() ), 3 ) )
@@ -390,9 +578,116 @@ QSGNode *InputMapCanvasMap::updatePaintNode( QSGNode *oldNode, QQuickItem::Updat
     }
   }
 
-  node->setRect( rect );
+  // cells of the image are laid out proportionally within the image rect
+  if ( !mImageCellsSize.isEmpty() )
+  {
+    const double scaleX = rect.width() / mImageCellsSize.width();
+    const double scaleY = rect.height() / mImageCellsSize.height();
+    for ( const ImageCell &cell : std::as_const( mImageCells ) )
+    {
+      cell.node->setRect( QRectF( rect.x() + cell.rect.x() * scaleX, rect.y() + cell.rect.y() * scaleY, cell.rect.width() * scaleX, cell.rect.height() * scaleY ) );
+    }
+  }
 
-  return node;
+  return root;
+}
+
+void InputMapCanvasMap::updateImageCells()
+{
+  const QRect imageRect = mImage.rect();
+
+  if ( mImage.size() != mImageCellsSize )
+  {
+    for ( const ImageCell &cell : std::as_const( mImageCells ) )
+    {
+      delete cell.node;
+    }
+    mImageCells.clear();
+
+    for ( int y = 0; y < imageRect.height(); y += IMAGE_CELL_SIZE )
+    {
+      for ( int x = 0; x < imageRect.width(); x += IMAGE_CELL_SIZE )
+      {
+        ImageCell cell;
+        cell.rect = QRect( x, y, IMAGE_CELL_SIZE, IMAGE_CELL_SIZE ) & imageRect;
+        cell.node = new QSGSimpleTextureNode();
+        cell.node->setOwnsTexture( true );
+        mImageNode->appendChildNode( cell.node );
+        mImageCells << cell;
+      }
+    }
+
+    mImageCellsSize = mImage.size();
+    mDirty = true;
+  }
+
+  const QRect dirtyRect = mDirty ? imageRect : mDirtyRect & imageRect;
+  mDirty = false;
+  mDirtyRect = QRect();
+
+  // only textures of the changed cells are uploaded again, the node releases the previous texture
+  for ( const ImageCell &cell : std::as_const( mImageCells ) )
+  {
+    if ( cell.rect.intersects( dirtyRect ) )
+      cell.node->setTexture( window()->createTextureFromImage( mImage.copy( cell.rect ) ) );
+  }
+}
+
+void InputMapCanvasMap::updateTileNodes( QSGNode *tilesNode )
+{
+  QHash<MapTileCache::TileKey, TileNode> nodes;
+
+  // tiles are positioned in the coordinates of the rendered image, the item itself is transformed to the current extent
+  if ( mImageMapSettings.hasValidSettings() && mMapSettings->mapSettings().hasValidSettings() && qgsDoubleNear( mMapSettings->rotation(), 0 ) )
+  {
+    const QgsMapSettings settings = mMapSettings->mapSettings();
+    const QgsRectangle visibleExtent = settings.visibleExtent();
+    const int zoom = MapTileCache::zoomLevel( settings.mapUnitsPerPixel() );
+    const QgsMapToPixel &mapToPixel = mImageMapSettings.mapToPixel();
+
+    // adjacent levels first, so that tiles of the current level are drawn above them
+    for ( int level : { zoom + 1, zoom - 1, zoom } )
+    {
+      const QList<MapTileCache::TileKey> keys = MapTileCache::tilesInExtent( visibleExtent, level );
+      for ( const MapTileCache::TileKey &key : keys )
+      {
+        // stale tiles are shown too until they are rendered again
+        const MapTileCache::Tile *tile = mTileCache->tile( key );
+        if ( !tile )
+          continue;
+
+        TileNode tileNode = mTileNodes.take( key );
+        if ( tileNode.node && tileNode.revision == tile->revision )
+        {
+          tilesNode->removeChildNode( tileNode.node );
+        }
+        else
+        {
+          delete tileNode.node;
+          tileNode.node = new QSGSimpleTextureNode();
+          tileNode.node->setTexture( window()->createTextureFromImage( tile->image ) );
+          tileNode.node->setOwnsTexture( true );
+          tileNode.revision = tile->revision;
+        }
+        QSGSimpleTextureNode *node = tileNode.node;
+        tilesNode->appendChildNode( node );
+
+        const QgsRectangle extent = MapTileCache::tileExtent( key );
+        const QgsPointXY topLeft = mapToPixel.transform( extent.xMinimum(), extent.yMaximum() );
+        const QgsPointXY bottomRight = mapToPixel.transform( extent.xMaximum(), extent.yMinimum() );
+        node->setRect( QRectF( topLeft.toQPointF(), bottomRight.toQPointF() ) );
+
+        nodes.insert( key, tileNode );
+      }
+    }
+  }
+
+  // tiles no longer visible or evicted from the cache
+  for ( const TileNode &tileNode : std::as_const( mTileNodes ) )
+  {
+    delete tileNode.node;
+  }
+  mTileNodes = nodes;
 }
 
 #if QT_VERSION < QT_VERSION_CHECK( 6, 0, 0 )
@@ -428,6 +723,7 @@ void InputMapCanvasMap::onLayersChanged()
     mLayerConnections << connect( layer, &QgsMapLayer::repaintRequested, this, &InputMapCanvasMap::layerRepaintRequested );
   }
 
+  invalidateTiles();
   refresh();
 }
 
@@ -439,6 +735,25 @@ void InputMapCanvasMap::destroyJob( QgsMapRendererJob *job )
 
 void InputMapCanvasMap::stopRendering()
 {
+  mRenderingLayers.clear();
+  mRenderedLayers.clear();
+
+  mPreviewTimer.stop();
+  mPreviewPending = false;
+
+  if ( mPreviewJob )
+  {
+    disconnect( mPreviewJob, &QgsMapRendererJob::finished, this, &InputMapCanvasMap::previewJobFinished );
+
+    if ( !mPreviewJob->isActive() )
+      mPreviewJob->deleteLater();
+    else
+      connect( mPreviewJob, &QgsMapRendererJob::finished, mPreviewJob, &QObject::deleteLater );
+
+    mPreviewJob->cancelWithoutBlocking();
+    mPreviewJob = nullptr;
+  }
+
   if ( mJob )
   {
     mMapUpdateTimer.stop();
@@ -497,6 +812,14 @@ void InputMapCanvasMap::clearCache()
 {
   if ( mCache )
     mCache->clear();
+
+  invalidateTiles();
+}
+
+void InputMapCanvasMap::invalidateTiles()
+{
+  mTileCache->invalidate();
+  update();
 }
 
 void InputMapCanvasMap::clearTemporalCache()
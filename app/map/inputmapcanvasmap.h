@@ -18,6 +18,8 @@
 #include "inputconfig.h"
 
 #include "inputmapsettings.h"
+#include "maptilecache.h"
+#include "maprenderprofiler.h"
 
 #include <QFutureSynchronizer>
 #include <QTimer>
@@ -30,6 +32,7 @@
 class QgsMapRendererParallelJob;
 class QgsMapRendererCache;
 class QgsLabelingResults;
+class QSGSimpleTextureNode;
 
 /**
  * \brief This class implements a visual Qt Quick Item that does map rendering
@@ -41,6 +44,16 @@ class QgsLabelingResults;
  * The map settings for other Input components should be initialized from
  * InputMapCanvasMap's mapSettings
  *
+ * Rendered images of individual layers are kept in QgsMapRendererCache, when a layer requests
+ * a repaint (e.g. after an edit), only that layer (and labels if it has them) is rendered again.
+ *
+ * Once a render finishes, tiles around the map extent are prefetched to MapTileCache.
+ * While the map is being panned or zoomed, the cached tiles are composited below
+ * the last rendered image until the render of the new extent finishes.
+ *
+ * The rendered image is uploaded to the scene graph in cells of IMAGE_CELL_SIZE. Incremental
+ * updates of a render only upload cells covered by the layers rendered since the previous update.
+ *
  * \note QML Type: MapCanvasMap
  *
  * \sa InputMapCanvas
@@ -75,16 +88,40 @@ class InputMapCanvasMap : public QQuickItem
     /**
      * Interval in milliseconds after which the map canvas will be updated while a rendering job is ongoing.
      * This only has an effect if incrementalRendering is activated.
+     * While the map is frozen for a gesture, it is also the minimal interval between preview renders.
      * Default is 250 [ms].
      */
     Q_PROPERTY( int mapUpdateInterval READ mapUpdateInterval WRITE setMapUpdateInterval NOTIFY mapUpdateIntervalChanged )
 
     /**
      * When the incrementalRendering property is set to TRUE, the automatic refresh of map canvas during rendering is allowed.
+     *
+     * It also enables preview renders while the map is frozen for a gesture (pan, pinch): once per mapUpdateInterval
+     * the map is quickly rendered at a reduced device pixel ratio, with simplified symbology and without labels.
+     * The full quality render follows when the map gets unfrozen.
      */
     Q_PROPERTY( bool incrementalRendering READ incrementalRendering WRITE setIncrementalRendering NOTIFY incrementalRenderingChanged )
 
+    /**
+     * Statistics of the render jobs of this map canvas map (per-layer timings, cache hits...).
+     * This is a readonly property.
+     */
+    Q_PROPERTY( MapRenderProfiler *renderProfiler READ renderProfiler CONSTANT )
+
   public:
+
+    //! Device pixel ratio of preview renders relative to the device pixel ratio of the map
+    static constexpr double PREVIEW_PIXEL_RATIO = 0.5;
+
+    //! Simplification threshold (in pixels) of vector geometries in preview renders
+    static constexpr float PREVIEW_SIMPLIFY_THRESHOLD = 3;
+
+    //! Size (in device pixels) of the cells the map image is uploaded in
+    static constexpr int IMAGE_CELL_SIZE = 512;
+
+    //! Margin (in pixels) added around extents of rendered layers, symbols may exceed the extent of features
+    static constexpr int DIRTY_RECT_MARGIN = 64;
+
     //! Create map canvas map
     explicit InputMapCanvasMap( QQuickItem *parent = nullptr );
     ~InputMapCanvasMap();
@@ -115,6 +152,9 @@ class InputMapCanvasMap : public QQuickItem
     //! \copydoc InputMapCanvasMap::incrementalRendering
     void setIncrementalRendering( bool incrementalRendering );
 
+    //! \copydoc InputMapCanvasMap::renderProfiler
+    MapRenderProfiler *renderProfiler() const;
+
   signals:
 
     /**
@@ -127,6 +167,11 @@ class InputMapCanvasMap : public QQuickItem
      */
     void mapCanvasRefreshed();
 
+    /**
+     * Signal is emitted when a preview render of a frozen canvas has finished
+     */
+    void mapPreviewRendered();
+
     //! \copydoc InputMapCanvasMap::freeze
     void freezeChanged();
 
@@ -175,12 +220,17 @@ class InputMapCanvasMap : public QQuickItem
     void refreshMap();
     void renderJobUpdated();
     void renderJobFinished();
+    void renderPreview();
+    void previewJobFinished();
+    void onLayerRenderingStarted( const QString &layerId );
+    void onLayerRendered( const QString &layerId );
     void layerRepaintRequested( bool deferred );
     void onWindowChanged( QQuickWindow *window );
     void onScreenChanged( QScreen *screen );
     void onExtentChanged();
     void onLayersChanged();
     void onTemporalStateChanged();
+    void invalidateTiles();
 
   private:
 
@@ -189,20 +239,39 @@ class InputMapCanvasMap : public QQuickItem
      */
     void destroyJob( QgsMapRendererJob *job );
     QgsMapSettings prepareMapSettings() const;
+    QgsMapSettings preparePreviewMapSettings() const;
     void updateTransform();
     void zoomToFullExtent();
     void clearTemporalCache();
 
+    //! Updates child nodes of \a tilesNode to the cached tiles covering the current extent
+    void updateTileNodes( QSGNode *tilesNode );
+
+    //! Uploads the changed parts of the map image to textures of the image cells
+    void updateImageCells();
+
+    //! Returns the part of the image (in device pixels) covered by the layers rendered since the last update
+    QRect renderedLayersRect() const;
+
     std::unique_ptr<InputMapSettings> mMapSettings;
     bool mPinching = false;
     QPoint mPinchStartPoint;
     QgsMapRendererParallelJob *mJob = nullptr;
+    QgsMapRendererParallelJob *mPreviewJob = nullptr;
+    QTimer mPreviewTimer;
+    bool mPreviewPending = false;
     std::unique_ptr<QgsMapRendererCache> mCache;
+    std::unique_ptr<MapRenderProfiler> mRenderProfiler; // destroyed after the tile cache, which cancels its jobs
+    std::unique_ptr<MapTileCache> mTileCache;
     QgsLabelingResults *mLabelingResults = nullptr;
     QImage mImage;
     QgsMapSettings mImageMapSettings;
+    QgsMapSettings mJobMapSettings; //!< settings of mJob without the rendered feature handlers of the profiler
     QTimer mRefreshTimer;
-    bool mDirty = false;
+    bool mDirty = false; //!< whole image needs to be uploaded
+    QRect mDirtyRect; //!< part of the image which needs to be uploaded
+    QStringList mRenderingLayers; //!< layers of mJob which are being rendered
+    QStringList mRenderedLayers; //!< layers of mJob rendered since the last update
     bool mFreeze = false;
     QList<QMetaObject::Connection> mLayerConnections;
     QTimer mMapUpdateTimer;
@@ -211,6 +280,25 @@ class InputMapCanvasMap : public QQuickItem
     bool mDeferredRefreshPending = false;
 
     QQuickWindow *mWindow = nullptr;
+
+    // scene graph nodes, only accessed in updatePaintNode()
+    QSGNode *mTilesNode = nullptr;
+    QSGNode *mImageNode = nullptr;
+    struct ImageCell
+    {
+      QSGSimpleTextureNode *node = nullptr;
+      QRect rect; //!< part of the image in device pixels
+    };
+    QVector<ImageCell> mImageCells;
+    QSize mImageCellsSize; //!< size of the image the cells have been created for
+    struct TileNode
+    {
+      QSGSimpleTextureNode *node = nullptr;
+      int revision = 0;
+    };
+    QHash<MapTileCache::TileKey, TileNode> mTileNodes;
+
+    friend class TestMapCanvas;
 };
 
 #endif // INPUTMAPCANVASMAP_H
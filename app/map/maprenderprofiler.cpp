@@ -0,0 +1,238 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "maprenderprofiler.h"
+#include "coreutils.h"
+
+#include "qgsmaplayer.h"
+#include "qgsmaprenderercache.h"
+#include "qgsmaprendererjob.h"
+#include "qgsmapsettings.h"
+#include "qgsrenderedfeaturehandlerinterface.h"
+#include "qgsrendercontext.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+/**
+ * Counts features rendered by each layer. It is called from the render threads,
+ * the layer is identified by the layer scope of the render context.
+ */
+class RenderedFeatureCounter : public QgsRenderedFeatureHandlerInterface
+{
+  public:
+    void handleRenderedFeature( const QgsFeature &, const QgsGeometry &, const QgsRenderedFeatureHandlerInterface::RenderedFeatureContext &context ) override
+    {
+      if ( !context.renderContext )
+        return;
+
+      const QString layerId = context.renderContext->expressionContext().variable( QStringLiteral( "layer_id" ) ).toString();
+
+      QMutexLocker locker( &mMutex );
+      ++mCounts[layerId];
+    }
+
+    //! Returns counts since the last call and resets them
+    QHash<QString, int> takeCounts()
+    {
+      QMutexLocker locker( &mMutex );
+      QHash<QString, int> counts;
+      counts.swap( mCounts );
+      return counts;
+    }
+
+  private:
+    QMutex mMutex;
+    QHash<QString, int> mCounts;
+};
+
+MapRenderProfiler::MapRenderProfiler( QObject *parent )
+  : QObject( parent )
+  , mFeatureCounter( std::make_unique<RenderedFeatureCounter>() )
+{
+}
+
+MapRenderProfiler::~MapRenderProfiler() = default;
+
+bool MapRenderProfiler::isEnabled() const
+{
+  return mEnabled;
+}
+
+void MapRenderProfiler::setEnabled( bool enabled )
+{
+  if ( mEnabled == enabled )
+    return;
+
+  mEnabled = enabled;
+  emit enabledChanged();
+}
+
+QVariantList MapRenderProfiler::layers() const
+{
+  QVariantList list;
+  for ( const LayerProfile &profile : mLayerProfiles )
+  {
+    QVariantMap item;
+    item.insert( QStringLiteral( "name" ), profile.name );
+    item.insert( QStringLiteral( "time" ), profile.renderingTime );
+    item.insert( QStringLiteral( "features" ), profile.featureCount );
+    item.insert( QStringLiteral( "cached" ), profile.cached );
+    list << item;
+  }
+  return list;
+}
+
+int MapRenderProfiler::renderTime() const
+{
+  return mRenderTime;
+}
+
+int MapRenderProfiler::labelingTime() const
+{
+  return mLabelingTime;
+}
+
+QList<MapRenderProfiler::LayerProfile> MapRenderProfiler::layerProfiles() const
+{
+  return mLayerProfiles;
+}
+
+void MapRenderProfiler::prepareSettings( QgsMapSettings &settings )
+{
+  // map settings do not take ownership of the handler, it lives as long as the profiler
+  if ( mEnabled )
+    settings.addRenderedFeatureHandler( mFeatureCounter.get() );
+}
+
+void MapRenderProfiler::jobStarted( QgsMapRendererJob *job, QgsMapRendererCache *cache )
+{
+  mJob = job;
+  mCache = cache;
+  mLayersTime = -1;
+  mLabelsCached = false;
+  mFeatureCounter->takeCounts(); // drop counts of cancelled jobs
+
+  connect( job, &QgsMapRendererJob::renderingLayersFinished, this, &MapRenderProfiler::onLayersFinished );
+  mJobTimer.start();
+}
+
+void MapRenderProfiler::onLayersFinished()
+{
+  if ( sender() != mJob )
+    return;
+
+  mLayersTime = mJobTimer.elapsed();
+
+  // the job has dropped outdated images when it started and stores new labels only after
+  // they are placed, a label image in the cache at this point is being reused
+  mLabelsCached = mCache && mCache->hasCacheImage( QgsMapRendererJob::LABEL_CACHE_ID );
+}
+
+void MapRenderProfiler::jobFinished( QgsMapRendererJob *job )
+{
+  if ( job != mJob )
+    return;
+
+  mRenderTime = static_cast<int>( mJobTimer.elapsed() );
+
+  const QgsMapSettings settings = job->mapSettings();
+  const bool labelsRendered = settings.testFlag( Qgis::MapSettingsFlag::DrawLabeling ) && !mLabelsCached && mLayersTime >= 0;
+  mLabelingTime = labelsRendered ? static_cast<int>( mRenderTime - mLayersTime ) : -1;
+
+  const QHash<QString, int> counts = mFeatureCounter->takeCounts();
+  const QHash<QgsMapLayer *, int> times = job->perLayerRenderingTime();
+  const QStringList cachedLayers = job->layersRedrawnFromCache();
+
+  mLayerProfiles.clear();
+  const QList<QgsMapLayer *> layers = settings.layers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    if ( !layer )
+      continue;
+
+    LayerProfile profile;
+    profile.layerId = layer->id();
+    profile.name = layer->name();
+    profile.cached = cachedLayers.contains( layer->id() );
+    profile.renderingTime = profile.cached ? 0 : times.value( layer, -1 );
+    if ( mEnabled )
+      profile.featureCount = counts.value( layer->id(), 0 );
+    mLayerProfiles << profile;
+  }
+
+  std::stable_sort( mLayerProfiles.begin(), mLayerProfiles.end(), []( const LayerProfile & a, const LayerProfile & b )
+  {
+    return a.renderingTime > b.renderingTime;
+  } );
+
+  // rolling statistics
+  ++mRenders;
+  mTotalTime += mRenderTime;
+  mMaxTime = std::max( mMaxTime, mRenderTime );
+  mTotalLabelingTime += std::max( 0, mLabelingTime );
+
+  for ( const LayerProfile &profile : std::as_const( mLayerProfiles ) )
+  {
+    LayerStats &stats = mLayerStats[profile.layerId];
+    stats.name = profile.name;
+    ++stats.renders;
+    stats.totalTime += std::max( 0, profile.renderingTime );
+    stats.maxTime = std::max( stats.maxTime, profile.renderingTime );
+    if ( profile.cached )
+      ++stats.cacheHits;
+  }
+
+  if ( mRenders >= SUMMARY_INTERVAL )
+  {
+    if ( mEnabled )
+      CoreUtils::log( QStringLiteral( "Map rendering" ), summary() );
+
+    mRenders = 0;
+    mTotalTime = 0;
+    mMaxTime = 0;
+    mTotalLabelingTime = 0;
+    mLayerStats.clear();
+  }
+
+  mJob = nullptr;
+  emit profileChanged();
+}
+
+QString MapRenderProfiler::summary() const
+{
+  if ( mRenders == 0 )
+    return QString();
+
+  QList<LayerStats> stats = mLayerStats.values();
+  std::sort( stats.begin(), stats.end(), []( const LayerStats & a, const LayerStats & b )
+  {
+    return a.totalTime > b.totalTime;
+  } );
+
+  QStringList layers;
+  for ( const LayerStats &layer : std::as_const( stats ) )
+  {
+    layers << QStringLiteral( "%1 avg %2 ms (max %3 ms, cached %4/%5)" )
+           .arg( layer.name )
+           .arg( layer.totalTime / layer.renders )
+           .arg( layer.maxTime )
+           .arg( layer.cacheHits )
+           .arg( layer.renders );
+  }
+
+  return QStringLiteral( "%1 renders: avg %2 ms (max %3 ms), labeling avg %4 ms; layers: %5" )
+         .arg( mRenders )
+         .arg( mTotalTime / mRenders )
+         .arg( mMaxTime )
+         .arg( mTotalLabelingTime / mRenders )
+         .arg( layers.join( QStringLiteral( ", " ) ) );
+}
@@ -0,0 +1,137 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef MAPRENDERPROFILER_H
+#define MAPRENDERPROFILER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QVariantList>
+
+#include <memory>
+
+#include "inputconfig.h"
+
+class QgsMapSettings;
+class QgsMapRendererJob;
+class QgsMapRendererCache;
+class RenderedFeatureCounter;
+
+/**
+ * Collects statistics of map render jobs of the canvas: rendering time of every layer,
+ * whether it has been taken from the render cache, time of label placement and - when
+ * the profiler is enabled - number of rendered features of every layer.
+ *
+ * Profile of the last render is exposed to QML for the debug overlay. When the profiler
+ * is enabled, a summary of the last SUMMARY_INTERVAL renders is periodically written
+ * to the diagnostic log.
+ */
+class MapRenderProfiler : public QObject
+{
+    Q_OBJECT
+
+    /**
+     * Enables counting of rendered features, which slows down rendering a bit, and the
+     * summary in the diagnostic log. Timings are always collected.
+     */
+    Q_PROPERTY( bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged )
+
+    /**
+     * Profiles of layers of the last render, ordered by the rendering time.
+     * Every item is a map with "name", "time" (ms), "features" (-1 if not counted) and "cached" keys.
+     */
+    Q_PROPERTY( QVariantList layers READ layers NOTIFY profileChanged )
+
+    //! Total time of the last render in milliseconds
+    Q_PROPERTY( int renderTime READ renderTime NOTIFY profileChanged )
+
+    //! Time of label placement and drawing of the last render in milliseconds, -1 if labels were not rendered
+    Q_PROPERTY( int labelingTime READ labelingTime NOTIFY profileChanged )
+
+  public:
+
+    struct LayerProfile
+    {
+      QString layerId;
+      QString name;
+      int renderingTime = -1; //!< in milliseconds
+      int featureCount = -1; //!< -1 when features are not counted
+      bool cached = false;
+    };
+
+    //! Number of renders summarized in one entry of the diagnostic log
+    static constexpr int SUMMARY_INTERVAL = 20;
+
+    explicit MapRenderProfiler( QObject *parent = nullptr );
+    ~MapRenderProfiler() override;
+
+    bool isEnabled() const;
+    void setEnabled( bool enabled );
+
+    QVariantList layers() const;
+    int renderTime() const;
+    int labelingTime() const;
+
+    //! Returns profiles of layers of the last render
+    QList<LayerProfile> layerProfiles() const;
+
+    //! Sets up \a settings of a new render job to collect its statistics
+    void prepareSettings( QgsMapSettings &settings );
+
+    //! Starts to profile the \a job rendering with \a cache, it needs to be called before the job is started
+    void jobStarted( QgsMapRendererJob *job, QgsMapRendererCache *cache );
+
+    //! Collects the statistics of the finished \a job
+    void jobFinished( QgsMapRendererJob *job );
+
+    //! Returns summary of renders since the last summary was logged
+    QString summary() const;
+
+  signals:
+    void enabledChanged();
+    void profileChanged();
+
+  private slots:
+    void onLayersFinished();
+
+  private:
+    struct LayerStats
+    {
+      QString name;
+      int renders = 0;
+      qint64 totalTime = 0;
+      int maxTime = 0;
+      int cacheHits = 0;
+    };
+
+    bool mEnabled = false;
+    std::unique_ptr<RenderedFeatureCounter> mFeatureCounter;
+
+    QPointer<QgsMapRendererJob> mJob;
+    QPointer<QgsMapRendererCache> mCache;
+    QElapsedTimer mJobTimer;
+    qint64 mLayersTime = -1;
+    bool mLabelsCached = false;
+
+    QList<LayerProfile> mLayerProfiles;
+    int mRenderTime = -1;
+    int mLabelingTime = -1;
+
+    // rolling statistics for the diagnostic log
+    int mRenders = 0;
+    qint64 mTotalTime = 0;
+    int mMaxTime = 0;
+    qint64 mTotalLabelingTime = 0;
+    QHash<QString, LayerStats> mLayerStats;
+};
+
+#endif // MAPRENDERPROFILER_H
@@ -0,0 +1,236 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "maptilecache.h"
+#include "coreutils.h"
+
+#include "qgsmaprenderersequentialjob.h"
+
+#include <cmath>
+
+//! Upper bound of tiles requested for one extent, protects from degenerate map settings
+static constexpr int MAX_TILES_IN_EXTENT = 1024;
+
+MapTileCache::MapTileCache( QObject *parent )
+  : QObject( parent )
+  , mTiles( DEFAULT_MAX_SIZE )
+{
+}
+
+MapTileCache::~MapTileCache()
+{
+  const QList<QgsMapRendererJob *> jobs = mJobs.keys();
+  for ( QgsMapRendererJob *job : jobs )
+  {
+    disconnect( job, nullptr, this, nullptr );
+    job->cancel();
+    delete job;
+  }
+}
+
+int MapTileCache::zoomLevel( double mapUnitsPerPixel )
+{
+  if ( mapUnitsPerPixel <= 0 )
+    return 0;
+
+  return static_cast<int>( std::round( std::log2( mapUnitsPerPixel ) ) );
+}
+
+double MapTileCache::tileMapSize( int zoom )
+{
+  return std::ldexp( static_cast<double>( TILE_SIZE ), zoom );
+}
+
+QgsRectangle MapTileCache::tileExtent( const TileKey &key )
+{
+  const double size = tileMapSize( key.zoom );
+  return QgsRectangle( key.x * size, key.y * size, ( key.x + 1 ) * size, ( key.y + 1 ) * size );
+}
+
+QList<MapTileCache::TileKey> MapTileCache::tilesInExtent( const QgsRectangle &extent, int zoom )
+{
+  QList<TileKey> keys;
+  if ( extent.isEmpty() )
+    return keys;
+
+  const double size = tileMapSize( zoom );
+  const double xMin = std::floor( extent.xMinimum() / size );
+  const double xMax = std::ceil( extent.xMaximum() / size ) - 1;
+  const double yMin = std::floor( extent.yMinimum() / size );
+  const double yMax = std::ceil( extent.yMaximum() / size ) - 1;
+
+  if ( ( xMax - xMin + 1 ) * ( yMax - yMin + 1 ) > MAX_TILES_IN_EXTENT )
+    return keys;
+
+  for ( int y = static_cast<int>( yMax ); y >= static_cast<int>( yMin ); --y )
+  {
+    for ( int x = static_cast<int>( xMin ); x <= static_cast<int>( xMax ); ++x )
+    {
+      keys << TileKey{ zoom, x, y };
+    }
+  }
+  return keys;
+}
+
+int MapTileCache::revision() const
+{
+  return mRevision;
+}
+
+const MapTileCache::Tile *MapTileCache::tile( const TileKey &key )
+{
+  return mTiles.object( key );
+}
+
+bool MapTileCache::contains( const TileKey &key ) const
+{
+  const Tile *tile = mTiles.object( key );
+  return tile && tile->revision == mRevision;
+}
+
+int MapTileCache::count() const
+{
+  return static_cast<int>( mTiles.count() );
+}
+
+int MapTileCache::maxSize() const
+{
+  return static_cast<int>( mTiles.maxCost() );
+}
+
+void MapTileCache::setMaxSize( int maxSize )
+{
+  mTiles.setMaxCost( maxSize );
+}
+
+void MapTileCache::prefetch( const QgsMapSettings &settings )
+{
+  mQueue.clear();
+
+  if ( !settings.hasValidSettings() )
+    return;
+
+  // handlers can not be removed from the settings, they would be called from the tile jobs
+  // (skewing e.g. feature counts of the canvas render) and might be gone before the jobs finish
+  if ( !settings.renderedFeatureHandlers().isEmpty() )
+  {
+    CoreUtils::log( QStringLiteral( "Map tiles" ), QStringLiteral( "Tiles are not prefetched for map settings with rendered feature handlers" ) );
+    return;
+  }
+
+  mSettings = settings;
+
+  const QgsRectangle visible = settings.visibleExtent();
+  const int zoom = zoomLevel( settings.mapUnitsPerPixel() );
+
+  QgsRectangle ring = visible;
+  ring.grow( tileMapSize( zoom ) );
+
+  QList<TileKey> candidates = tilesInExtent( visible, zoom );
+  const QList<TileKey> ringTiles = tilesInExtent( ring, zoom );
+  for ( const TileKey &key : ringTiles )
+  {
+    if ( !candidates.contains( key ) )
+      candidates << key;
+  }
+
+  // tiles which do not fit in the cache would evict the ones rendered before them
+  const qsizetype tileCost = std::max<qsizetype>( 1, static_cast<qsizetype>( TILE_SIZE * TILE_SIZE * 4 * settings.devicePixelRatio() * settings.devicePixelRatio() / 1024 ) );
+  const qsizetype maxTiles = maxSize() / tileCost;
+
+  // coarser level first, it is cheap and covers also larger zoom out gestures.
+  // The finer level is four times the visible tiles and is skipped as a whole if it does not fit
+  candidates << tilesInExtent( ring, zoom + 1 );
+  const QList<TileKey> finerTiles = tilesInExtent( visible, zoom - 1 );
+  if ( candidates.count() + finerTiles.count() <= maxTiles )
+    candidates << finerTiles;
+
+  if ( candidates.count() > maxTiles )
+    candidates = candidates.mid( 0, maxTiles );
+
+  QSet<TileKey> running;
+  for ( const PendingTile &pending : std::as_const( mJobs ) )
+  {
+    if ( pending.revision == mRevision )
+      running.insert( pending.key );
+  }
+
+  // missing tiles and tiles of older revisions
+  for ( const TileKey &key : std::as_const( candidates ) )
+  {
+    if ( !contains( key ) && !running.contains( key ) )
+      mQueue << key;
+  }
+
+  startJobs();
+}
+
+void MapTileCache::setStale()
+{
+  ++mRevision;
+  mQueue.clear();
+
+  // running jobs may have read the content before it changed, their results are dropped
+  for ( auto it = mJobs.constBegin(); it != mJobs.constEnd(); ++it )
+  {
+    it.key()->cancelWithoutBlocking();
+  }
+}
+
+void MapTileCache::invalidate()
+{
+  setStale();
+  mTiles.clear();
+}
+
+void MapTileCache::startJobs()
+{
+  while ( mJobs.count() < MAX_JOBS && !mQueue.isEmpty() )
+  {
+    const TileKey key = mQueue.takeFirst();
+
+    QgsMapRendererJob *job = new QgsMapRendererSequentialJob( tileSettings( key ) );
+    connect( job, &QgsMapRendererJob::finished, this, &MapTileCache::onJobFinished );
+    mJobs.insert( job, PendingTile{ key, mRevision } );
+    job->start();
+  }
+}
+
+void MapTileCache::onJobFinished()
+{
+  QgsMapRendererJob *job = qobject_cast<QgsMapRendererJob *>( sender() );
+  if ( !job || !mJobs.contains( job ) )
+    return;
+
+  const PendingTile pending = mJobs.take( job );
+  const bool isCurrent = pending.revision == mRevision && job->errors().isEmpty();
+
+  if ( isCurrent )
+  {
+    const qsizetype cost = std::max<qsizetype>( 1, job->renderedImage().sizeInBytes() / 1024 );
+    mTiles.insert( pending.key, new Tile{ job->renderedImage(), pending.revision }, cost );
+  }
+
+  job->deleteLater();
+
+  startJobs();
+
+  if ( isCurrent )
+    emit tileRendered();
+}
+
+QgsMapSettings MapTileCache::tileSettings( const TileKey &key ) const
+{
+  QgsMapSettings settings = mSettings;
+  settings.setOutputSize( QSize( TILE_SIZE, TILE_SIZE ) );
+  settings.setExtent( tileExtent( key ) );
+  settings.setFlag( Qgis::MapSettingsFlag::DrawLabeling, false );
+  settings.setFlag( Qgis::MapSettingsFlag::RenderPartialOutput, false );
+  return settings;
+}
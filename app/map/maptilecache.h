@@ -0,0 +1,155 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef MAPTILECACHE_H
+#define MAPTILECACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QSet>
+
+#include "qgsmapsettings.h"
+#include "qgsrectangle.h"
+
+#include "inputconfig.h"
+
+class QgsMapRendererJob;
+
+/**
+ * Cache of map tiles used to show the map immediately while it is being panned or zoomed,
+ * before the full render of the new extent finishes.
+ *
+ * Tiles form a grid of TILE_SIZE x TILE_SIZE (logical) pixels in the map CRS. Tiles of zoom level
+ * z are rendered with 2^z map units per pixel, so the canvas can always pick the level closest to
+ * its current resolution and fall back to the adjacent levels. Tiles are rendered without labels,
+ * which would be cut on tile borders - labels come with the full render of the canvas.
+ *
+ * Every tile remembers the revision of the map content it has been rendered with. When the content
+ * of some layers changes (edits, style, newly loaded data), setStale() starts a new revision - the
+ * old tiles are still returned, so that the canvas has something to show, until prefetch() renders
+ * them again. Changes which make the old tiles useless (layer set, CRS...) need invalidate().
+ * Tiles do not keep images of the individual layers, those would multiply the size of each tile by
+ * the number of layers - a stale tile renders all layers again. Tiles are evicted in the least recently used order once the cache exceeds its maximum size.
+ */
+class MapTileCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    //! Position of a tile in the grid
+    struct TileKey
+    {
+      int zoom = 0;
+      int x = 0;
+      int y = 0;
+
+      bool operator==( const TileKey &other ) const
+      {
+        return zoom == other.zoom && x == other.x && y == other.y;
+      }
+    };
+
+    struct Tile
+    {
+      QImage image;
+      int revision = 0; //!< revision of the map content the tile has been rendered with
+    };
+
+    //! Width and height of a tile in logical pixels
+    static constexpr int TILE_SIZE = 256;
+
+    //! Default maximum size of the cached tiles in kB
+    static constexpr int DEFAULT_MAX_SIZE = 96 * 1024;
+
+    //! Maximum number of tiles rendered at the same time
+    static constexpr int MAX_JOBS = 2;
+
+    explicit MapTileCache( QObject *parent = nullptr );
+    ~MapTileCache() override;
+
+    //! Returns zoom level with resolution closest to \a mapUnitsPerPixel
+    static int zoomLevel( double mapUnitsPerPixel );
+
+    //! Returns width (and height) of a tile of \a zoom level in map units
+    static double tileMapSize( int zoom );
+
+    //! Returns extent of the tile \a key in map units
+    static QgsRectangle tileExtent( const TileKey &key );
+
+    //! Returns keys of the tiles of \a zoom level intersecting \a extent
+    static QList<TileKey> tilesInExtent( const QgsRectangle &extent, int zoom );
+
+    //! Returns the current revision of the map content
+    int revision() const;
+
+    //! Returns the tile \a key, nullptr if it has not been rendered yet. The tile may be of an older revision.
+    const Tile *tile( const TileKey &key );
+
+    //! Returns true if tile \a key of the current revision is in the cache
+    bool contains( const TileKey &key ) const;
+
+    //! Returns number of cached tiles
+    int count() const;
+
+    //! Returns maximum size of the cached tiles in kB
+    int maxSize() const;
+
+    //! Sets maximum size of the cached tiles in kB, least recently used tiles are evicted when needed
+    void setMaxSize( int maxSize );
+
+    /**
+     * Requests rendering of missing tiles around the visible extent of \a settings: tiles of the visible
+     * extent come first, then the ring of tiles around it and then tiles of the adjacent zoom levels.
+     * Only as many tiles as fit in maxSize() are requested, tiles of the finer zoom level are skipped
+     * if they do not fit all. Requests of previous calls which have not been started yet are dropped.
+     * The \a settings must not have rendered feature handlers, tiles are not prefetched otherwise.
+     */
+    void prefetch( const QgsMapSettings &settings );
+
+    //! Starts a new revision, the cached tiles are kept until they are rendered again
+    void setStale();
+
+    //! Drops all tiles and pending requests and starts a new revision
+    void invalidate();
+
+  signals:
+    //! Emitted when a tile of the current revision has been rendered
+    void tileRendered();
+
+  private slots:
+    void onJobFinished();
+
+  private:
+    void startJobs();
+
+    QgsMapSettings tileSettings( const TileKey &key ) const;
+
+    struct PendingTile
+    {
+      TileKey key;
+      int revision = 0;
+    };
+
+    QCache<TileKey, Tile> mTiles;
+    QList<TileKey> mQueue;
+    QHash<QgsMapRendererJob *, PendingTile> mJobs;
+    QgsMapSettings mSettings;
+    int mRevision = 0;
+};
+
+inline size_t qHash( const MapTileCache::TileKey &key, size_t seed = 0 )
+{
+  return qHashMulti( seed, key.zoom, key.x, key.y );
+}
+
+#endif // MAPTILECACHE_H
@@ -18,6 +18,7 @@
 #include "qgsmultipolygon.h"
 #include "qgsrendercontext.h"
 #include "qgsvectorlayereditbuffer.h"
+#include "qgsproject.h"
 
 #include "position/positionkit.h"
 #include "coreutils.h"
@@ -25,6 +26,9 @@
 #include <QUndoStack>
 #include <QUndoCommand>
 
+//! Number of points streamed to a line before they are written to the layer as one undo command
+static constexpr int STREAMED_POINTS_BATCH = 10;
+
 RecordingMapTool::RecordingMapTool( QObject *parent )
   : AbstractMapTool{parent}
 {
@@ -79,6 +83,24 @@ void RecordingMapTool::addPoint( const QgsPoint &point )
 
   mLastRecordedPoint = pointToAdd;
 
+  if ( mRecordingType == StreamMode )
+  {
+    // the simplification may drop the fix or release the one it held back
+    const QgsPointSequence points = mStreamSimplifier.addPoint( pointToAdd );
+    for ( const QgsPoint &streamedPoint : points )
+    {
+      insertPoint( streamedPoint );
+    }
+
+    updateStreamedTail();
+    return;
+  }
+
+  insertPoint( pointToAdd );
+}
+
+void RecordingMapTool::insertPoint( const QgsPoint &pointToAdd )
+{
   QgsVertexId id( mActivePart, mActiveRing, 0 );
 
   if ( !mActiveFeature.isValid() )
@@ -94,6 +116,11 @@ void RecordingMapTool::addPoint( const QgsPoint &point )
     mActiveLayer->endEditCommand();
   }
 
+  if ( mRecordingType == StreamMode && appendStreamedPoint( pointToAdd ) )
+  {
+    return;
+  }
+
   if ( mRecordedGeometry.isEmpty() )
   {
     mRecordedGeometry = InputUtils::createGeometryForLayer( mActiveLayer );
@@ -206,6 +233,62 @@ void RecordingMapTool::addPoint( const QgsPoint &point )
   emit recordedGeometryChanged( mRecordedGeometry );
 }
 
+void RecordingMapTool::setupStreamSimplifier()
+{
+  QgsProject *project = mActiveLayer ? mActiveLayer->project() : nullptr;
+
+  mStreamSimplifier.setup(
+    TrackSimplifier::readSettings( project ),
+    mActiveLayer ? mActiveLayer->crs() : QgsCoordinateReferenceSystem(),
+    mActiveLayer ? TrackSimplifier::rawTrackFilePath( project, mActiveLayer->name() ) : QString(),
+    !mRecordedGeometry.isEmpty()
+  );
+
+  updateStreamedTail();
+}
+
+void RecordingMapTool::flushStreamedPoints()
+{
+  const QgsPointSequence points = mStreamSimplifier.flush();
+  updateStreamedTail();
+
+  if ( !mActiveLayer || mState != MapToolState::Record )
+  {
+    return;
+  }
+
+  for ( const QgsPoint &point : points )
+  {
+    insertPoint( point );
+  }
+}
+
+void RecordingMapTool::updateStreamedTail()
+{
+  QgsGeometry tail;
+
+  const QgsAbstractGeometry *geom = mRecordedGeometry.constGet();
+  if ( mRecordingType == StreamMode && mStreamSimplifier.hasPendingPoint() && geom &&
+       mRecordedGeometry.type() == Qgis::GeometryType::Line && mActivePart < geom->partCount() )
+  {
+    // the held back fix continues the line from the end we record to
+    const int vertexCount = geom->vertexCount( mActivePart, 0 );
+    if ( vertexCount > 0 )
+    {
+      const QgsVertexId id( mActivePart, 0, mInsertPolicy == InsertPolicy::Start ? 0 : vertexCount - 1 );
+      tail = QgsGeometry( new QgsLineString( geom->vertexAt( id ), mStreamSimplifier.pendingPoint() ) );
+    }
+  }
+
+  if ( tail.isEmpty() && mStreamedTail.isEmpty() )
+  {
+    return;
+  }
+
+  mStreamedTail = tail;
+  emit streamedTailChanged( mStreamedTail );
+}
+
 void RecordingMapTool::addPointAtPosition( Vertex vertex, const QgsPoint &point )
 {
   if ( !mActiveLayer )
@@ -432,6 +515,16 @@ void RecordingMapTool::removePoint()
 }
 
 bool RecordingMapTool::hasValidGeometry() const
+{
+  if ( !mValidGeometryKnown )
+  {
+    mValidGeometry = validateGeometry();
+    mValidGeometryKnown = true;
+  }
+  return mValidGeometry;
+}
+
+bool RecordingMapTool::validateGeometry() const
 {
   if ( mActiveLayer )
   {
@@ -626,10 +719,26 @@ void RecordingMapTool::prepareEditing()
 
 void RecordingMapTool::collectVertices()
 {
+  // QML gets the whole geometry now, including points appended while streaming
+  mHasAppendedPoints = false;
+  mValidGeometryKnown = false;
+
+  // the geometry was written by the edit operation emitting it (including points not committed yet) or replaced
+  mPendingStreamedPoints = 0;
+
+  // moving a vertex does not change structure of the nodes index
+  if ( mMovedVertexId.isValid() && updateMovedVertex( mMovedVertexId ) )
+  {
+    updateVisibleItems();
+    return;
+  }
+
   mVertices.clear();
+  mVertexIndexValid = false;
 
   if ( mRecordedGeometry.isEmpty() )
   {
+    updateRingNeighbours();
     updateVisibleItems();
     return;
   }
@@ -754,9 +863,292 @@ void RecordingMapTool::collectVertices()
       mVertices.push_back( Vertex( vertexId, vertex, Vertex::Existing ) );
     }
   }
+  updateRingNeighbours();
   updateVisibleItems();
 }
 
+void RecordingMapTool::updateRingNeighbours()
+{
+  mRingStarts.clear();
+  mNextVertices.resize( mVertices.count() );
+
+  int ringStart = 0;
+  for ( int i = 0; i < mVertices.count(); ++i )
+  {
+    const QgsVertexId id = mVertices.at( i ).vertexId();
+    if ( i == 0 || id.part != mVertices.at( i - 1 ).vertexId().part || id.ring != mVertices.at( i - 1 ).vertexId().ring )
+    {
+      ringStart = i;
+      mRingStarts.insert( qMakePair( id.part, id.ring ), i );
+    }
+
+    const bool isLastInRing = i == mVertices.count() - 1 ||
+                              mVertices.at( i + 1 ).vertexId().part != id.part ||
+                              mVertices.at( i + 1 ).vertexId().ring != id.ring;
+    mNextVertices[i] = isLastInRing ? ringStart : i + 1;
+  }
+}
+
+bool RecordingMapTool::updateMovedVertex( const QgsVertexId &id )
+{
+  const QgsAbstractGeometry *geom = mRecordedGeometry.constGet();
+  if ( !geom )
+  {
+    return false;
+  }
+
+  const auto ringStart = mRingStarts.constFind( qMakePair( id.part, id.ring ) );
+  if ( ringStart == mRingStarts.constEnd() )
+  {
+    return false;
+  }
+
+  const int start = *ringStart;
+  const int vertexCount = geom->vertexCount( id.part, id.ring );
+
+  auto isExistingVertex = [this]( int index, const QgsVertexId & vertexId )
+  {
+    return index >= 0 && index < mVertices.count() && mVertices.at( index ).type() == Vertex::Existing && mVertices.at( index ).vertexId() == vertexId;
+  };
+
+  // see collectVertices() for the order of vertices in the nodes index
+  if ( mRecordedGeometry.type() == Qgis::GeometryType::Polygon )
+  {
+    if ( vertexCount < 4 )
+    {
+      return false; // rings which are not closed yet
+    }
+
+    // closing vertex is moved together with the first one
+    const int n = id.vertex == vertexCount - 1 ? 0 : id.vertex;
+    const int position = start + 2 * n;
+    const QgsVertexId vertexId( id.part, id.ring, n );
+    if ( !isExistingVertex( position, vertexId ) || position + 1 >= mVertices.count() )
+    {
+      return false;
+    }
+
+    auto ringVertex = [geom, &id]( int vertex ) { return geom->vertexAt( QgsVertexId( id.part, id.ring, vertex ) ); };
+
+    const int previous = n == 0 ? vertexCount - 2 : n - 1;
+
+    setVertexCoordinates( position, ringVertex( n ) );
+    setVertexCoordinates( position + 1, QgsGeometryUtils::midpoint( ringVertex( n ), ringVertex( n + 1 ) ) );
+    setVertexCoordinates( start + 2 * previous + 1, QgsGeometryUtils::midpoint( ringVertex( previous ), ringVertex( previous + 1 ) ) );
+  }
+  else if ( mRecordedGeometry.type() == Qgis::GeometryType::Line )
+  {
+    if ( vertexCount < 2 )
+    {
+      return false;
+    }
+
+    const int n = id.vertex;
+    const int position = start + 1 + 2 * n;
+    const int endHandle = start + 2 * vertexCount;
+    if ( !isExistingVertex( position, id ) || mVertices.at( start ).type() != Vertex::HandleStart ||
+         endHandle >= mVertices.count() || mVertices.at( endHandle ).type() != Vertex::HandleEnd )
+    {
+      return false;
+    }
+
+    auto lineVertex = [geom, &id]( int vertex ) { return geom->vertexAt( QgsVertexId( id.part, id.ring, vertex ) ); };
+
+    setVertexCoordinates( position, lineVertex( n ) );
+    if ( n > 0 )
+    {
+      setVertexCoordinates( position - 1, QgsGeometryUtils::midpoint( lineVertex( n - 1 ), lineVertex( n ) ) );
+    }
+    if ( n < vertexCount - 1 )
+    {
+      setVertexCoordinates( position + 1, QgsGeometryUtils::midpoint( lineVertex( n ), lineVertex( n + 1 ) ) );
+    }
+
+    // handles follow direction of the first and the last segment
+    if ( n <= 1 )
+    {
+      setVertexCoordinates( start, handlePoint( lineVertex( 1 ), lineVertex( 0 ) ) );
+    }
+    if ( n >= vertexCount - 2 )
+    {
+      setVertexCoordinates( endHandle, handlePoint( lineVertex( vertexCount - 2 ), lineVertex( vertexCount - 1 ) ) );
+    }
+  }
+  else
+  {
+    if ( !isExistingVertex( start, id ) )
+    {
+      return false;
+    }
+
+    setVertexCoordinates( start, geom->vertexAt( id ) );
+  }
+
+  return true;
+}
+
+void RecordingMapTool::setVertexCoordinates( int index, const QgsPoint &point )
+{
+  mVertices[index].setCoordinates( point );
+
+  if ( !mVertexIndexValid )
+  {
+    return;
+  }
+
+  try
+  {
+    const QgsPointXY mapPoint = mapSettings()->mapSettings().layerTransform( mActiveLayer ).transform( QgsPointXY( point ) );
+    mVertexIndex.movePoint( index, mapPoint );
+  }
+  catch ( QgsCsException & )
+  {
+    mVertexIndexValid = false;
+  }
+}
+
+void RecordingMapTool::updateVertexIndex()
+{
+  if ( !mActiveLayer || !mapSettings() )
+  {
+    return;
+  }
+
+  const QgsCoordinateReferenceSystem crs = mapSettings()->destinationCrs();
+  if ( mVertexIndexValid && mVertexIndexCrs == crs )
+  {
+    return;
+  }
+
+  QVector<double> x;
+  QVector<double> y;
+  QVector<double> z( mVertices.count(), 0 );
+  x.reserve( mVertices.count() );
+  y.reserve( mVertices.count() );
+
+  for ( const Vertex &vertex : std::as_const( mVertices ) )
+  {
+    x << vertex.coordinates().x();
+    y << vertex.coordinates().y();
+  }
+
+  try
+  {
+    mapSettings()->mapSettings().layerTransform( mActiveLayer ).transformInPlace( x, y, z );
+  }
+  catch ( QgsCsException & )
+  {
+    // nothing can be found until the vertices change
+    mVertexIndex.clear();
+    mVertexIndexCrs = crs;
+    mVertexIndexValid = true;
+    return;
+  }
+
+  QVector<QgsPointXY> points;
+  points.reserve( mVertices.count() );
+  for ( int i = 0; i < mVertices.count(); ++i )
+  {
+    points << QgsPointXY( x.at( i ), y.at( i ) );
+  }
+
+  mVertexIndex.build( points );
+  mVertexIndexCrs = crs;
+  mVertexIndexValid = true;
+}
+
+bool RecordingMapTool::appendStreamedPoint( const QgsPoint &point )
+{
+  if ( mInsertPolicy != InsertPolicy::End || mActiveVertex.isValid() || mRecordedGeometry.type() != Qgis::GeometryType::Line )
+  {
+    return false;
+  }
+
+  const QgsAbstractGeometry *geom = mRecordedGeometry.constGet();
+  if ( !geom || mActivePart >= geom->partCount() )
+  {
+    return false;
+  }
+
+  // handles are created together with the second vertex of the line
+  const int vertexCount = geom->vertexCount( mActivePart, 0 );
+  if ( vertexCount < 2 )
+  {
+    return false;
+  }
+
+  // the active part needs to be the last one in the nodes index
+  if ( mVertices.isEmpty() || mNextVertices.count() != mVertices.count() ||
+       mVertices.last().type() != Vertex::HandleEnd || mVertices.last().vertexId() != QgsVertexId( mActivePart, 0, vertexCount - 1 ) )
+  {
+    return false;
+  }
+
+  QgsLineString *line = nullptr;
+  if ( mRecordedGeometry.isMultipart() )
+  {
+    QgsMultiLineString *multiLine = qgsgeometry_cast<QgsMultiLineString *>( mRecordedGeometry.get() );
+    line = multiLine ? multiLine->lineStringN( mActivePart ) : nullptr;
+  }
+  else
+  {
+    line = qgsgeometry_cast<QgsLineString *>( mRecordedGeometry.get() );
+  }
+
+  if ( !line )
+  {
+    return false;
+  }
+
+  // coordinates of the line live in growable arrays, appending to them is amortised constant time.
+  // The geometry is shared with the edit buffer and undo commands only after a commit, so get()
+  // copies the line once per commit and not with every point
+  line->addVertex( point );
+
+  // batch size is fixed so that one undo step never removes more than a few seconds of the track
+  ++mPendingStreamedPoints;
+  if ( mPendingStreamedPoints >= STREAMED_POINTS_BATCH )
+  {
+    commitStreamedPoints();
+  }
+
+  const QgsPoint previous = line->pointN( vertexCount - 1 );
+  const QgsPoint last = line->pointN( vertexCount );
+  const QgsPoint midPoint = QgsGeometryUtils::midpoint( previous, last );
+  const QgsVertexId id( mActivePart, 0, vertexCount );
+
+  // see collectVertices() for the order of vertices in the nodes index,
+  // the end handle moves behind the new midpoint and vertex
+  const int endHandle = mVertices.count() - 1;
+  mVertices.removeLast();
+  mVertices.push_back( Vertex( id, midPoint, Vertex::MidPoint ) );
+  mVertices.push_back( Vertex( id, last, Vertex::Existing ) );
+  mVertices.push_back( Vertex( id, handlePoint( previous, last ), Vertex::HandleEnd ) );
+
+  const int ringStart = mRingStarts.value( qMakePair( mActivePart, 0 ) );
+  mNextVertices.resize( mVertices.count() );
+  for ( int i = endHandle; i < mVertices.count() - 1; ++i )
+  {
+    mNextVertices[i] = i + 1;
+  }
+  mNextVertices.last() = ringStart;
+
+  // the spatial index is rebuilt once the user looks for a vertex
+  mVertexIndexValid = false;
+
+  // existing vertices and midpoints are not extended here, it would copy them whenever QML holds
+  // the last emitted value. QML gets the new items below and all of them with the next full update.
+
+  // a line with at least two vertices stays valid, so the result of hasValidGeometry() holds
+  mHasAppendedPoints = true;
+
+  emit recordedGeometryAppended( QgsGeometry( new QgsLineString( previous, last ) ) );
+  emit existingVerticesAppended( QgsGeometry( last.clone() ) );
+  emit midPointsAppended( QgsGeometry( midPoint.clone() ) );
+
+  return true;
+}
+
 void RecordingMapTool::updateVisibleItems()
 {
   QgsMultiPoint *existingVertices = new QgsMultiPoint();
@@ -807,40 +1199,13 @@ void RecordingMapTool::updateVisibleItems()
       {
         if ( i > 0 )
         {
-          Vertex prevVertex = mVertices.at( i - 1 );
-
-          Vertex nextVertex;
+          const Vertex &prevVertex = mVertices.at( i - 1 );
 
           // next vertex should be the either the next vertex in the sequence
           // if this midpoint is a first or middle midpoint of the ring or
           // it should be the first vertex of the correspoding ring is this
           // midpoint is the last midpoint of the ring
-          if ( i == mVertices.count() - 1 )
-          {
-            for ( int j = 0 ; j < mVertices.count(); j++ )
-            {
-              nextVertex = mVertices.at( j );
-              if ( nextVertex.vertexId().part == v.vertexId().part && nextVertex.vertexId().ring == v.vertexId().ring )
-              {
-                break;
-              }
-            }
-          }
-          else
-          {
-            nextVertex = mVertices.at( i + 1 );
-            if ( nextVertex.vertexId().part != v.vertexId().part || nextVertex.vertexId().ring != v.vertexId().ring )
-            {
-              for ( int j = 0 ; j < mVertices.count(); j++ )
-              {
-                nextVertex = mVertices.at( j );
-                if ( nextVertex.vertexId().part == v.vertexId().part && nextVertex.vertexId().ring == v.vertexId().ring )
-                {
-                  break;
-                }
-              }
-            }
-          }
+          const Vertex &nextVertex = mVertices.at( mNextVertices.at( i ) );
 
           if ( prevVertex != mActiveVertex && nextVertex != mActiveVertex )
           {
@@ -891,8 +1256,6 @@ void RecordingMapTool::lookForVertex( const QPointF &clickedPoint, double search
     return;
   }
 
-  double minDistance = std::numeric_limits<double>::max();
-  double currentDistance = 0;
   double searchDistance = pixelsToMapUnits( searchRadius );
 
   QgsPoint pnt = mapSettings()->screenToCoordinate( clickedPoint );
@@ -902,19 +1265,8 @@ void RecordingMapTool::lookForVertex( const QPointF &clickedPoint, double search
     return;
   }
 
-  int idx = -1;
-  for ( int i = 0; i < mVertices.count(); i++ )
-  {
-    QgsPoint vertex( mVertices.at( i ).coordinates() );
-    vertex.transform( mapSettings()->mapSettings().layerTransform( mActiveLayer ) );
-
-    currentDistance = pnt.distance( vertex );
-    if ( currentDistance < minDistance && currentDistance <= searchDistance )
-    {
-      minDistance = currentDistance;
-      idx = i;
-    }
-  }
+  updateVertexIndex();
+  int idx = mVertexIndex.nearest( QgsPointXY( pnt.x(), pnt.y() ), searchDistance );
 
   // Update the previously grabbed point's position
   if ( mState == MapToolState::Grab )
@@ -1060,6 +1412,15 @@ void RecordingMapTool::releaseVertex( const QgsPoint &point )
 
 FeatureLayerPair RecordingMapTool::getFeatureLayerPair()
 {
+  if ( mRecordingType == StreamMode )
+  {
+    flushStreamedPoints();
+    commitStreamedPoints();
+  }
+
+  // the recording ends with the feature, also when streaming was turned off before
+  mStreamSimplifier.finishRawTrack();
+
   bool featureIsValid = FID_IS_NEW( mActiveFeature.id() ) || mActiveFeature.isValid();
 
   if ( mActiveLayer && featureIsValid )
@@ -1088,6 +1449,8 @@ void RecordingMapTool::discardChanges()
 
     mActiveLayer->triggerRepaint();
   }
+
+  mStreamSimplifier.removeRawTrack();
 }
 
 void RecordingMapTool::onFeatureAdded( QgsFeatureId newFeatureId )
@@ -1107,7 +1470,11 @@ void RecordingMapTool::updateVertex( const Vertex &vertex, const QgsPoint &point
     mActiveLayer->beginEditCommand( QStringLiteral( "Move vertex" ) );
     if ( mRecordedGeometry.get()->moveVertex( vertex.vertexId(), point ) )
     {
+      if ( vertex.type() == Vertex::Existing )
+        mMovedVertexId = vertex.vertexId();
+
       emit recordedGeometryChanged( mRecordedGeometry );
+      mMovedVertexId = QgsVertexId();
     }
   }
 }
@@ -1224,12 +1591,24 @@ void RecordingMapTool::grabNextVertex()
   }
 }
 
+void RecordingMapTool::commitStreamedPoints()
+{
+  if ( mPendingStreamedPoints == 0 || !mActiveLayer )
+  {
+    return;
+  }
+
+  mActiveLayer->beginEditCommand( QStringLiteral( "Add points" ) );
+  completeEditOperation();
+}
+
 void RecordingMapTool::completeEditOperation()
 {
   if ( mActiveLayer && mActiveLayer->isEditCommandActive() )
   {
     mActiveLayer->changeGeometry( mActiveFeature.id(), mRecordedGeometry );
     mActiveLayer->endEditCommand();
+    mPendingStreamedPoints = 0;
     mActiveLayer->triggerRepaint();
     setCanUndo( mActiveLayer->undoStack()->index() > mMinUndoStackIndex );
   }
@@ -1237,10 +1616,17 @@ void RecordingMapTool::completeEditOperation()
 
 void RecordingMapTool::undo()
 {
+  // points streamed since the last commit are undone together
+  commitStreamedPoints();
+
   if ( mActiveLayer && mActiveLayer->undoStack() && mActiveLayer->undoStack()->index() > mMinUndoStackIndex )
   {
     mActiveLayer->undoStack()->undo();
 
+    // streamed line changed, simplification starts again with the next fix
+    mStreamSimplifier.reset();
+    updateStreamedTail();
+
     if ( mActiveFeature.id() < 0 )
     {
       // new feature not commited
@@ -1371,8 +1757,28 @@ void RecordingMapTool::setRecordingType( const RecordingType &newRecordingType )
 {
   if ( mRecordingType == newRecordingType )
     return;
+
+  if ( mRecordingType == StreamMode )
+  {
+    // the last fix may be held back by the simplification
+    flushStreamedPoints();
+    commitStreamedPoints();
+  }
+
   mRecordingType = newRecordingType;
+
+  if ( mRecordingType == StreamMode )
+  {
+    setupStreamSimplifier();
+  }
+
   emit recordingTypeChanged( mRecordingType );
+
+  // highlights got only the appended segments while streaming, let them take the whole geometry
+  if ( mHasAppendedPoints )
+  {
+    emit recordedGeometryChanged( mRecordedGeometry );
+  }
 }
 
 int RecordingMapTool::recordingInterval() const
@@ -1440,6 +1846,7 @@ void RecordingMapTool::setActiveLayer( QgsVectorLayer *newActiveLayer )
   }
 
   mActiveLayer = newActiveLayer;
+  mValidGeometryKnown = false;
   emit activeLayerChanged( mActiveLayer );
 
   // we need to clear all recorded points and recalculate the geometry
@@ -1456,6 +1863,11 @@ void RecordingMapTool::setActiveLayer( QgsVectorLayer *newActiveLayer )
     mActiveLayer->startEditing();
     mMinUndoStackIndex = mActiveLayer->undoStack()->index();
   }
+
+  if ( mRecordingType == StreamMode )
+  {
+    setupStreamSimplifier();
+  }
 }
 
 const QgsGeometry &RecordingMapTool::recordedGeometry() const
@@ -1510,6 +1922,11 @@ void RecordingMapTool::setHandles( const QgsGeometry &newHandles )
   emit handlesChanged( mHandles );
 }
 
+const QgsGeometry &RecordingMapTool::streamedTail() const
+{
+  return mStreamedTail;
+}
+
 RecordingMapTool::MapToolState RecordingMapTool::state() const
 {
   return mState;
@@ -23,6 +23,8 @@
 #include "position/positionkit.h"
 #include "inpututils.h"
 #include "streamingintervaltype.h"
+#include "vertexgridindex.h"
+#include "position/tracking/tracksimplifier.h"
 
 class PositionKit;
 class QgsVectorLayer;
@@ -94,6 +96,7 @@ class RecordingMapTool : public AbstractMapTool
     Q_PROPERTY( QgsGeometry existingVertices READ existingVertices WRITE setExistingVertices NOTIFY existingVerticesChanged )
     Q_PROPERTY( QgsGeometry midPoints READ midPoints WRITE setMidPoints NOTIFY midPointsChanged )
     Q_PROPERTY( QgsGeometry handles READ handles WRITE setHandles NOTIFY handlesChanged )
+    Q_PROPERTY( QgsGeometry streamedTail READ streamedTail NOTIFY streamedTailChanged )
 
     Q_PROPERTY( Vertex activeVertex READ activeVertex WRITE setActiveVertex NOTIFY activeVertexChanged )
     Q_PROPERTY( QgsGeometry activeVertexGeometry READ activeVertexGeometry WRITE setActiveVertexGeometry NOTIFY activeVertexGeometryChanged )
@@ -217,6 +220,12 @@ class RecordingMapTool : public AbstractMapTool
     const QgsGeometry &handles() const;
     void setHandles( const QgsGeometry &newHandles );
 
+    /**
+     * Returns segment from the end of the streamed line to the fix held back by the simplification of streamed
+     * points, empty if no fix is held back. The fix is only displayed, it is not a vertex of the recorded geometry.
+     */
+    const QgsGeometry &streamedTail() const;
+
     const QVector< Vertex > &collectedVertices() const;
 
     MapToolState state() const;
@@ -259,6 +268,7 @@ class RecordingMapTool : public AbstractMapTool
     void existingVerticesChanged( const QgsGeometry &existingVertices );
     void midPointsChanged( const QgsGeometry &midPoints );
     void handlesChanged( const QgsGeometry &handles );
+    void streamedTailChanged( const QgsGeometry &streamedTail );
     void stateChanged( const RecordingMapTool::MapToolState &state );
 
     void recordPointChanged( QgsPoint recordPoint );
@@ -274,6 +284,22 @@ class RecordingMapTool : public AbstractMapTool
     void canUndoChanged( bool canUndo );
     void activeFeatureChanged( const QgsFeature &activeFeature );
 
+    /**
+     * Emitted instead of recordedGeometryChanged when streaming appends a point to the end of a line.
+     * \a segment is the new last segment of the line, recordedGeometry is not re-read until the next
+     * recordedGeometryChanged (e.g. when streaming stops).
+     */
+    void recordedGeometryAppended( const QgsGeometry &segment );
+
+    /**
+     * Emitted with the new vertex when streaming appends a point, see recordedGeometryAppended.
+     * existingVertices and midPoints include the appended items after the next recordedGeometryChanged.
+     */
+    void existingVerticesAppended( const QgsGeometry &vertices );
+
+    //! Emitted with the new midpoint when streaming appends a point, see recordedGeometryAppended
+    void midPointsAppended( const QgsGeometry &midPoints );
+
   public slots:
     void onPositionChanged();
 
@@ -322,6 +348,49 @@ class RecordingMapTool : public AbstractMapTool
      */
     bool shouldBeVisible( QgsPoint point );
 
+    /**
+     * Finds the first vertex of every ring and the next vertex of every vertex in the ring,
+     * needs to be called whenever vertices are collected
+     */
+    void updateRingNeighbours();
+
+    /**
+     * Updates vertices affected by the move of vertex \a id (neighbouring midpoints and handles) in place.
+     * Returns FALSE if the vertices need to be collected again.
+     */
+    bool updateMovedVertex( const QgsVertexId &id );
+
+    //! Sets coordinates of vertex at \a index in the nodes index and updates the spatial index
+    void setVertexCoordinates( int index, const QgsPoint &point );
+
+    //! Builds spatial index of vertices in map CRS if it is not up to date
+    void updateVertexIndex();
+
+    //! Inserts \a pointToAdd (in active vector layer CRS) to the recorded geometry, see addPoint()
+    void insertPoint( const QgsPoint &pointToAdd );
+
+    //! Sets up simplification of streamed points with settings of the active layer's project
+    void setupStreamSimplifier();
+
+    //! Inserts the point held back by the simplification of streamed points
+    void flushStreamedPoints();
+
+    //! Updates streamedTail with the point held back by the simplification of streamed points
+    void updateStreamedTail();
+
+    /**
+     * Appends \a point to the end of the active line part while streaming. The nodes index is extended
+     * in place and only the new segment, vertex and midpoint are sent to QML. The points are written to
+     * the layer in batches, see commitStreamedPoints(). Returns FALSE if the point needs to be added the usual way.
+     */
+    bool appendStreamedPoint( const QgsPoint &point );
+
+    //! Writes points appended while streaming to the layer as one undo command
+    void commitStreamedPoints();
+
+    //! Checks whether the captured geometry has enough points for the active layer, see hasValidGeometry()
+    bool validateGeometry() const;
+
     QgsGeometry mRecordedGeometry;
 
     bool mCenteredToGPS = false;
@@ -332,6 +401,12 @@ class RecordingMapTool : public AbstractMapTool
     QDateTime mLastTimeRecorded;
     QgsPoint mLastRecordedPoint;
 
+    // drops redundant fixes in the streaming mode
+    TrackSimplifier mStreamSimplifier;
+
+    // segment to the fix held back by mStreamSimplifier, in active vector layer CRS
+    QgsGeometry mStreamedTail;
+
     QgsVectorLayer *mActiveLayer = nullptr; // not owned
     PositionKit *mPositionKit = nullptr; // not owned
 
@@ -344,6 +419,31 @@ class RecordingMapTool : public AbstractMapTool
 
     QVector< Vertex > mVertices;
 
+    // position of the next vertex in the same ring for every item of mVertices,
+    // last vertex of a ring points to the first one
+    QVector< int > mNextVertices;
+
+    // position of the first item of the ring (part, ring) in mVertices
+    QHash< QPair< int, int >, int > mRingStarts;
+
+    // mVertices in map CRS used for hit testing, built when needed
+    VertexGridIndex mVertexIndex;
+    QgsCoordinateReferenceSystem mVertexIndexCrs;
+    bool mVertexIndexValid = false;
+
+    // vertex moved by the current edit, its neighbours are updated in place
+    QgsVertexId mMovedVertexId;
+
+    // result of hasValidGeometry(), valid until the recorded geometry changes
+    mutable bool mValidGeometryKnown = false;
+    mutable bool mValidGeometry = false;
+
+    // points were appended while streaming without emitting recordedGeometryChanged
+    bool mHasAppendedPoints = false;
+
+    // number of points appended while streaming which are not written to the layer yet
+    int mPendingStreamedPoints = 0;
+
     QgsPoint mRecordPoint;
 
     // ActiveVertex is set only when we grab a point,
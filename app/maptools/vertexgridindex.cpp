@@ -0,0 +1,149 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "vertexgridindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void VertexGridIndex::build( const QVector<QgsPointXY> &points )
+{
+  clear();
+
+  if ( points.isEmpty() )
+    return;
+
+  mPoints = points;
+
+  mExtent = QgsRectangle( points.first(), points.first() );
+  for ( const QgsPointXY &point : points )
+  {
+    mExtent.include( point );
+  }
+
+  // roughly one point per cell, cells are squares
+  const double width = std::max( mExtent.width(), mExtent.height() * 1e-3 );
+  const double height = std::max( mExtent.height(), mExtent.width() * 1e-3 );
+  mCellSize = std::sqrt( width * height / points.count() );
+  if ( !( mCellSize > 0 ) || !std::isfinite( mCellSize ) )
+  {
+    // all the points are at the same place
+    mCellSize = 1;
+  }
+
+  const double maxCells = static_cast<double>( points.count() );
+  mColumns = static_cast<int>( std::clamp( std::ceil( width / mCellSize ), 1.0, maxCells ) );
+  mRows = static_cast<int>( std::clamp( std::ceil( height / mCellSize ), 1.0, maxCells ) );
+  mCells.resize( mColumns * mRows );
+
+  for ( int i = 0; i < mPoints.count(); ++i )
+  {
+    mCells[cell( mPoints.at( i ) )].append( i );
+  }
+}
+
+void VertexGridIndex::clear()
+{
+  mPoints.clear();
+  mCells.clear();
+  mExtent = QgsRectangle();
+  mCellSize = 1;
+  mColumns = 0;
+  mRows = 0;
+}
+
+bool VertexGridIndex::isEmpty() const
+{
+  return mPoints.isEmpty();
+}
+
+int VertexGridIndex::count() const
+{
+  return static_cast<int>( mPoints.count() );
+}
+
+QgsPointXY VertexGridIndex::point( int index ) const
+{
+  return mPoints.value( index );
+}
+
+void VertexGridIndex::movePoint( int index, const QgsPointXY &point )
+{
+  if ( index < 0 || index >= mPoints.count() )
+    return;
+
+  const int oldCell = cell( mPoints.at( index ) );
+  const int newCell = cell( point );
+  mPoints[index] = point;
+
+  if ( oldCell != newCell )
+  {
+    mCells[oldCell].removeOne( index );
+    mCells[newCell].append( index );
+  }
+}
+
+int VertexGridIndex::nearest( const QgsPointXY &point, double maxDistance ) const
+{
+  if ( mPoints.isEmpty() )
+    return -1;
+
+  const int minColumn = column( point.x() - maxDistance );
+  const int maxColumn = column( point.x() + maxDistance );
+  const int minRow = row( point.y() - maxDistance );
+  const int maxRow = row( point.y() + maxDistance );
+
+  int nearestIndex = -1;
+  double minDistance = std::numeric_limits<double>::max();
+
+  for ( int r = minRow; r <= maxRow; ++r )
+  {
+    for ( int c = minColumn; c <= maxColumn; ++c )
+    {
+      for ( int index : mCells.at( r * mColumns + c ) )
+      {
+        const double distance = point.distance( mPoints.at( index ) );
+        if ( distance > maxDistance )
+          continue;
+
+        if ( distance < minDistance || ( distance == minDistance && index < nearestIndex ) )
+        {
+          minDistance = distance;
+          nearestIndex = index;
+        }
+      }
+    }
+  }
+
+  return nearestIndex;
+}
+
+int VertexGridIndex::column( double x ) const
+{
+  const double c = std::floor( ( x - mExtent.xMinimum() ) / mCellSize );
+  if ( std::isnan( c ) )
+    return 0;
+
+  return static_cast<int>( std::clamp( c, 0.0, static_cast<double>( mColumns - 1 ) ) );
+}
+
+int VertexGridIndex::row( double y ) const
+{
+  const double r = std::floor( ( y - mExtent.yMinimum() ) / mCellSize );
+  if ( std::isnan( r ) )
+    return 0;
+
+  return static_cast<int>( std::clamp( r, 0.0, static_cast<double>( mRows - 1 ) ) );
+}
+
+int VertexGridIndex::cell( const QgsPointXY &point ) const
+{
+  return row( point.y() ) * mColumns + column( point.x() );
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef VERTEXGRIDINDEX_H
+#define VERTEXGRIDINDEX_H
+
+#include <QVector>
+
+#include "qgspointxy.h"
+#include "qgsrectangle.h"
+
+#include "inputconfig.h"
+
+/**
+ * Spatial index of points (vertices of the edited geometry in map coordinates) used for hit testing.
+ *
+ * Points are bucketed to a regular grid which covers their bounding box with roughly one point
+ * per cell, so a search around a point only visits a few cells. Points are referenced by their
+ * position in the list passed to build() and can be moved without rebuilding the whole grid.
+ * Points moved out of the original bounding box are kept in the border cells.
+ */
+class VertexGridIndex
+{
+  public:
+    VertexGridIndex() = default;
+
+    //! Builds the index of \a points, previous content is dropped
+    void build( const QVector<QgsPointXY> &points );
+
+    //! Removes all points
+    void clear();
+
+    //! Returns TRUE if there are no points in the index
+    bool isEmpty() const;
+
+    //! Returns number of indexed points
+    int count() const;
+
+    //! Returns the point at \a index
+    QgsPointXY point( int index ) const;
+
+    //! Moves the point at \a index to \a point
+    void movePoint( int index, const QgsPointXY &point );
+
+    /**
+     * Returns index of the point closest to \a point within \a maxDistance, -1 if there is none.
+     * When more points have the same distance, the one with the lowest index is returned.
+     */
+    int nearest( const QgsPointXY &point, double maxDistance ) const;
+
+  private:
+    int column( double x ) const;
+    int row( double y ) const;
+    int cell( const QgsPointXY &point ) const;
+
+    QVector<QgsPointXY> mPoints;
+    QVector<QVector<int>> mCells;
+    QgsRectangle mExtent;
+    double mCellSize = 1;
+    int mColumns = 0;
+    int mRows = 0;
+};
+
+#endif // VERTEXGRIDINDEX_H
@@ -38,44 +38,40 @@ void PositionTrackingManager::addPoint( const QgsPoint &position )
   if ( position.isEmpty() )
     return;
 
-  int pointsCount = mTrackedGeometry.constGet()->vertexCount();
+  appendToTrack( mSimplifier.addPoint( position ) );
+}
 
-  mTrackedGeometry.get()->insertVertex( QgsVertexId( 0, 0, pointsCount ), position );
+void PositionTrackingManager::addPoints( const QList<QgsPoint> &positions )
+{
+  QgsPointSequence points;
+  for ( const QgsPoint &position : positions )
+  {
+    points << mSimplifier.addPoint( position );
+  }
 
-  emit trackedGeometryChanged( mTrackedGeometry );
+  appendToTrack( points );
 }
 
-void PositionTrackingManager::addPoints( const QList<QgsPoint> &positions )
+void PositionTrackingManager::appendToTrack( const QgsPointSequence &points )
 {
-  // get points from the previous geometry
-  QgsLineString *oldLine = nullptr;
-  oldLine = qgsgeometry_cast<QgsLineString *>( mTrackedGeometry.constGet() );
+  // the fix held back by the track simplification moves the end of the track, see trackedGeometry()
+  if ( points.isEmpty() && !mSimplifier.hasPendingPoint() )
+    return;
+
+  QgsLineString *line = qgsgeometry_cast<QgsLineString *>( mTrackedGeometry.get() );
 
-  if ( !oldLine )
+  if ( !line )
   {
     qDebug() << "Error, tracked geometry is not a line";
     return;
   }
 
-  QList<double> xValues = oldLine->xVector();
-  QList<double> yValues = oldLine->yVector();
-  QList<double> zValues = oldLine->zVector();
-  QList<double> mValues = oldLine->mVector();
-
-  QListIterator<QgsPoint> positionsIterator( positions );
-  while ( positionsIterator.hasNext() )
+  for ( const QgsPoint &point : points )
   {
-    const QgsPoint &p = positionsIterator.next();
-    xValues += p.x();
-    yValues += p.y();
-    zValues += p.z();
-    mValues += p.m();
+    line->addVertex( point );
   }
 
-  QgsLineString *newLine = new QgsLineString( xValues, yValues, zValues, mValues );
-  mTrackedGeometry.set( newLine );
-
-  emit trackedGeometryChanged( mTrackedGeometry );
+  emit trackedGeometryChanged( trackedGeometry() );
 }
 
 void PositionTrackingManager::commitTrackedPath()
@@ -94,6 +90,10 @@ void PositionTrackingManager::commitTrackedPath()
     return;
   }
 
+  // the last fix may be held back by the track simplification
+  appendToTrack( mSimplifier.flush() );
+  mSimplifier.finishRawTrack();
+
   // convert captured geometry to the destination layer's CRS
   QgsGeometry geometryInLayerCRS = InputUtils::transformGeometry( mTrackedGeometry, QgsCoordinateReferenceSystem::fromEpsgId( 4326 ), trackingLayer );
 
@@ -167,6 +167,20 @@ void PositionTrackingManager::setup()
 
   setLayerId( trackingLayerId );
 
+  // updates through file survive restarts of the app, the track (and its raw track) continues
+  QList<QgsPoint> positions;
+  if ( mTrackingBackend->trackingMethod() == AbstractTrackingBackend::TrackingMethod::UpdatesThroughFile )
+  {
+    positions = mTrackingBackend->getAllUpdates();
+  }
+
+  mSimplifier.setup(
+    TrackSimplifier::readSettings( mQgsProject ),
+    crs(),
+    TrackSimplifier::rawTrackFilePath( mQgsProject, QStringLiteral( "tracking" ) ),
+    !positions.isEmpty()
+  );
+
   mTrackingStartTime = QDateTime::currentDateTime();
   emit startTimeChanged( mTrackingStartTime );
 
@@ -183,8 +197,14 @@ void PositionTrackingManager::setup()
   }
   else if ( mTrackingBackend->trackingMethod() == AbstractTrackingBackend::TrackingMethod::UpdatesThroughFile )
   {
-    QList<QgsPoint> positions = mTrackingBackend->getAllUpdates();
-    QgsLineString *line = new QgsLineString( positions );
+    // the fixes were written to the raw track when they were received
+    QgsPointSequence points;
+    for ( const QgsPoint &position : std::as_const( positions ) )
+    {
+      points << mSimplifier.addPoint( position, true );
+    }
+
+    QgsLineString *line = new QgsLineString( points );
     mTrackedGeometry.set( line );
   }
 
@@ -205,9 +225,10 @@ void PositionTrackingManager::setup()
   emit isTrackingPositionChanged( true );
 
   // update highlight if the geometry is not empty
-  if ( mTrackedGeometry.constGet() && mTrackedGeometry.constGet()->vertexCount() )
+  const QgsGeometry geometry = trackedGeometry();
+  if ( geometry.constGet() && geometry.constGet()->vertexCount() )
   {
-    emit trackedGeometryChanged( mTrackedGeometry );
+    emit trackedGeometryChanged( geometry );
   }
 
   mElapsedTimeTextTimer.start( 1000 );
@@ -275,7 +296,20 @@ void PositionTrackingManager::setLayerId( QString newLayerId )
 
 QgsGeometry PositionTrackingManager::trackedGeometry() const
 {
-  return mTrackedGeometry;
+  if ( !mSimplifier.hasPendingPoint() )
+  {
+    return mTrackedGeometry;
+  }
+
+  // the held back fix is only displayed, it becomes a vertex once the simplification releases it
+  QgsGeometry geometry( mTrackedGeometry );
+  QgsLineString *line = qgsgeometry_cast<QgsLineString *>( geometry.get() );
+  if ( line )
+  {
+    line->addVertex( mSimplifier.pendingPoint() );
+  }
+
+  return geometry;
 }
 
 AbstractTrackingBackend *PositionTrackingManager::trackingBackend() const
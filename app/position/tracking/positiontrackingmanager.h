@@ -16,6 +16,7 @@
 #include <QTimer>
 
 #include "abstracttrackingbackend.h"
+#include "tracksimplifier.h"
 
 #include "qgsgeometry.h"
 #include "qgsfeature.h"
@@ -52,7 +53,10 @@ class PositionTrackingManager : public QObject
     //! Returns the id of the layer used for tracking
     QString layerId() const;
 
-    //! Returns the current tracked geometry
+    /**
+     * Returns the current tracked geometry. It ends with the fix held back by the track simplification (if any),
+     * which is not a vertex of the track until the simplification releases it or the track is committed.
+     */
     QgsGeometry trackedGeometry() const;
 
     //! Gets and sets the tracking backend
@@ -110,6 +114,9 @@ class PositionTrackingManager : public QObject
     void setLayerId( QString newLayerId );
     void setup();
 
+    //! Appends \a points to the tracked geometry
+    void appendToTrack( const QgsPointSequence &points );
+
     std::unique_ptr<AbstractTrackingBackend> mTrackingBackend; // owned
 
     QString mLayerId;
@@ -118,6 +125,9 @@ class PositionTrackingManager : public QObject
 
     QgsGeometry mTrackedGeometry;
 
+    // drops redundant fixes before they are added to the tracked geometry
+    TrackSimplifier mSimplifier;
+
     QDateTime mTrackingStartTime;
     QgsFeature mTrackedFeature;
     bool mIsTrackingPosition = false;
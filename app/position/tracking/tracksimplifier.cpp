@@ -0,0 +1,304 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tracksimplifier.h"
+
+#include "qgis.h"
+#include "qgsproject.h"
+#include "qgsunittypes.h"
+
+#include "coreutils.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+#include <cmath>
+
+//! Directory of the raw track side files inside the application data directory
+static const QString RAW_TRACKS_DIR = QStringLiteral( "raw_tracks" );
+
+//! Length of one degree of latitude (and of longitude on the equator) in meters, precise enough for tolerances
+static constexpr double METERS_PER_DEGREE = 111319.49;
+
+TrackSimplifier::Settings TrackSimplifier::readSettings( const QgsProject *project )
+{
+  Settings settings;
+  if ( !project )
+  {
+    return settings;
+  }
+
+  settings.enabled = project->readBoolEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/Enabled" ), settings.enabled );
+  settings.tolerance = project->readDoubleEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/Tolerance" ), settings.tolerance );
+  settings.minDistance = project->readDoubleEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/MinDistance" ), settings.minDistance );
+  settings.maxAngle = project->readDoubleEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/MaxAngle" ), settings.maxAngle );
+  settings.keepRawTrack = project->readBoolEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/KeepRawTrack" ), settings.keepRawTrack );
+  return settings;
+}
+
+QString TrackSimplifier::rawTrackFilePath( const QgsProject *project, const QString &name )
+{
+  if ( !project || project->homePath().isEmpty() )
+  {
+    return QString();
+  }
+
+  // files inside of the project directory would be synchronized with the project
+  const QString dataDir = QStandardPaths::writableLocation( QStandardPaths::AppDataLocation );
+  if ( dataDir.isEmpty() )
+  {
+    return QString();
+  }
+
+  const QRegularExpression invalidCharacters( QStringLiteral( "[^\\w\\-]" ) );
+
+  QString projectName = QFileInfo( project->homePath() ).fileName();
+  projectName.replace( invalidCharacters, QStringLiteral( "_" ) );
+
+  QString fileName = name;
+  fileName.replace( invalidCharacters, QStringLiteral( "_" ) );
+
+  return QDir( dataDir ).filePath( QStringLiteral( "%1/%2/%3.txt" ).arg( RAW_TRACKS_DIR, projectName, fileName ) );
+}
+
+void TrackSimplifier::setup( const Settings &settings, const QgsCoordinateReferenceSystem &crs, const QString &rawTrackPath, bool continueRawTrack )
+{
+  mSettings = settings;
+  mIsGeographic = crs.isGeographic();
+  mUnitsToMeters = crs.isValid() && !mIsGeographic ? QgsUnitTypes::fromUnitToUnitFactor( crs.mapUnits(), Qgis::DistanceUnit::Meters ) : 1;
+  reset();
+
+  if ( mRawTrackFile.isOpen() )
+  {
+    mRawTrackFile.close();
+  }
+  mRawTrackFile.setFileName( QString() );
+
+  if ( !mSettings.enabled || !mSettings.keepRawTrack || rawTrackPath.isEmpty() )
+  {
+    return;
+  }
+
+  const QString rawTracksDir = QFileInfo( rawTrackPath ).absolutePath();
+  QDir().mkpath( rawTracksDir );
+  removeExpiredRawTracks( rawTracksDir );
+
+  mRawTrackFile.setFileName( rawTrackPath );
+
+  const QIODevice::OpenMode mode = continueRawTrack ? QIODevice::Append : QIODevice::Truncate;
+  if ( !mRawTrackFile.open( QIODevice::WriteOnly | QIODevice::Text | mode ) )
+  {
+    CoreUtils::log( QStringLiteral( "Track simplification" ), QStringLiteral( "Raw track file could not be opened: %1" ).arg( rawTrackPath ) );
+    return;
+  }
+
+  if ( mRawTrackFile.size() == 0 )
+  {
+    // the line is skipped when the file is parsed as position updates
+    mRawTrackFile.write( QStringLiteral( "# %1\n" ).arg( crs.authid() ).toUtf8() );
+  }
+}
+
+const TrackSimplifier::Settings &TrackSimplifier::settings() const
+{
+  return mSettings;
+}
+
+QString TrackSimplifier::rawTrackPath() const
+{
+  return mRawTrackFile.isOpen() ? mRawTrackFile.fileName() : QString();
+}
+
+QgsPointSequence TrackSimplifier::addPoint( const QgsPoint &point, bool isReplayed )
+{
+  if ( !isReplayed )
+  {
+    writeRawPoint( point );
+  }
+
+  if ( !mSettings.enabled )
+  {
+    return { point };
+  }
+
+  if ( !mHasAnchor )
+  {
+    mAnchor = point;
+    mHasAnchor = true;
+    return { point };
+  }
+
+  // stationary fixes are compared with the last kept fix, so that slow drift is not lost
+  const QgsPoint &previous = mWindow.isEmpty() ? mAnchor : mWindow.last();
+  if ( toLocal( point ).distance( toLocal( previous ) ) < mSettings.minDistance )
+  {
+    return {};
+  }
+
+  QgsPointSequence points;
+  if ( !mWindow.isEmpty() && !fitsWindow( point ) )
+  {
+    // the last fix of the window becomes a vertex and a new window starts from it
+    mAnchor = mWindow.last();
+    mWindow.clear();
+    points << mAnchor;
+  }
+
+  mWindow << point;
+  return points;
+}
+
+QgsPointSequence TrackSimplifier::flush()
+{
+  if ( mWindow.isEmpty() )
+  {
+    return {};
+  }
+
+  mAnchor = mWindow.last();
+  mWindow.clear();
+  return { mAnchor };
+}
+
+bool TrackSimplifier::hasPendingPoint() const
+{
+  return !mWindow.isEmpty();
+}
+
+QgsPoint TrackSimplifier::pendingPoint() const
+{
+  return mWindow.isEmpty() ? QgsPoint() : mWindow.last();
+}
+
+void TrackSimplifier::reset()
+{
+  mHasAnchor = false;
+  mAnchor = QgsPoint();
+  mWindow.clear();
+}
+
+void TrackSimplifier::finishRawTrack()
+{
+  if ( !mRawTrackFile.isOpen() )
+  {
+    return;
+  }
+
+  mRawTrackFile.close();
+
+  const QFileInfo fileInfo( mRawTrackFile.fileName() );
+  const QString timestamp = QDateTime::currentDateTime().toString( QStringLiteral( "yyyyMMdd_hhmmss" ) );
+  const QString finishedPath = fileInfo.dir().filePath( QStringLiteral( "%1_%2.txt" ).arg( fileInfo.completeBaseName(), timestamp ) );
+
+  if ( !mRawTrackFile.rename( finishedPath ) )
+  {
+    CoreUtils::log( QStringLiteral( "Track simplification" ), QStringLiteral( "Raw track could not be renamed to %1" ).arg( finishedPath ) );
+  }
+
+  mRawTrackFile.setFileName( QString() );
+}
+
+void TrackSimplifier::removeRawTrack()
+{
+  if ( !mRawTrackFile.isOpen() )
+  {
+    return;
+  }
+
+  mRawTrackFile.close();
+  mRawTrackFile.remove();
+  mRawTrackFile.setFileName( QString() );
+}
+
+void TrackSimplifier::removeExpiredRawTracks( const QString &dirPath )
+{
+  const QDateTime expiration = QDateTime::currentDateTime().addDays( -RAW_TRACK_RETENTION_DAYS );
+
+  // open raw tracks are written with every fix, only the finished ones stay untouched for so long
+  const QFileInfoList files = QDir( dirPath ).entryInfoList( { QStringLiteral( "*.txt" ) }, QDir::Files );
+  for ( const QFileInfo &file : files )
+  {
+    if ( file.lastModified() < expiration )
+    {
+      QFile::remove( file.absoluteFilePath() );
+    }
+  }
+}
+
+QgsPointXY TrackSimplifier::toLocal( const QgsPoint &point ) const
+{
+  const double dx = point.x() - mAnchor.x();
+  const double dy = point.y() - mAnchor.y();
+
+  if ( mIsGeographic )
+  {
+    // equirectangular approximation around the anchor, tracks are short compared to the Earth
+    return QgsPointXY( dx * METERS_PER_DEGREE * std::cos( mAnchor.y() * M_PI / 180 ), dy * METERS_PER_DEGREE );
+  }
+
+  return QgsPointXY( dx * mUnitsToMeters, dy * mUnitsToMeters );
+}
+
+bool TrackSimplifier::fitsWindow( const QgsPoint &point ) const
+{
+  if ( mWindow.count() >= MAX_WINDOW_SIZE )
+  {
+    return false;
+  }
+
+  const QgsPointXY end = toLocal( point );
+  const QgsPointXY last = toLocal( mWindow.last() );
+
+  // direction of the window compared to the direction of the new step
+  const double windowDirection = std::atan2( last.y(), last.x() );
+  const double stepDirection = std::atan2( end.y() - last.y(), end.x() - last.x() );
+  double turn = std::fabs( stepDirection - windowDirection ) * 180 / M_PI;
+  if ( turn > 180 )
+  {
+    turn = 360 - turn;
+  }
+
+  if ( turn > mSettings.maxAngle )
+  {
+    return false;
+  }
+
+  // the anchor is the origin of the local coordinates
+  const double sqrTolerance = mSettings.tolerance * mSettings.tolerance;
+  QgsPointXY closest;
+  for ( const QgsPoint &fix : mWindow )
+  {
+    if ( toLocal( fix ).sqrDistToSegment( 0, 0, end.x(), end.y(), closest ) > sqrTolerance )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void TrackSimplifier::writeRawPoint( const QgsPoint &point )
+{
+  if ( !mRawTrackFile.isOpen() )
+  {
+    return;
+  }
+
+  const QString line = QStringLiteral( "%1 %2 %3 %4\n" ).arg( qgsDoubleToString( point.x(), 8 ),
+                       qgsDoubleToString( point.y(), 8 ),
+                       qgsDoubleToString( point.z(), 3 ),
+                       qgsDoubleToString( point.m(), 3 ) );
+  mRawTrackFile.write( line.toUtf8() );
+
+  // keep the raw track even if the app gets killed
+  mRawTrackFile.flush();
+}
@@ -0,0 +1,135 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACKSIMPLIFIER_H
+#define TRACKSIMPLIFIER_H
+
+#include <QFile>
+#include <QString>
+
+#include "qgspoint.h"
+#include "qgsabstractgeometry.h"
+#include "qgscoordinatereferencesystem.h"
+
+class QgsProject;
+
+/**
+ * Online simplification of a track recorded from position updates, used before the fixes
+ * enter the tracked (or streamed) geometry.
+ *
+ * The simplifier keeps the last vertex of the track (anchor) and a window of fixes received
+ * after it. A new fix extends the window as long as the segment from the anchor to the fix
+ * passes within the tolerance of all fixes in the window and the direction does not change
+ * more than the maximum angle - it is an opening window variant of Douglas-Peucker. Otherwise
+ * the last fix of the window becomes a new vertex. Fixes closer than the minimum distance to the
+ * last kept fix are treated as stationary and dropped.
+ *
+ * The last fix of the window is held back until the window closes, flush() returns it when the
+ * track ends. Until then pendingPoint() can be shown as the end of the track, so that the drawn
+ * track does not lag behind the position. All fixes can be written to a side file with the raw
+ * track, one fix per line in the "x y z m" format with coordinates in the CRS of the track.
+ * Raw tracks are stored in the application data, outside of the synchronized project directory.
+ * A finished raw track is kept under a timestamped name for RAW_TRACK_RETENTION_DAYS, a discarded
+ * one is removed.
+ */
+class TrackSimplifier
+{
+  public:
+
+    struct Settings
+    {
+      bool enabled = false;
+      double tolerance = 2; //!< maximum distance of dropped fixes from the simplified track in meters
+      double minDistance = 1; //!< fixes closer than this to the last kept fix are dropped, in meters
+      double maxAngle = 45; //!< change of direction which always creates a vertex, in degrees
+      bool keepRawTrack = false; //!< whether all fixes should be written to a side file
+    };
+
+    //! Maximum number of fixes in the window, bounds the time spent with each fix
+    static constexpr int MAX_WINDOW_SIZE = 100;
+
+    //! Finished raw tracks older than this are removed when a new raw track starts
+    static constexpr int RAW_TRACK_RETENTION_DAYS = 30;
+
+    TrackSimplifier() = default;
+
+    //! Reads the simplification settings from the Mergin entries of \a project
+    static Settings readSettings( const QgsProject *project );
+
+    /**
+     * Returns path of the side file with the raw track \a name of \a project. The path is the same for the whole
+     * track, also when it continues after the app restarts. The file is in the application data directory,
+     * so that the location history is not synchronized together with the project.
+     */
+    static QString rawTrackFilePath( const QgsProject *project, const QString &name );
+
+    /**
+     * Starts a new track with \a settings, points will be in \a crs. When the raw track should be
+     * kept, fixes are written to \a rawTrackPath. Fixes already in the file are kept only if
+     * \a continueRawTrack is TRUE (the track continues, e.g. after the app restarts), otherwise
+     * they are left from a track which was never finished and the file starts again.
+     */
+    void setup( const Settings &settings, const QgsCoordinateReferenceSystem &crs, const QString &rawTrackPath = QString(), bool continueRawTrack = false );
+
+    const Settings &settings() const;
+
+    //! Returns path of the side file with the raw track, empty if it is not written
+    QString rawTrackPath() const;
+
+    /**
+     * Adds a fix to the track, returns points which should be appended to the geometry.
+     * All fixes are returned when the simplification is disabled. Fixes which were received
+     * before (\a isReplayed, e.g. read again after the app restarts) are not written to the raw track.
+     */
+    QgsPointSequence addPoint( const QgsPoint &point, bool isReplayed = false );
+
+    //! Returns the fix held back in the window (if any), it should be appended when the track ends
+    QgsPointSequence flush();
+
+    //! Returns whether a fix is held back in the window, see pendingPoint()
+    bool hasPendingPoint() const;
+
+    /**
+     * Returns the fix held back in the window, it is not a vertex of the track (yet) and should be
+     * used only to display the end of the track. Returns an empty point if no fix is held back.
+     */
+    QgsPoint pendingPoint() const;
+
+    //! Forgets the anchor and the window, the next fix starts a new track. Settings are kept.
+    void reset();
+
+    //! Closes the raw track (if any) and keeps it under a name with the current time, the next track starts a new file
+    void finishRawTrack();
+
+    //! Closes and deletes the raw track (if any), e.g. when the recorded geometry is discarded
+    void removeRawTrack();
+
+  private:
+    //! Returns coordinates of \a point relative to the anchor in meters
+    QgsPointXY toLocal( const QgsPoint &point ) const;
+
+    bool fitsWindow( const QgsPoint &point ) const;
+
+    void writeRawPoint( const QgsPoint &point );
+
+    //! Removes finished raw tracks in \a dirPath older than RAW_TRACK_RETENTION_DAYS
+    static void removeExpiredRawTracks( const QString &dirPath );
+
+    Settings mSettings;
+    bool mIsGeographic = false;
+    double mUnitsToMeters = 1;
+
+    bool mHasAnchor = false;
+    QgsPoint mAnchor;
+    QgsPointSequence mWindow;
+
+    QFile mRawTrackFile;
+};
+
+#endif // TRACKSIMPLIFIER_H
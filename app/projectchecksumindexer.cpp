@@ -0,0 +1,159 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "projectchecksumindexer.h"
+#include "projectchecksumcache.h"
+#include "merginapi.h"
+#include "coreutils.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "qgsproject.h"
+#include "qgsvectorlayer.h"
+
+const int ProjectChecksumIndexer::IDLE_DELAY_MS = 30 * 1000;
+
+ProjectChecksumIndexer::ProjectChecksumIndexer(
+  QgsProject *openedQgsProject,
+  const QString &projectDir,
+  QObject *parent
+)
+  : QObject( parent )
+  , mQgsProject( openedQgsProject )
+  , mProjectDir( projectDir )
+  , mCanceled( std::make_shared<std::atomic_bool>( false ) )
+{
+  mIdleTimer.setSingleShot( true );
+  mIdleTimer.setInterval( IDLE_DELAY_MS );
+  connect( &mIdleTimer, &QTimer::timeout, this, &ProjectChecksumIndexer::startIndexing );
+
+  connect( &mIndexingWatcher, &QFutureWatcher<void>::finished, this, [this]()
+  {
+    emit indexingFinished();
+
+    if ( mRescheduleAfterIndexing )
+    {
+      mRescheduleAfterIndexing = false;
+      scheduleIndexing();
+    }
+  } );
+
+  if ( !mQgsProject || mProjectDir.isEmpty() )
+  {
+    CoreUtils::log( QStringLiteral( "Checksum indexer" ), QStringLiteral( "Received an invalid active project data" ) );
+    return;
+  }
+
+  // Register for data change of project's vector layers, photos are stored together with the features
+  const QMap<QString, QgsMapLayer *> layers = mQgsProject->mapLayers( true );
+  for ( QgsMapLayer *layer : layers )
+  {
+    registerLayer( layer );
+  }
+
+  connect( mQgsProject, &QgsProject::layersAdded, this, [this]( const QList<QgsMapLayer *> &addedLayers )
+  {
+    for ( QgsMapLayer *layer : addedLayers )
+    {
+      registerLayer( layer );
+    }
+  } );
+
+  // files could have been changed while the project was closed (e.g. after sync), index them too
+  scheduleIndexing();
+}
+
+ProjectChecksumIndexer::~ProjectChecksumIndexer()
+{
+  // the worker only holds copies of its arguments, it stops at the next chunk of the file being hashed
+  *mCanceled = true;
+}
+
+void ProjectChecksumIndexer::registerLayer( QgsMapLayer *layer )
+{
+  QgsVectorLayer *vecLayer = qobject_cast<QgsVectorLayer *>( layer );
+  if ( vecLayer && !vecLayer->readOnly() )
+  {
+    connect( vecLayer, &QgsVectorLayer::afterCommitChanges, this, &ProjectChecksumIndexer::scheduleIndexing, Qt::UniqueConnection );
+  }
+}
+
+QThreadPool *ProjectChecksumIndexer::threadPool()
+{
+  // one thread is enough, we do not want to compete with the UI for the disk nor CPU.
+  // It also makes sure that indexers of the same project never write the cache at the same time
+  static QThreadPool *pool = []()
+  {
+    QThreadPool *p = new QThreadPool( QCoreApplication::instance() );
+    p->setMaxThreadCount( 1 );
+    return p;
+  }();
+  return pool;
+}
+
+void ProjectChecksumIndexer::scheduleIndexing()
+{
+  if ( isIndexing() )
+  {
+    // files might have changed after the running indexing has visited them
+    mRescheduleAfterIndexing = true;
+    return;
+  }
+
+  mIdleTimer.start();
+}
+
+bool ProjectChecksumIndexer::isIndexing() const
+{
+  return mIndexingWatcher.isRunning();
+}
+
+void ProjectChecksumIndexer::startIndexing()
+{
+  if ( isIndexing() || mProjectDir.isEmpty() )
+    return;
+
+  mIndexingWatcher.setFuture( QtConcurrent::run( threadPool(), &ProjectChecksumIndexer::indexProjectFiles, mProjectDir, mCanceled ) );
+}
+
+void ProjectChecksumIndexer::indexProjectFiles( const QString &projectDir, std::shared_ptr<std::atomic_bool> canceled )
+{
+  QThread::currentThread()->setPriority( QThread::IdlePriority );
+
+  QElapsedTimer timer;
+  timer.start();
+
+  {
+    // same paths and cache as MerginApi::getLocalProjectFiles(), cache is saved when destroyed
+    QString projectPath = projectDir + "/";
+    ProjectChecksumCache checksumCache( projectPath );
+
+    const QSet<QString> files = MerginApi::listFiles( projectPath );
+    for ( const QString &path : files )
+    {
+      if ( *canceled )
+        break;
+
+      // only recalculates files that are new or modified since the last time
+      checksumCache.get( path, canceled.get() );
+    }
+  }
+
+  qint64 elapsed = timer.elapsed();
+  if ( elapsed > 100 )
+  {
+    CoreUtils::log( QStringLiteral( "Checksum indexer" ), QStringLiteral( "It took %1 ms to index %2" ).arg( elapsed ).arg( projectDir ) );
+  }
+
+  QThread::currentThread()->setPriority( QThread::InheritPriority );
+}
@@ -0,0 +1,77 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROJECTCHECKSUMINDEXER_H
+#define PROJECTCHECKSUMINDEXER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFutureWatcher>
+
+#include <atomic>
+#include <memory>
+
+#include "inputconfig.h"
+
+class QgsProject;
+class QgsMapLayer;
+class QThreadPool;
+
+/**
+ * Precomputes checksums of the files of the opened project in the background,
+ * so the ProjectChecksumCache is already warm when the user starts sync.
+ *
+ * Indexing runs in a single idle-priority thread once the project has not been
+ * changed (layers committed, photos captured) for a while. The thread is shared by
+ * all indexers, so the indexer of a closed project never blocks the opening of the
+ * next one - it is canceled and the next indexing waits for it in the queue.
+ */
+class ProjectChecksumIndexer : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    explicit ProjectChecksumIndexer( QgsProject *openedQgsProject, const QString &projectDir, QObject *parent = nullptr );
+    virtual ~ProjectChecksumIndexer();
+
+    //! Restarts the idle countdown after which the project files are indexed
+    void scheduleIndexing();
+
+    //! Returns true if the indexing is running in the background
+    bool isIndexing() const;
+
+    //! Time (in ms) the project needs to stay unchanged before the indexing starts
+    static const int IDLE_DELAY_MS;
+
+  signals:
+    void indexingFinished();
+
+  private:
+    void startIndexing();
+
+    //! Schedules indexing whenever changes of the \a layer are committed
+    void registerLayer( QgsMapLayer *layer );
+
+    //! Single-thread pool shared by all indexers
+    static QThreadPool *threadPool();
+
+    //! Calculates checksums of changed project files, runs in the worker thread
+    static void indexProjectFiles( const QString &projectDir, std::shared_ptr<std::atomic_bool> canceled );
+
+    QgsProject *mQgsProject = nullptr; // not owned
+    QString mProjectDir;
+
+    QTimer mIdleTimer;
+    QFutureWatcher<void> mIndexingWatcher;
+    std::shared_ptr<std::atomic_bool> mCanceled;
+    bool mRescheduleAfterIndexing = false;
+};
+
+#endif // PROJECTCHECKSUMINDEXER_H
@@ -39,11 +39,13 @@ void ProjectsModel::initializeProjectsModel()
   if ( mModelType == ProjectModelTypes::LocalProjectsModel )
   {
     QObject::connect( mBackend, &MerginApi::listProjectsByNameFinished, this, &ProjectsModel::onListProjectsByNameFinished );
+    QObject::connect( mBackend, &MerginApi::listProjectsByNameLoadedFromCache, this, &ProjectsModel::onListProjectsByNameLoadedFromCache );
     loadLocalProjects();
   }
   else if ( mModelType != ProjectModelTypes::RecentProjectsModel )
   {
     QObject::connect( mBackend, &MerginApi::listProjectsFinished, this, &ProjectsModel::onListProjectsFinished );
+    QObject::connect( mBackend, &MerginApi::listProjectsLoadedFromCache, this, &ProjectsModel::onListProjectsLoadedFromCache );
   }
   else
   {
@@ -185,10 +187,9 @@ void ProjectsModel::listProjects( const QString &searchExpression, int page )
 
   if ( !mLastRequestId.isEmpty() )
   {
+    // projects are not cleared here, the new listing (cached or from server) is applied as a delta
+    mRequestedSearchExpression = searchExpression;
     setModelIsLoading( true );
-    // clear only after requesting the very first page, otherwise we want to append results to the model
-    if ( page == 1 )
-      clearProjects();
   }
 }
 
@@ -204,7 +205,6 @@ void ProjectsModel::listProjectsByName()
   if ( !mLastRequestId.isEmpty() )
   {
     setModelIsLoading( true );
-    clearProjects();
   }
 }
 
@@ -225,25 +225,41 @@ void ProjectsModel::onListProjectsFinished( const MerginProjectsList &merginProj
     return;
   }
 
-  if ( page == 1 )
+  applyListedPage( merginProjects, projectsCount, page );
+  setModelIsLoading( false );
+}
+
+void ProjectsModel::onListProjectsLoadedFromCache( const MerginProjectsList &merginProjects, int projectsCount, int page, QString requestId )
+{
+  if ( mLastRequestId != requestId )
   {
-    // if we are populating first page, reset model and throw away previous projects
+    return;
+  }
+
+  // model keeps loading until the listing is revalidated with the server
+  applyListedPage( merginProjects, projectsCount, page );
+}
+
+void ProjectsModel::applyListedPage( const MerginProjectsList &merginProjects, int projectsCount, int page )
+{
+  if ( page == 1 && mRequestedSearchExpression != mListedSearchExpression )
+  {
+    // results of another search have nothing in common with the shown ones, no point in applying them as a delta
     beginResetModel();
-    mergeProjects( merginProjects, MergeStrategy::DiscardPrevious );
+    mProjects = mergedProjects( merginProjects );
     endResetModel();
+
+    mListedSearchExpression = mRequestedSearchExpression;
   }
   else
   {
-    // paginating next page, keep previous projects and emit model add items
-    beginInsertRows( QModelIndex(), mProjects.size(), mProjects.size() + merginProjects.size() - 1 );
-    mergeProjects( merginProjects, MergeStrategy::KeepPrevious );
-    endInsertRows();
+    // if we are populating first page, throw away previous projects, otherwise keep them and add the next page
+    mergeProjects( merginProjects, page == 1 ? MergeStrategy::DiscardPrevious : MergeStrategy::KeepPrevious );
   }
 
   mServerProjectsCount = projectsCount;
   mPaginatedPage = page;
   emit hasMoreProjectsChanged();
-  setModelIsLoading( false );
 }
 
 void ProjectsModel::onListProjectsByNameFinished( const MerginProjectsList &merginProjects, QString requestId )
@@ -253,22 +269,130 @@ void ProjectsModel::onListProjectsByNameFinished( const MerginProjectsList &merg
     return;
   }
 
-  beginResetModel();
   mergeProjects( merginProjects );
-  endResetModel();
 
   setModelIsLoading( false );
 }
 
+void ProjectsModel::onListProjectsByNameLoadedFromCache( const MerginProjectsList &merginProjects, QString requestId )
+{
+  if ( mLastRequestId != requestId )
+  {
+    return;
+  }
+
+  mergeProjects( merginProjects );
+}
+
 void ProjectsModel::mergeProjects( const MerginProjectsList &merginProjects, MergeStrategy mergeStrategy )
 {
-  const LocalProjectsList localProjects = mLocalProjectsManager->projects();
+  QList<Project> projects = mergedProjects( merginProjects );
 
   if ( mergeStrategy == DiscardPrevious )
   {
-    mProjects.clear();
+    applyProjects( projects );
+    return;
+  }
+
+  // next page - update projects we already have (e.g. listed from cache before) and append the new ones
+  QList<Project> newProjects;
+  for ( const Project &project : projects )
+  {
+    int ix = projectIndexFromId( project.id() );
+    if ( ix < 0 )
+    {
+      newProjects << project;
+    }
+    else
+    {
+      mProjects[ix] = project;
+      emit dataChanged( index( ix ), index( ix ) );
+    }
+  }
+
+  if ( !newProjects.isEmpty() )
+  {
+    beginInsertRows( QModelIndex(), mProjects.size(), mProjects.size() + newProjects.size() - 1 );
+    mProjects << newProjects;
+    endInsertRows();
+  }
+}
+
+void ProjectsModel::applyProjects( const QList<Project> &projects )
+{
+  QSet<QString> newIds;
+  for ( const Project &project : projects )
+  {
+    newIds.insert( project.id() );
+  }
+
+  // 1. remove rows of projects that are gone
+  for ( int row = mProjects.size() - 1; row >= 0; --row )
+  {
+    if ( !newIds.contains( mProjects.at( row ).id() ) )
+    {
+      beginRemoveRows( QModelIndex(), row, row );
+      mProjects.removeAt( row );
+      endRemoveRows();
+    }
   }
 
+  // 2. walk the new list and move or insert rows so that the order matches
+  for ( int row = 0; row < projects.size(); ++row )
+  {
+    const Project &project = projects.at( row );
+
+    if ( row < mProjects.size() && mProjects.at( row ).id() == project.id() )
+    {
+      mProjects[row] = project;
+      continue;
+    }
+
+    int currentRow = -1;
+    for ( int i = row + 1; i < mProjects.size(); ++i )
+    {
+      if ( mProjects.at( i ).id() == project.id() )
+      {
+        currentRow = i;
+        break;
+      }
+    }
+
+    if ( currentRow >= 0 )
+    {
+      beginMoveRows( QModelIndex(), currentRow, currentRow, QModelIndex(), row );
+      mProjects.move( currentRow, row );
+      endMoveRows();
+      mProjects[row] = project;
+    }
+    else
+    {
+      beginInsertRows( QModelIndex(), row, row );
+      mProjects.insert( row, project );
+      endInsertRows();
+    }
+  }
+
+  // 3. drop leftovers (only possible with duplicate ids)
+  if ( mProjects.size() > projects.size() )
+  {
+    beginRemoveRows( QModelIndex(), projects.size(), mProjects.size() - 1 );
+    mProjects.erase( mProjects.begin() + projects.size(), mProjects.end() );
+    endRemoveRows();
+  }
+
+  // data of the remaining projects (status, description, ...) might have changed
+  if ( !mProjects.isEmpty() )
+  {
+    emit dataChanged( index( 0 ), index( mProjects.size() - 1 ) );
+  }
+}
+
+QList<Project> ProjectsModel::mergedProjects( const MerginProjectsList &merginProjects ) const
+{
+  const LocalProjectsList localProjects = mLocalProjectsManager->projects();
+  QList<Project> projects;
+
   if ( mModelType == ProjectModelTypes::LocalProjectsModel )
   {
     // Keep all local projects and ignore all not downloaded remote projects
@@ -298,7 +422,7 @@ void ProjectsModel::mergeProjects( const MerginProjectsList &merginProjects, Mer
         project.mergin.status = ProjectStatus::projectStatus( project );
       }
 
-      mProjects << project;
+      projects << project;
     }
 
     // lets check also for projects that are currently being downloaded and add them to local projects list
@@ -306,12 +430,12 @@ void ProjectsModel::mergeProjects( const MerginProjectsList &merginProjects, Mer
 
     for ( const QString &pendingProjectName : pendingProjects )
     {
-      const auto &match = std::find_if( mProjects.begin(), mProjects.end(), [&pendingProjectName]( const Project & mp )
+      const auto &match = std::find_if( projects.begin(), projects.end(), [&pendingProjectName]( const Project & mp )
       {
         return ( mp.id() == pendingProjectName );
       } );
 
-      bool alreadyIncluded = match != mProjects.end();
+      bool alreadyIncluded = match != projects.end();
       if ( !alreadyIncluded )
       {
         Project project;
@@ -319,7 +443,7 @@ void ProjectsModel::mergeProjects( const MerginProjectsList &merginProjects, Mer
         MerginApi::extractProjectName( pendingProjectName, project.mergin.projectNamespace, project.mergin.projectName );
         project.mergin.status = ProjectStatus::projectStatus( project );
 
-        mProjects << project;
+        projects << project;
       }
     }
   }
@@ -342,9 +466,11 @@ void ProjectsModel::mergeProjects( const MerginProjectsList &merginProjects, Mer
       }
       project.mergin.status = ProjectStatus::projectStatus( project );
 
-      mProjects << project;
+      projects << project;
     }
   }
+
+  return projects;
 }
 
 void ProjectsModel::syncProject( const QString &projectId )
@@ -636,6 +762,7 @@ void ProjectsModel::clearProjects()
   beginResetModel();
   mProjects.clear();
   mServerProjectsCount = -1;
+  mListedSearchExpression.clear();
   endResetModel();
 
   emit hasMoreProjectsChanged();
@@ -645,9 +772,7 @@ void ProjectsModel::loadLocalProjects()
 {
   if ( mModelType == LocalProjectsModel )
   {
-    beginResetModel();
     mergeProjects( MerginProjectsList() ); // Fills model with local projects
-    endResetModel();
   }
 }
 
@@ -24,8 +24,9 @@ class LocalProjectsManager;
  * \brief The ProjectsModel class holds projects (both local and mergin). Model loads local projects from LocalProjectsManager that hold them
    during runtime. Remote (Mergin) projects are fetched from MerginAPI calling listProjects or listProjectsByName (based on the type of the model).
  *
- * The main job of the model is to merge projects coming from MerginAPI and LocalProjectsManager. By merging it means Each time new response is received from MerginAPI, model erases
- * old remembered projects and fetches new. Merge logic depends on the model type (described below).
+ * The main job of the model is to merge projects coming from MerginAPI and LocalProjectsManager. Each time new response is received from MerginAPI, model replaces
+ * old remembered projects with the new ones, only applying the difference as row inserts/moves/removals. Merge logic depends on the model type (described below).
+ * MerginAPI first emits the last cached listing of the same request (if there is any), so the model is filled immediately, and then the revalidated one.
  *
  * Model can have different types that affect handling of the projects.
  *  - LocalProjectsModel always keeps all local projects and seek their mergin part when listProjectsByNameFinished
@@ -101,7 +102,7 @@ class ProjectsModel : public QAbstractListModel
     Q_PROPERTY( bool hasMoreProjects READ hasMoreProjects NOTIFY hasMoreProjectsChanged )
 
     //! Indicates that model is currently processing projects, filling its storage.
-    //! Models loading starts when listProjectsAPI is sent and finishes after endResetModel signal is emitted when projects are merged.
+    //! Models loading starts when listProjectsAPI is sent and finishes after projects from the server response are merged.
     Q_PROPERTY( bool isLoading READ isLoading NOTIFY isLoadingChanged )
 
     //! Use to store the active project id in the model, so that Roles::ProjectIsActiveProject can be used
@@ -134,7 +135,10 @@ class ProjectsModel : public QAbstractListModel
     //! Calls listProjects with incremented page
     Q_INVOKABLE void fetchAnotherPage( const QString &searchExpression );
 
-    //! Merges local and remote projects based on the model type
+    /**
+     * Merges local and remote projects based on the model type and applies them to the model.
+     * Only the rows that changed are inserted, moved or removed, the model is not reset.
+     */
     void mergeProjects( const MerginProjectsList &merginProjects, MergeStrategy mergeStrategy = DiscardPrevious );
 
     //! Returns Project deep copy from projectId
@@ -157,6 +161,8 @@ class ProjectsModel : public QAbstractListModel
     // MerginAPI - project list signals
     void onListProjectsFinished( const MerginProjectsList &merginProjects, int projectsCount, int page, QString requestId );
     void onListProjectsByNameFinished( const MerginProjectsList &merginProjects, QString requestId );
+    void onListProjectsLoadedFromCache( const MerginProjectsList &merginProjects, int projectsCount, int page, QString requestId );
+    void onListProjectsByNameLoadedFromCache( const MerginProjectsList &merginProjects, QString requestId );
 
     // Synchonization signals
     void onProjectSyncStarted( const QString &projectFullName );
@@ -202,6 +208,14 @@ class ProjectsModel : public QAbstractListModel
 
     QString modelTypeToFlag() const;
     QStringList projectNames() const;
+
+    //! Returns local and remote projects merged based on the model type
+    QList<Project> mergedProjects( const MerginProjectsList &merginProjects ) const;
+
+    //! Replaces projects of the model with row inserts/moves/removals instead of model reset
+    void applyProjects( const QList<Project> &projects );
+
+    void applyListedPage( const MerginProjectsList &merginProjects, int projectsCount, int page );
     void clearProjects();
     void loadLocalProjects();
     void initializeProjectsModel();
@@ -217,6 +231,10 @@ class ProjectsModel : public QAbstractListModel
     //! For processing requests sent via this model
     QString mLastRequestId;
 
+    //! Search expression of the last request and of the listing currently in the model
+    QString mRequestedSearchExpression;
+    QString mListedSearchExpression;
+
     bool mModelIsLoading;
 
     MerginApi *mBackend = nullptr; // not owned
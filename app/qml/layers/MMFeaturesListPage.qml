@@ -60,6 +60,8 @@ MMComponents.MMPage {
         id: featuresModel
 
         useAttributeTableSortOrder: true
+        pagedFetching: true
+        useSearchIndex: true
         layer: root.selectedLayer
       }
 
@@ -78,6 +78,14 @@ Item {
 
     property real markerSize: highlight.markerSize === MMHighlight.MarkerSizes.Normal ? 18 * __dp : 21 * __dp
     property real lineWidth: highlight.lineWidth === MMHighlight.LineWidths.Normal ? 8 * __dp : 4 * __dp
+
+    // last path element created by appendGeometry, consecutive segments are merged into it
+    property var appendedPolyline: null
+    property var appendedPolylineOwner: null
+
+    // appended segments are merged into one path element up to this number of points, so that
+    // neither the number of path elements nor the cost of one merge grows with the whole line
+    readonly property int maxAppendedPolylinePoints: 100
   }
 
   Connections {
@@ -108,6 +116,9 @@ Item {
   {
     if ( !mapSettings ) return
 
+    internal.appendedPolyline = null
+    internal.appendedPolylineOwner = null
+
     if ( !geometry )
     {
       // trigger repaint for empty geometries
@@ -221,6 +232,70 @@ Item {
     lineBorderShapePath.pathElements = newLineElements
   }
 
+  // Adds items of appendedGeometry (in map canvas CRS) to the highlight without rebuilding the
+  // existing ones, e.g. a new segment of a streamed line. A segment continuing the previously appended
+  // one extends its path element. Appended items are dropped once geometry changes.
+  function appendGeometry( appendedGeometry )
+  {
+    if ( !mapSettings || !appendedGeometry ) return
+
+    let data = __inputUtils.extractGeometryCoordinates( appendedGeometry )
+    let geometryType = data[0] // type of geometry - 0: point, 1: linestring, 2: polygon
+
+    if ( geometryType === 0 )
+    {
+      // point or multipoint [0, x1, y1, 0, x2, y2, ..]
+      for ( let it = 1; it < data.length; it += 3 )
+      {
+        markerItems.push( componentMarker.createObject( highlight, { "posX": data[it], "posY": data[it + 1] } ) )
+      }
+      return
+    }
+
+    let objOwner = ( geometryType === 1 ? lineShapePath : polygonShapePath )
+    let borderPath = ( geometryType === 1 ? lineBorderShapePath : polygonRingBorderPath )
+
+    let i = 0
+    while ( i < data.length )
+    {
+      i++ // type of the part
+      let pointsCount = data[ i++ ]
+
+      // shapes use coordinates of the reference view, see constructHighlights
+      let newPath = []
+      for ( let k = i; k < i + pointsCount * 2; k += 2 )
+      {
+        newPath.push( Qt.point( ( data[k] + refTransformOffsetX ) * refTransformScale / displayDevicePixelRatio,
+                                -( data[k+1] + refTransformOffsetY ) * refTransformScale / displayDevicePixelRatio ) )
+      }
+      i += pointsCount * 2
+
+      if ( newPath.length === 0 )
+      {
+        continue
+      }
+
+      let lastElement = internal.appendedPolyline
+      if ( lastElement && internal.appendedPolylineOwner === objOwner && lastElement.path.length < internal.maxAppendedPolylinePoints )
+      {
+        let lastPath = lastElement.path
+        let lastPoint = lastPath[ lastPath.length - 1 ]
+        if ( lastPoint.x === newPath[0].x && lastPoint.y === newPath[0].y )
+        {
+          // continues the previous segment, e.g. the next segment of a streamed line
+          lastElement.path = lastPath.concat( newPath.slice( 1 ) )
+          continue
+        }
+      }
+
+      let element = componentPathPolyline.createObject( objOwner, { path: newPath } )
+      objOwner.pathElements.push( element )
+      borderPath.pathElements.push( element )
+      internal.appendedPolyline = element
+      internal.appendedPolylineOwner = objOwner
+    }
+  }
+
   // keeps list of currently displayed marker items (an internal property)
   property var markerItems: []
 
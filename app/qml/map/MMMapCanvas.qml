@@ -30,6 +30,7 @@ Item {
 
   property alias mapSettings: mapRenderer.mapSettings
   property alias isRendering: mapRenderer.isRendering
+  property alias renderProfiler: mapRenderer.renderProfiler
 
   // Requests map redraw
   function refresh() {
@@ -95,6 +96,12 @@ Item {
 
     freeze: false
 
+    // also renders quick previews while the map is frozen for gestures
+    incrementalRendering: true
+
+    // counting rendered features slows rendering down, only when the statistics are shown
+    renderProfiler.enabled: __appSettings.renderProfilerEnabled
+
     QtObject {
       id: rendererPrivate
 
@@ -518,6 +518,13 @@ Item {
           mapSettings: mapCanvas.mapSettings
           preferredWidth: 100 * __dp
         }
+
+        MMRenderProfileOverlay {
+          x: parent.width / 2 - width / 2
+
+          visible: __appSettings.renderProfilerEnabled
+          renderProfiler: mapCanvas.renderProfiler
+        }
       }
     }
 
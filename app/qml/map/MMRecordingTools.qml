@@ -67,6 +67,15 @@ Item {
     // Bind variables manager to know if we are centered to GPS or not when evaluating position variables
     onIsUsingPositionChanged: __variablesManager.useGpsPoint = isUsingPosition
 
+    // while streaming, only the new segment is sent to highlights instead of the whole geometry
+    onRecordedGeometryAppended: function( segment ) {
+      highlight.appendGeometry( __inputUtils.transformGeometryToMapWithLayer( segment, __activeLayer.vectorLayer, root.map.mapSettings ) )
+    }
+
+    onExistingVerticesAppended: function( vertices ) {
+      existingVerticesHighlight.appendGeometry( __inputUtils.transformGeometryToMapWithLayer( vertices, __activeLayer.vectorLayer, root.map.mapSettings ) )
+    }
+
     onActiveVertexChanged: function( activeVertex ) {
       if ( activeVertex.isValid() )
       {
@@ -110,6 +119,21 @@ Item {
     lineBorderWidth: 0
   }
 
+  // the last fix held back by the simplification of streamed points, it is not a vertex of the line yet
+  MMHighlight {
+    id: streamedTailHighlight
+
+    height: root.map.height
+    width: root.map.width
+
+    visible: mapTool.recordingType === MM.RecordingMapTool.StreamMode
+
+    mapSettings: root.map.mapSettings
+    geometry: __inputUtils.transformGeometryToMapWithLayer( mapTool.streamedTail, __activeLayer.vectorLayer, root.map.mapSettings )
+
+    lineBorderWidth: 0
+  }
+
   Loader {
     active: __inputUtils.isLineLayer( __activeLayer.vectorLayer ) ||
             __inputUtils.isPolygonLayer( __activeLayer.vectorLayer )
@@ -233,6 +257,12 @@ Item {
         iconSource: __style.doneCircleIcon
         iconColor: __style.grassColor
         onClicked: {
+          // stop streaming first, the last position may be held back by the track simplification
+          if ( mapTool.recordingType === MM.RecordingMapTool.StreamMode )
+          {
+            mapTool.recordingType = MM.RecordingMapTool.Manual
+          }
+
           if ( mapTool.hasValidGeometry() )
           {
             // If we currently grab a point
@@ -334,6 +364,14 @@ Item {
 
       markerType: MMHighlight.MarkerTypes.Circle
       markerBorderColor: __style.grapeColor
+
+      Connections {
+        target: mapTool
+
+        function onMidPointsAppended( midPoints ) {
+          midSegmentsHighlight.appendGeometry( __inputUtils.transformGeometryToMapWithLayer( midPoints, __activeLayer.vectorLayer, root.map.mapSettings ) )
+        }
+      }
     }
   }
 
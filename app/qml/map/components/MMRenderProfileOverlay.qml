@@ -0,0 +1,72 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+import QtQuick
+
+import mm 1.0 as MM
+
+//
+// Shows statistics of the last map render - for debugging of slow projects
+//
+
+Rectangle {
+  id: root
+
+  property MM.MapRenderProfiler renderProfiler
+
+  width: Math.min( 300 * __dp, parent.width )
+  height: content.height + 16 * __dp
+
+  radius: 8 * __dp
+  color: __style.polarColor
+  opacity: 0.85
+
+  Column {
+    id: content
+
+    x: 8 * __dp
+    y: 8 * __dp
+    width: parent.width - 16 * __dp
+
+    Text {
+      width: parent.width
+
+      text: {
+        if ( !root.renderProfiler || root.renderProfiler.renderTime < 0 )
+          return qsTr( "Waiting for the map to render" )
+
+        let labeling = root.renderProfiler.labelingTime < 0 ? "-" : root.renderProfiler.labelingTime + " ms"
+        return qsTr( "Render: %1 ms, labels: %2" ).arg( root.renderProfiler.renderTime ).arg( labeling )
+      }
+
+      color: __style.forestColor
+      font: __style.t3
+      elide: Text.ElideRight
+    }
+
+    Repeater {
+      model: root.renderProfiler ? root.renderProfiler.layers : []
+
+      Text {
+        width: content.width
+
+        text: {
+          let details = modelData.cached ? qsTr( "cached" ) : modelData.time + " ms"
+          if ( modelData.features >= 0 )
+            details += ", " + qsTr( "%1 features" ).arg( modelData.features )
+          return modelData.name + ": " + details
+        }
+
+        color: __style.forestColor
+        font: __style.t4
+        elide: Text.ElideMiddle
+      }
+    }
+  }
+}
@@ -253,6 +253,17 @@ MMPage {
         onClicked: root.diagnosticLogClicked()
       }
 
+      MMLine {}
+
+      MMSettingsComponents.MMSettingsSwitch {
+        width: parent.width
+        title: qsTr("Show map rendering statistics")
+        description: qsTr("Shows how long each layer takes to render on the map")
+        checked: __appSettings.renderProfilerEnabled
+
+        onClicked: __appSettings.renderProfilerEnabled = !checked
+      }
+
       MMListFooterSpacer{}
     }
   }
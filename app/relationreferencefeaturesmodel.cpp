@@ -27,8 +27,7 @@ QVariant RelationReferenceFeaturesModel::foreignKeyFromAttribute( FeaturesModel:
   {
     if ( FeaturesModel::data( index( i, 0 ), fromAttribute ) == attributeValue )
     {
-      QgsFeature feature = FeaturesModel::data( index( i, 0 ), FeaturesModel::Feature ).value<QgsFeature>();
-      return feature.attribute( mPrimaryKeyField );
+      return rowAttribute( i, mPrimaryKeyField );
     }
   }
 
@@ -42,8 +41,7 @@ QVariant RelationReferenceFeaturesModel::attributeFromForeignKey( const QVariant
 
   for ( int i = 0; i < FeaturesModel::rowCount(); ++i )
   {
-    QgsFeature feature = FeaturesModel::data( index( i, 0 ), FeaturesModel::Feature ).value<QgsFeature>();
-    if ( feature.attribute( mPrimaryKeyField ) == fkValue )
+    if ( rowAttribute( i, mPrimaryKeyField ) == fkValue )
     {
       return FeaturesModel::data( index( i, 0 ), expectedAttribute );
     }
@@ -82,9 +80,50 @@ void RelationReferenceFeaturesModel::setup()
 
   FeaturesModel::setLayer( layer );
 
+  if ( mLookupTable )
+    disconnect( mLookupTable, nullptr, this, nullptr );
+  mLookupTable = LookupTable::forLayer( layer, mPrimaryKeyField, QString() );
+  if ( mLookupTable )
+    connect( mLookupTable, &LookupTable::ready, this, &RelationReferenceFeaturesModel::onLookupTableReady );
+
   populate();
 }
 
+void RelationReferenceFeaturesModel::populate()
+{
+  mPopulatedFromLookupTable = mLookupTable && mLookupTable->isReady() && searchExpression().isEmpty();
+
+  if ( mPopulatedFromLookupTable )
+  {
+    setFeatures( mLookupTable->features( mLookupTable->rows( QString() ) ), true );
+    return;
+  }
+
+  FeaturesModel::populate();
+}
+
+QVariant RelationReferenceFeaturesModel::featureTitle( const FeatureLayerPair &featurePair ) const
+{
+  if ( mPopulatedFromLookupTable && mLookupTable )
+  {
+    // features from the lookup table carry only the key, title was evaluated when the table was built
+    const QString title = mLookupTable->value( featurePair.feature().id() ).toString();
+    if ( !title.isEmpty() )
+      return title;
+
+    return featurePair.feature().id();
+  }
+
+  return FeaturesModel::featureTitle( featurePair );
+}
+
+void RelationReferenceFeaturesModel::onLookupTableReady()
+{
+  // table got rebuilt after the parent layer changed
+  if ( mPopulatedFromLookupTable )
+    populate();
+}
+
 QVariantMap RelationReferenceFeaturesModel::config() const
 {
   return mConfig;
@@ -11,10 +11,12 @@
 #define RELATIONREFERENCEFEATURESMODEL_H
 
 #include <QObject>
+#include <QPointer>
 
 #include "inputconfig.h"
 #include "qgsproject.h"
 #include "featuresmodel.h"
+#include "lookuptable.h"
 
 /**
  * \brief The RelationReferenceFeaturesModel class serve as a helper class for relation reference widget.
@@ -53,12 +55,21 @@ class RelationReferenceFeaturesModel : public FeaturesModel
     //! Reads config and with project instance queries all features from parent layer. Emits populated signal after loading features.
     void setup() override;
 
+    //! Uses the shared lookup table of the parent layer when it is built and no search is active
+    void populate() override;
+
+    QVariant featureTitle( const FeatureLayerPair &featurePair ) const override;
+
   signals:
     void configChanged( QVariantMap config );
     void projectChanged( QgsProject *project );
     void allowNullChanged( bool allowNull );
 
   private:
+    void onLookupTableReady();
+
+    QPointer<LookupTable> mLookupTable;
+    bool mPopulatedFromLookupTable = false;
 
     QString mFeatureTitle;
     QString mPrimaryKeyField; // primary key field of referenced layer
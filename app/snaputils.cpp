@@ -61,8 +61,10 @@ void SnapUtils::setMapSettings( InputMapSettings *newMapSettings )
     connect( mMapSettings, &InputMapSettings::visibleExtentChanged, this, &SnapUtils::onMapSettingsUpdated );
     connect( mMapSettings, &InputMapSettings::outputSizeChanged, this, &SnapUtils::onMapSettingsUpdated );
     connect( mMapSettings, &InputMapSettings::outputDpiChanged, this, &SnapUtils::onMapSettingsUpdated );
+    connect( mMapSettings, &InputMapSettings::layersChanged, this, &SnapUtils::onMapSettingsUpdated );
 
     mSnappingUtils.setMapSettings( mMapSettings->mapSettings() );
+    prepareSnappingIndex();
   }
 
   emit mapSettingsChanged( mMapSettings );
@@ -95,7 +97,8 @@ void SnapUtils::getsnap()
     return;
   }
 
-  QgsPointLocator::Match snap = mSnappingUtils.snapToMap( QgsPointXY( recordpoint.x(), recordpoint.y() ) );
+  // relaxed - layers with the index still being built are skipped instead of blocking the crosshair
+  QgsPointLocator::Match snap = mSnappingUtils.snapToMap( QgsPointXY( recordpoint.x(), recordpoint.y() ), nullptr, true );
   if ( snap.isValid() )
   {
     QgsPoint layerPoint;
@@ -105,22 +108,15 @@ void SnapUtils::getsnap()
     // the QgsPointLocator
     if ( snap.layer() && ( snap.hasVertex() || snap.hasLineEndpoint() ) )
     {
-      QgsFeature f;
-      QgsFeatureRequest request;
-      request.setFilterFid( snap.featureId() );
-      const bool fetched = snap.layer()->getFeatures( request ).nextFeature( f );
-      if ( fetched )
+      const QgsGeometry geom = snappedFeatureGeometry( snap.layer(), snap.featureId() );
+      QgsVertexId vId;
+      if ( geom.isNull() || !geom.vertexIdFromVertexNr( snap.vertexIndex(), vId ) )
       {
-        QgsVertexId vId;
-        if ( !f.geometry().vertexIdFromVertexNr( snap.vertexIndex(), vId ) )
-        {
-          setRecordPoint( centerPoint );
-          setSnapped( false );
-          return;
-        }
-        const QgsGeometry geom( f.geometry() );
-        layerPoint = InputUtils::transformPoint( snap.layer()->crs(), mDestinationLayer->crs(), mQgsProject->transformContext(), geom.constGet()->vertexAt( vId ) );
+        setRecordPoint( centerPoint );
+        setSnapped( false );
+        return;
       }
+      layerPoint = InputUtils::transformPoint( snap.layer()->crs(), mDestinationLayer->crs(), mQgsProject->transformContext(), geom.constGet()->vertexAt( vId ) );
     }
     else
     {
@@ -157,6 +153,7 @@ void SnapUtils::clear()
   setQgsProject( nullptr );
   setMapSettings( nullptr );
   setDestinationLayer( nullptr );
+  clearSnappedFeature();
 
   mSnappingUtils.setConfig( QgsSnappingConfig() );
 }
@@ -165,12 +162,90 @@ void SnapUtils::onMapSettingsUpdated()
 {
   if ( mMapSettings )
   {
+    // indexes cover whole layers, they are dropped only when the destination CRS changes
     mSnappingUtils.setMapSettings( mMapSettings->mapSettings() );
+    prepareSnappingIndex();
 
     getsnap();
   }
 }
 
+void SnapUtils::onSnappingIndexReady()
+{
+  // the crosshair has not been snapped to the layer while its index was being built
+  getsnap();
+}
+
+void SnapUtils::prepareSnappingIndex()
+{
+  if ( !mMapSettings || !mSnappingUtils.config().enabled() )
+    return;
+
+  const QgsSnappingConfig config = mSnappingUtils.config();
+  if ( config.mode() == Qgis::SnappingMode::ActiveLayer )
+    return; // current layer of the snapping utils is not used
+
+  bool missingIndex = false;
+
+  const QList<QgsMapLayer *> layers = mMapSettings->mapSettings().layers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer );
+    if ( !vl || !vl->isSpatial() )
+      continue;
+
+    if ( config.mode() == Qgis::SnappingMode::AdvancedConfiguration && !config.individualLayerSettings( vl ).enabled() )
+      continue;
+
+    QgsPointLocator *locator = mSnappingUtils.locatorForLayer( vl );
+    connect( locator, &QgsPointLocator::initFinished, this, &SnapUtils::onSnappingIndexReady, Qt::UniqueConnection );
+
+    if ( !locator->hasIndex() && !locator->isIndexing() )
+      missingIndex = true;
+  }
+
+  if ( missingIndex )
+  {
+    // relaxed query starts building of the missing indexes in background and returns immediately
+    mSnappingUtils.snapToMap( mMapSettings->mapSettings().visibleExtent().center(), nullptr, true );
+  }
+}
+
+QgsGeometry SnapUtils::snappedFeatureGeometry( QgsVectorLayer *layer, QgsFeatureId fid )
+{
+  if ( mSnappedFeatureLayer == layer && mSnappedFeatureId == fid )
+    return mSnappedFeatureGeometry;
+
+  clearSnappedFeature();
+
+  QgsFeature f;
+  QgsFeatureRequest request;
+  request.setFilterFid( fid );
+  request.setNoAttributes();
+  if ( !layer->getFeatures( request ).nextFeature( f ) )
+    return QgsGeometry();
+
+  mSnappedFeatureLayer = layer;
+  mSnappedFeatureId = fid;
+  mSnappedFeatureGeometry = f.geometry();
+
+  connect( layer, &QgsVectorLayer::geometryChanged, this, &SnapUtils::clearSnappedFeature );
+  connect( layer, &QgsVectorLayer::featureDeleted, this, &SnapUtils::clearSnappedFeature );
+  connect( layer, &QgsVectorLayer::dataChanged, this, &SnapUtils::clearSnappedFeature );
+
+  return mSnappedFeatureGeometry;
+}
+
+void SnapUtils::clearSnappedFeature()
+{
+  if ( mSnappedFeatureLayer )
+    disconnect( mSnappedFeatureLayer, nullptr, this, nullptr );
+
+  mSnappedFeatureLayer = nullptr;
+  mSnappedFeatureId = FID_NULL;
+  mSnappedFeatureGeometry = QgsGeometry();
+}
+
 QPointF SnapUtils::centerPosition() const
 {
   return mCenterPosition;
@@ -278,7 +353,9 @@ void SnapUtils::setupSnapping()
       break;
     }
   }
-  mSnappingUtils.setIndexingStrategy( QgsSnappingUtils::IndexExtent );
+  // index whole layers - the index is not rebuilt after every pan and zoom
+  mSnappingUtils.setIndexingStrategy( QgsSnappingUtils::IndexAlwaysFull );
+  prepareSnappingIndex();
 }
 
 void SnapUtils::initializeRecordPosition()
@@ -11,6 +11,7 @@
 #define SNAPUTILS_H
 
 #include <QObject>
+#include <QPointer>
 #include <qglobal.h>
 
 #include "inputconfig.h"
@@ -21,6 +22,14 @@
 
 #include "qgssnappingutils.h"
 
+/**
+ * Snaps the crosshair position to the snappable layers of the project.
+ *
+ * Snapping indexes cover whole layers and they are built in background once the snapping
+ * is set up, so they survive panning and zooming of the map. The indexes follow edits of
+ * the layers on their own. Snapping never waits for an index - layers with the index not
+ * ready yet are not snapped to and the position is snapped again once the index is built.
+ */
 class SnapUtils : public QObject
 {
     Q_OBJECT
@@ -78,6 +87,10 @@ class SnapUtils : public QObject
 
     void onMapSettingsUpdated();
 
+  private slots:
+    void onSnappingIndexReady();
+    void clearSnappedFeature();
+
   signals:
 
     void qgsProjectChanged( QgsProject *qgsProject );
@@ -99,12 +112,22 @@ class SnapUtils : public QObject
     void setupSnapping();
     void initializeRecordPosition();
 
+    //! Starts building of missing snapping indexes of the snappable layers in background
+    void prepareSnappingIndex();
+
+    //! Returns geometry of the feature \a fid from \a layer, the last snapped feature is kept in memory
+    QgsGeometry snappedFeatureGeometry( QgsVectorLayer *layer, QgsFeatureId fid );
+
     QgsSnappingUtils mSnappingUtils;
 
     QgsProject *mQgsProject = nullptr; // not owned
     InputMapSettings *mMapSettings = nullptr; // not owned
     QgsVectorLayer *mDestinationLayer = nullptr; // not owned
 
+    QPointer<QgsVectorLayer> mSnappedFeatureLayer;
+    QgsFeatureId mSnappedFeatureId = FID_NULL;
+    QgsGeometry mSnappedFeatureGeometry;
+
     QPointF mCenterPosition = QPointF( -1, -1 );
     QgsPoint mRecordPoint = QgsPoint( -1, -1 );
 
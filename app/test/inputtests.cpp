@@ -31,6 +31,7 @@
 #include "test/testlayertree.h"
 #include "test/testactiveproject.h"
 #include "test/testprojectchecksumcache.h"
+#include "test/testmapcanvas.h"
 
 InputTests::InputTests() = default;
 
@@ -182,6 +183,11 @@ int InputTests::runTest() const
     TestProjectChecksumCache projectChecksumTest;
     nFailed = QTest::qExec( &projectChecksumTest, mTestArgs );
   }
+  else if ( mTestRequested == "--testMapCanvas" )
+  {
+    TestMapCanvas mapCanvasTest;
+    nFailed = QTest::qExec( &mapCanvasTest, mTestArgs );
+  }
   else if ( mTestRequested == "--testMerginApi" )
   {
     TestMerginApi merginApiTest( mApi );
@@ -12,6 +12,7 @@
 #include <QObject>
 #include <QApplication>
 #include <QScreen>
+#include <QSignalSpy>
 #include <memory>
 
 #include "testutils.h"
@@ -19,12 +20,16 @@
 #include "qgsapplication.h"
 #include "qgsvectorlayer.h"
 #include "qgsproject.h"
+#include "qgseditformconfig.h"
+#include "qgsexpressioncontextutils.h"
 
 #include "attributecontroller.h"
+#include "attributeformtemplate.h"
 #include "attributetabproxymodel.h"
 #include "attributetabmodel.h"
 #include "attributeformproxymodel.h"
 #include "attributeformmodel.h"
+#include "uniquevaluesindex.h"
 #include "inpututils.h"
 
 void TestAttributeController::init()
@@ -793,6 +798,23 @@ void TestAttributeController::testHtmlAndTextWidgets()
 
   QCOMPARE( htmlItem->rawValue(), "<span>my new text on update</span>" );
   QCOMPARE( textItem->rawValue(), "my new text on update" );
+
+  // text widgets give the same output as QgsExpression::replaceExpressionText(), also for empty and failing expressions
+  QgsExpressionContext context = surveyLayer->createExpressionContext();
+  context.setFeature( controller.featureLayerPair().feature() );
+  const QStringList texts =
+  {
+    QStringLiteral( "[% \"text\" %] and [% 1 + 1 %]" ),
+    QStringLiteral( "empty [% %] and [%%] stays" ),
+    QStringLiteral( "broken [% 1 + %] and [% \"missing\" %]" ),
+    QStringLiteral( "null [% NULL %], [% 'a' %][%'b'%]" )
+  };
+  for ( const QString &text : texts )
+  {
+    std::unique_ptr<FormItem> item( FormItem::createRichTextItem( QUuid::createUuid(), QString(), 0, QString(), false, text, false, QgsExpression() ) );
+    item->prepareExpressions( &context );
+    QCOMPARE( item->evaluateRichText( &context ), QgsExpression::replaceExpressionText( text, &context ) );
+  }
 }
 
 void TestAttributeController::testVirtualFields()
@@ -842,3 +864,306 @@ void TestAttributeController::testVirtualFields()
   controller.setFormValue( field2->id(), "my new text2" );
   QCOMPARE( controller.featureLayerPair().feature().attribute( 1 ), "my new text2" );
 }
+
+void TestAttributeController::testDependencyGraph()
+{
+  std::unique_ptr<QgsVectorLayer> layer(
+    new QgsVectorLayer( QStringLiteral( "Point?field=a:integer&field=b:integer&field=c:integer&field=d:string" ),
+                        QStringLiteral( "layer" ),
+                        QStringLiteral( "memory" )
+                      )
+  );
+  QVERIFY( layer && layer->isValid() );
+
+  // c = a * 2 and the constraint of b depends on c
+  layer->setDefaultValueDefinition( 2, QgsDefaultValue( QStringLiteral( "\"a\" * 2" ), true ) );
+  layer->setConstraintExpression( 1, QStringLiteral( "\"c\" IS NULL OR \"c\" < 10" ) );
+
+  QgsFeature feat;
+  feat.setValid( true );
+  feat.setFields( layer->fields(), true );
+
+  AttributeController controller;
+  controller.setFeatureLayerPair( FeatureLayerPair( feat, layer.get() ) );
+
+  const QVector<QUuid> items = controller.tabItem( 0 )->formItems();
+  QCOMPARE( items.size(), 4 );
+
+  QVERIFY( controller.mFieldDependencies.value( 2 ) == QSet<int>( { 0 } ) );
+  QVERIFY( !controller.mFieldDependencies.contains( 3 ) );
+  QVERIFY( controller.mFormItemDependencies.value( items.at( 1 ) ) == QSet<int>( { 1, 2 } ) );
+  QVERIFY( controller.mFormItemDependencies.value( items.at( 3 ) ) == QSet<int>( { 3 } ) );
+
+  // a change of a is propagated to c and then to the constraint of b
+  controller.setFormValue( items.at( 0 ), 1 );
+  QCOMPARE( controller.formValue( 2 ).toInt(), 2 );
+  QCOMPARE( controller.hasValidationErrors(), false );
+
+  controller.setFormValue( items.at( 0 ), 10 );
+  QCOMPARE( controller.formValue( 2 ).toInt(), 20 );
+  QVERIFY( !controller.formItem( items.at( 1 ) )->validationMessage().isEmpty() );
+  QCOMPARE( controller.hasValidationErrors(), true );
+
+  // d is independent, items which were not recalculated keep their state
+  controller.setFormValue( items.at( 3 ), QStringLiteral( "text" ) );
+  QCOMPARE( controller.formValue( 2 ).toInt(), 20 );
+  QCOMPARE( controller.hasValidationErrors(), true );
+
+  controller.setFormValue( items.at( 0 ), 2 );
+  QCOMPARE( controller.formValue( 2 ).toInt(), 4 );
+  QVERIFY( controller.formItem( items.at( 1 ) )->validationMessage().isEmpty() );
+  QCOMPARE( controller.hasValidationErrors(), false );
+}
+
+void TestAttributeController::benchmarkFormValueChange_data()
+{
+  QTest::addColumn<bool>( "incremental" );
+
+  QTest::newRow( "full" ) << false;
+  QTest::newRow( "incremental" ) << true;
+}
+
+void TestAttributeController::benchmarkFormValueChange()
+{
+  QFETCH( bool, incremental );
+
+  const int fieldCount = 150;
+  QStringList fieldDefinitions;
+  for ( int i = 0; i < fieldCount; ++i )
+  {
+    fieldDefinitions << QStringLiteral( "field=f%1:integer" ).arg( i );
+  }
+
+  std::unique_ptr<QgsVectorLayer> layer(
+    new QgsVectorLayer( QStringLiteral( "Point?%1" ).arg( fieldDefinitions.join( QLatin1Char( '&' ) ) ),
+                        QStringLiteral( "layer" ),
+                        QStringLiteral( "memory" )
+                      )
+  );
+  QVERIFY( layer && layer->isValid() );
+
+  // name and editability of each field depend on the previous field
+  QgsEditFormConfig config = layer->editFormConfig();
+  for ( int i = 1; i < fieldCount; ++i )
+  {
+    QgsPropertyCollection properties;
+    properties.setProperty( QgsEditFormConfig::DataDefinedProperty::Alias, QgsProperty::fromExpression( QStringLiteral( "'Field ' || coalesce( \"f%1\", 0 )" ).arg( i - 1 ) ) );
+    properties.setProperty( QgsEditFormConfig::DataDefinedProperty::Editable, QgsProperty::fromExpression( QStringLiteral( "\"f%1\" IS NULL OR \"f%1\" >= 0" ).arg( i - 1 ) ) );
+    config.setDataDefinedFieldProperties( QStringLiteral( "f%1" ).arg( i ), properties );
+  }
+  layer->setEditFormConfig( config );
+
+  QgsFeature feat;
+  feat.setValid( true );
+  feat.setFields( layer->fields(), true );
+
+  AttributeController controller;
+  controller.setFeatureLayerPair( FeatureLayerPair( feat, layer.get() ) );
+
+  const QVector<QUuid> items = controller.tabItem( 0 )->formItems();
+  QCOMPARE( items.size(), fieldCount );
+
+  // only the item depending on the changed field gets its expressions evaluated again
+  const QSet<int> changedFields = { 50 };
+  QSet<QUuid> reevaluatedItems;
+  for ( const QUuid &item : items )
+  {
+    if ( AttributeController::dependsOn( controller.mFormItemDependencies.value( item ), &changedFields ) )
+      reevaluatedItems.insert( item );
+  }
+  QCOMPARE( reevaluatedItems, QSet<QUuid>( { items.at( 51 ) } ) );
+
+  QSignalSpy formDataSpy( &controller, &AttributeController::formDataChanged );
+  controller.setFormValue( items.at( 50 ), 7 );
+  QSet<QUuid> changedItems;
+  for ( const QList<QVariant> &arguments : std::as_const( formDataSpy ) )
+  {
+    changedItems.insert( arguments.at( 0 ).toUuid() );
+  }
+  QCOMPARE( changedItems, QSet<QUuid>( { items.at( 50 ), items.at( 51 ) } ) );
+  QCOMPARE( controller.formItem( items.at( 51 ) )->name(), QStringLiteral( "Field 7" ) );
+
+  if ( incremental )
+  {
+    int value = 0;
+    QBENCHMARK
+    {
+      controller.setFormValue( items.at( 50 ), ++value );
+    }
+    QCOMPARE( controller.formItem( items.at( 51 ) )->name(), QStringLiteral( "Field %1" ).arg( value ) );
+  }
+  else
+  {
+    // cost of a value change before the recalculation was limited to dependent items
+    QBENCHMARK
+    {
+      controller.recalculateDerivedItems( true );
+    }
+    QCOMPARE( controller.formItem( items.at( 51 ) )->name(), QStringLiteral( "Field 7" ) );
+  }
+}
+
+void TestAttributeController::testFormTemplate()
+{
+  std::unique_ptr<QgsVectorLayer> layer(
+    new QgsVectorLayer( QStringLiteral( "Point?field=fldtxt:string&field=fldint:integer" ),
+                        QStringLiteral( "layer" ),
+                        QStringLiteral( "memory" )
+                      )
+  );
+  QVERIFY( layer && layer->isValid() );
+
+  QgsFeature f1( layer->dataProvider()->fields(), 1 );
+  f1.setAttributes( { QStringLiteral( "one" ), 1 } );
+  QgsFeature f2( layer->dataProvider()->fields(), 2 );
+  f2.setAttributes( { QStringLiteral( "two" ), 2 } );
+  layer->dataProvider()->addFeatures( QgsFeatureList() << f1 << f2 );
+
+  AttributeController controller1;
+  controller1.setFeatureLayerPair( FeatureLayerPair( f1, layer.get() ) );
+  QVERIFY( AttributeFormTemplate::forLayer( layer.get() )->hasLayout() );
+
+  // second form of the layer clones the layout of the first one
+  AttributeController controller2;
+  controller2.setFeatureLayerPair( FeatureLayerPair( f2, layer.get() ) );
+
+  const QVector<QUuid> items = controller1.tabItem( 0 )->formItems();
+  QCOMPARE( controller2.tabItem( 0 )->formItems(), items );
+  QVERIFY( controller1.formItem( items.at( 0 ) ) != controller2.formItem( items.at( 0 ) ) );
+
+  QCOMPARE( controller1.formItem( items.at( 0 ) )->rawValue(), QStringLiteral( "one" ) );
+  QCOMPARE( controller2.formItem( items.at( 0 ) )->rawValue(), QStringLiteral( "two" ) );
+
+  controller2.setFormValue( items.at( 1 ), 22 );
+  QCOMPARE( controller2.formValue( 1 ), 22 );
+  QCOMPARE( controller1.formValue( 1 ), 1 );
+  QCOMPARE( controller1.formItem( items.at( 1 ) )->rawValue(), 1 );
+
+  // the template is dropped when the form configuration changes
+  layer->setFieldAlias( 0, QStringLiteral( "Text" ) );
+  QVERIFY( !AttributeFormTemplate::forLayer( layer.get() )->hasLayout() );
+
+  AttributeController controller3;
+  controller3.setFeatureLayerPair( FeatureLayerPair( f1, layer.get() ) );
+  const QVector<QUuid> items3 = controller3.tabItem( 0 )->formItems();
+  QVERIFY( items3.at( 0 ) != items.at( 0 ) );
+  QCOMPARE( controller3.formItem( items3.at( 0 ) )->name(), QStringLiteral( "Text" ) );
+
+  // prepared expressions keep values of global and project variables, e.g. @mergin_username set after sign in
+  QVERIFY( AttributeFormTemplate::forLayer( layer.get() )->hasLayout() );
+  QgsExpressionContextUtils::setGlobalVariable( QStringLiteral( "form_template_test" ), 1 );
+  QVERIFY( !AttributeFormTemplate::forLayer( layer.get() )->hasLayout() );
+
+  AttributeController controller4;
+  controller4.setFeatureLayerPair( FeatureLayerPair( f1, layer.get() ) );
+  QVERIFY( AttributeFormTemplate::forLayer( layer.get() )->hasLayout() );
+  QgsExpressionContextUtils::setProjectVariable( QgsProject::instance(), QStringLiteral( "form_template_test" ), 1 );
+  QVERIFY( !AttributeFormTemplate::forLayer( layer.get() )->hasLayout() );
+
+  QgsExpressionContextUtils::removeGlobalVariable( QStringLiteral( "form_template_test" ) );
+  QgsExpressionContextUtils::removeProjectVariable( QgsProject::instance(), QStringLiteral( "form_template_test" ) );
+}
+
+void TestAttributeController::testUniqueValuesIndex()
+{
+  std::unique_ptr<QgsVectorLayer> layer(
+    new QgsVectorLayer( QStringLiteral( "Point?field=code:integer&field=size:double&field=name:string" ),
+                        QStringLiteral( "layer" ),
+                        QStringLiteral( "memory" )
+                      )
+  );
+  QVERIFY( layer && layer->isValid() );
+  layer->setFieldConstraint( 0, QgsFieldConstraints::ConstraintUnique, QgsFieldConstraints::ConstraintStrengthHard );
+
+  QgsFeature f1( layer->fields(), 1 );
+  f1.setAttributes( { 1, 1.0, QStringLiteral( "1" ) } );
+  QgsFeature f2( layer->fields(), 2 );
+  f2.setAttributes( { 2, 2.5, QStringLiteral( "2" ) } );
+  layer->dataProvider()->addFeatures( QgsFeatureList() << f1 << f2 );
+
+  UniqueValuesIndex *index = UniqueValuesIndex::forField( layer.get(), 0 );
+  QVERIFY( index );
+  QCOMPARE( UniqueValuesIndex::forField( layer.get(), 0 ), index );
+
+  QSignalSpy spy( index, &UniqueValuesIndex::ready );
+  QVERIFY( index->isReady() || spy.wait() );
+
+  QVERIFY( index->valueExists( 1, FID_NULL ) );
+  QVERIFY( !index->valueExists( 1, f1.id() ) ); // the feature itself does not count
+  QVERIFY( !index->valueExists( 3, FID_NULL ) );
+  QVERIFY( !index->valueExists( QVariant(), FID_NULL ) );
+
+  // values are compared in the type of the field
+  QVERIFY( index->valueExists( QStringLiteral( "1" ), FID_NULL ) );
+  UniqueValuesIndex *sizeIndex = UniqueValuesIndex::forField( layer.get(), 1 );
+  UniqueValuesIndex *nameIndex = UniqueValuesIndex::forField( layer.get(), 2 );
+  QTRY_VERIFY( sizeIndex->isReady() && nameIndex->isReady() );
+  QVERIFY( sizeIndex->valueExists( 1, FID_NULL ) );
+  QVERIFY( sizeIndex->valueExists( QStringLiteral( "1.0" ), FID_NULL ) );
+  QVERIFY( sizeIndex->valueExists( 2.5, FID_NULL ) );
+  QVERIFY( !sizeIndex->valueExists( 2, FID_NULL ) );
+  QVERIFY( nameIndex->valueExists( QStringLiteral( "1" ), FID_NULL ) );
+  QVERIFY( !nameIndex->valueExists( QStringLiteral( "1.0" ), FID_NULL ) );
+
+  // canceled build stops without reading the remaining values
+  std::shared_ptr<std::atomic_bool> canceled = std::make_shared<std::atomic_bool>( true );
+  QVERIFY( UniqueValuesIndex::readValues( layer->dataProvider()->featureSource(), 0, layer->fields().at( 0 ), canceled ).isEmpty() );
+
+  // validation of the form uses the index
+  QgsFeature feat;
+  feat.setValid( true );
+  feat.setFields( layer->fields(), true );
+
+  AttributeController controller;
+  controller.setFeatureLayerPair( FeatureLayerPair( feat, layer.get() ) );
+  const QUuid codeItem = controller.tabItem( 0 )->formItems().at( 0 );
+
+  controller.setFormValue( codeItem, 2 );
+  QCOMPARE( controller.formItem( codeItem )->validationMessage(), ValidationTexts::hardUniqueFailed );
+  controller.setFormValue( codeItem, 3 );
+  QCOMPARE( controller.formItem( codeItem )->validationMessage(), QString() );
+
+  // committed edits are added to the index
+  QVERIFY( layer->startEditing() );
+  QVERIFY( layer->changeAttributeValue( f2.id(), 0, 3 ) );
+  QgsFeature f3( layer->fields() );
+  f3.setAttribute( 0, 4 );
+  QVERIFY( layer->addFeature( f3 ) );
+  QVERIFY( layer->deleteFeature( f1.id() ) );
+  QVERIFY( layer->commitChanges() );
+
+  QVERIFY( !index->valueExists( 1, FID_NULL ) );
+  QVERIFY( !index->valueExists( 2, FID_NULL ) );
+  QVERIFY( index->valueExists( 3, FID_NULL ) );
+  QVERIFY( index->valueExists( 4, FID_NULL ) );
+
+  controller.setFormValue( codeItem, 2 );
+  QCOMPARE( controller.formItem( codeItem )->validationMessage(), QString() );
+  controller.setFormValue( codeItem, 3 );
+  QCOMPARE( controller.formItem( codeItem )->validationMessage(), ValidationTexts::hardUniqueFailed );
+
+  // uncommitted edits of the layer are merged in
+  QVERIFY( layer->startEditing() );
+  QVERIFY( layer->changeAttributeValue( f2.id(), 0, 5 ) );
+  QgsFeature f4( layer->fields() );
+  f4.setAttribute( 0, 6 );
+  QVERIFY( layer->addFeature( f4 ) );
+  QgsFeature committedF3;
+  QVERIFY( layer->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "code = 4" ) ) ).nextFeature( committedF3 ) );
+  QVERIFY( layer->deleteFeature( committedF3.id() ) );
+
+  QVERIFY( !index->valueExists( 3, FID_NULL ) );
+  QVERIFY( !index->valueExists( 4, FID_NULL ) );
+  QVERIFY( index->valueExists( 5, FID_NULL ) );
+  QVERIFY( !index->valueExists( 5, f2.id() ) );
+  QVERIFY( index->valueExists( 6, FID_NULL ) );
+
+  controller.setFormValue( codeItem, 3 );
+  QCOMPARE( controller.formItem( codeItem )->validationMessage(), QString() );
+  controller.setFormValue( codeItem, 6 );
+  QCOMPARE( controller.formItem( codeItem )->validationMessage(), ValidationTexts::hardUniqueFailed );
+
+  QVERIFY( layer->rollBack() );
+  QVERIFY( index->valueExists( 3, FID_NULL ) );
+  QVERIFY( !index->valueExists( 6, FID_NULL ) );
+}
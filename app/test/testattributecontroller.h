@@ -33,6 +33,11 @@ class TestAttributeController: public QObject
     void testPhotoRenaming();
     void testHtmlAndTextWidgets();
     void testVirtualFields();
+    void testDependencyGraph();
+    void benchmarkFormValueChange_data();
+    void benchmarkFormValueChange();
+    void testFormTemplate();
+    void testUniqueValuesIndex();
 };
 
 #endif // TESTATTRIBUTECONTROLLER_H
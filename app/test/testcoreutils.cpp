@@ -9,9 +9,11 @@
 
 #include "testcoreutils.h"
 #include "coreutils.h"
+#include "merginprojectslistcache.h"
 #include "testutils.h"
 
 #include <QtTest/QtTest>
+#include <QTemporaryDir>
 
 void TestCoreUtils::init()
 {
@@ -352,3 +354,99 @@ void TestCoreUtils::testReplaceValueInJson()
 
   QFile::remove( testFilePath );
 }
+
+void TestCoreUtils::testCompressedFileExtension()
+{
+  QVERIFY( CoreUtils::hasCompressedFileExtension( "DCIM/photo.jpg" ) );
+  QVERIFY( CoreUtils::hasCompressedFileExtension( "DCIM/photo.JPEG" ) );
+  QVERIFY( CoreUtils::hasCompressedFileExtension( "basemap.mbtiles" ) );
+  QVERIFY( CoreUtils::hasCompressedFileExtension( "project.qgz" ) );
+
+  QVERIFY( !CoreUtils::hasCompressedFileExtension( "data.gpkg" ) );
+  QVERIFY( !CoreUtils::hasCompressedFileExtension( "project.qgs" ) );
+  QVERIFY( !CoreUtils::hasCompressedFileExtension( "table.csv" ) );
+  QVERIFY( !CoreUtils::hasCompressedFileExtension( "jpg" ) );
+}
+
+void TestCoreUtils::testGzipCompress()
+{
+  QByteArray data = QByteArray( "<qgis version=\"3.40\"><layer name=\"survey\"/></qgis>\n" ).repeated( 100 );
+  QByteArray compressed = CoreUtils::gzipCompress( data );
+
+  // gzip magic bytes
+  QVERIFY( compressed.size() > 2 );
+  QCOMPARE( static_cast<unsigned char>( compressed.at( 0 ) ), 0x1f );
+  QCOMPARE( static_cast<unsigned char>( compressed.at( 1 ) ), 0x8b );
+
+  // repetitive text compresses very well
+  QVERIFY( compressed.size() < data.size() / 10 );
+
+  // gzip trailer ends with the size of the original data
+  QDataStream trailer( compressed.right( 4 ) );
+  trailer.setByteOrder( QDataStream::LittleEndian );
+  quint32 originalSize = 0;
+  trailer >> originalSize;
+  QCOMPARE( originalSize, static_cast<quint32>( data.size() ) );
+}
+
+void TestCoreUtils::testAcceptsContentCoding()
+{
+  QVERIFY( CoreUtils::acceptsContentCoding( "gzip", "gzip" ) );
+  QVERIFY( CoreUtils::acceptsContentCoding( "deflate, GZIP", "gzip" ) );
+  QVERIFY( CoreUtils::acceptsContentCoding( "br;q=1.0, gzip;q=0.5", "gzip" ) );
+
+  QVERIFY( !CoreUtils::acceptsContentCoding( "", "gzip" ) );
+  QVERIFY( !CoreUtils::acceptsContentCoding( "identity", "gzip" ) );
+  QVERIFY( !CoreUtils::acceptsContentCoding( "x-gzip", "gzip" ) );
+  QVERIFY( !CoreUtils::acceptsContentCoding( "gzip;q=0", "gzip" ) );
+}
+
+void TestCoreUtils::testProjectsListCacheEviction()
+{
+  QTemporaryDir dir;
+  MerginProjectsListCache cache( dir.path() );
+
+  MerginProjectsListCache::Entry entry;
+  entry.data = QByteArrayLiteral( "{\"projects\": []}" );
+  entry.etag = QByteArrayLiteral( "\"etag\"" );
+
+  // entries get older and older, modification time of the files is the time of their last use
+  const QDateTime now = QDateTime::currentDateTime();
+  for ( int i = 0; i < MerginProjectsListCache::MAX_ENTRIES; ++i )
+  {
+    const QString key = QStringLiteral( "page %1" ).arg( i );
+    cache.store( key, entry );
+    QVERIFY( cache.get( key ).isValid() );
+
+    QFile f( QDir( dir.path() ).filePath( QDir( dir.path() ).entryList( QDir::Files, QDir::Time ).first() ) );
+    QVERIFY( f.open( QIODevice::ReadWrite ) );
+    QVERIFY( f.setFileTime( now.addSecs( -1000 + i ), QFileDevice::FileModificationTime ) );
+  }
+  QCOMPARE( QDir( dir.path() ).entryList( QDir::Files ).count(), MerginProjectsListCache::MAX_ENTRIES );
+
+  // reading the oldest entry makes it the most recently used one
+  QVERIFY( cache.get( QStringLiteral( "page 0" ) ).isValid() );
+
+  // a new entry evicts the least recently used one
+  cache.store( QStringLiteral( "new page" ), entry );
+  QCOMPARE( QDir( dir.path() ).entryList( QDir::Files ).count(), MerginProjectsListCache::MAX_ENTRIES );
+  QVERIFY( cache.get( QStringLiteral( "new page" ) ).isValid() );
+  QVERIFY( cache.get( QStringLiteral( "page 0" ) ).isValid() );
+  QVERIFY( !cache.get( QStringLiteral( "page 1" ) ).isValid() );
+  QVERIFY( cache.get( QStringLiteral( "page 2" ) ).isValid() );
+
+  // entries over the total size are evicted too
+  MerginProjectsListCache::Entry largeEntry;
+  largeEntry.data = QByteArray( MerginProjectsListCache::MAX_SIZE * 3 / 5, 'x' );
+  cache.store( QStringLiteral( "large page 1" ), largeEntry );
+  QVERIFY( cache.get( QStringLiteral( "large page 1" ) ).isValid() );
+  cache.store( QStringLiteral( "large page 2" ), largeEntry );
+  QVERIFY( !cache.get( QStringLiteral( "large page 1" ) ).isValid() );
+  QVERIFY( cache.get( QStringLiteral( "large page 2" ) ).isValid() );
+
+  qint64 size = 0;
+  const QFileInfoList files = QDir( dir.path() ).entryInfoList( QDir::Files );
+  for ( const QFileInfo &file : files )
+    size += file.size();
+  QVERIFY( size <= MerginProjectsListCache::MAX_SIZE );
+}
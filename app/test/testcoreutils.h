@@ -28,6 +28,10 @@ class TestCoreUtils : public QObject
     void testNameValidation();
     void testNameAbbr();
     void testReplaceValueInJson();
+    void testCompressedFileExtension();
+    void testGzipCompress();
+    void testAcceptsContentCoding();
+    void testProjectsListCacheEviction();
 };
 
 #endif // TESTCOREUTILS_H
@@ -168,3 +168,66 @@ void TestIdentifyKit::identifyInRadius()
   res = kit.identify( screenPoint.toQPointF() );
   QVERIFY( res.size() == 2 );
 }
+
+void TestIdentifyKit::identifyMultipleLayers()
+{
+  QgsRectangle extent = QgsRectangle( 0, 0, 100, 50 );
+  InputMapCanvasMap canvas;
+
+  QgsVectorLayer *pointsLayer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsVectorLayer *polygonsLayer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  QgsVectorLayer *farLayer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "far" ), QStringLiteral( "memory" ) );
+  QVERIFY( pointsLayer->isValid() && polygonsLayer->isValid() && farLayer->isValid() );
+
+  QgsFeature p1( pointsLayer->fields() );
+  p1.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 50.5, 25 ) ) );
+  QgsFeature p2( pointsLayer->fields() );
+  p2.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 50.2, 25 ) ) );
+  pointsLayer->dataProvider()->addFeatures( QgsFeatureList() << p1 << p2 );
+
+  QgsFeature polygon( polygonsLayer->fields() );
+  polygon.setGeometry( QgsGeometry::fromRect( QgsRectangle( 40, 20, 60, 30 ) ) );
+  polygonsLayer->dataProvider()->addFeatures( QgsFeatureList() << polygon );
+
+  QgsFeature far( farLayer->fields() );
+  far.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 5000, 5000 ) ) );
+  farLayer->dataProvider()->addFeatures( QgsFeatureList() << far );
+
+  InputMapSettings *ms = canvas.mapSettings();
+  ms->setDestinationCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+  ms->setExtent( extent );
+  ms->setOutputSize( QSize( 1000, 500 ) );
+  ms->setLayers( QList<QgsMapLayer *>() << farLayer << pointsLayer << polygonsLayer );
+
+  IdentifyKit kit;
+  kit.setMapSettings( ms );
+
+  // center of the map
+  const QPointF screenPoint( 500, 250 );
+
+  FeatureLayerPairs res = kit.identify( screenPoint );
+  QCOMPARE( res.size(), 3 );
+  // results keep the order of layers
+  QCOMPARE( res.at( 0 ).layer(), pointsLayer );
+  QCOMPARE( res.at( 1 ).layer(), pointsLayer );
+  QCOMPARE( res.at( 2 ).layer(), polygonsLayer );
+
+  // the closest point wins over the polygon containing the click
+  FeatureLayerPair closest = kit.identifyOne( screenPoint );
+  QVERIFY( closest.isValid() );
+  QCOMPARE( closest.layer(), pointsLayer );
+  QCOMPARE( closest.feature().geometry().asPoint(), QgsPointXY( 50.2, 25 ) );
+
+  kit.setProperty( "identifyMode", IdentifyKit::TopDownStopAtFirst );
+  res = kit.identify( screenPoint );
+  QCOMPARE( res.size(), 2 );
+  QCOMPARE( res.at( 0 ).layer(), pointsLayer );
+
+  // nothing around the point
+  res = kit.identify( QPointF( 0, 0 ) );
+  QVERIFY( res.isEmpty() );
+
+  delete pointsLayer;
+  delete polygonsLayer;
+  delete farLayer;
+}
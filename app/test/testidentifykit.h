@@ -24,6 +24,7 @@ class TestIdentifyKit: public QObject
     void identifyOne(); // tests identifyOne function without given layer
     void identifyOneDefinedVector(); // tests identifyOne function with given layer
     void identifyInRadius();
+    void identifyMultipleLayers(); // tests parallel identify of several layers
 };
 
 #endif // TESTIDENTIFYKIT_H
@@ -0,0 +1,439 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "testmapcanvas.h"
+#include "testutils.h"
+#include "inputmapcanvasmap.h"
+#include "maptilecache.h"
+#include "maprenderprofiler.h"
+
+#include "qgsvectorlayer.h"
+#include "qgsrasterlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsmaprenderercache.h"
+
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+TestMapCanvas::TestMapCanvas() = default;
+
+TestMapCanvas::~TestMapCanvas() = default;
+
+void TestMapCanvas::init()
+{
+}
+
+void TestMapCanvas::cleanup()
+{
+}
+
+static QgsMapSettings tileTestSettings( QgsMapLayer *layer )
+{
+  QgsMapSettings settings;
+  settings.setDestinationCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+  settings.setOutputSize( QSize( 512, 512 ) );
+  settings.setExtent( QgsRectangle( 0, 0, 512, 512 ) ); // 1 map unit per pixel, zoom level 0
+  settings.setLayers( QList<QgsMapLayer *>() << layer );
+  return settings;
+}
+
+void TestMapCanvas::testTileGrid()
+{
+  QCOMPARE( MapTileCache::zoomLevel( 1 ), 0 );
+  QCOMPARE( MapTileCache::zoomLevel( 4 ), 2 );
+  QCOMPARE( MapTileCache::zoomLevel( 0.25 ), -2 );
+  QCOMPARE( MapTileCache::zoomLevel( 1.3 ), 0 ); // closest level wins
+
+  QCOMPARE( MapTileCache::tileMapSize( 0 ), 256.0 );
+  QCOMPARE( MapTileCache::tileMapSize( 1 ), 512.0 );
+  QCOMPARE( MapTileCache::tileMapSize( -1 ), 128.0 );
+
+  QCOMPARE( MapTileCache::tileExtent( { 0, -1, 2 } ), QgsRectangle( -256, 512, 0, 768 ) );
+
+  // extent aligned with tile borders does not include the neighbours
+  QList<MapTileCache::TileKey> keys = MapTileCache::tilesInExtent( QgsRectangle( 0, 0, 512, 256 ), 0 );
+  QCOMPARE( keys.count(), 2 );
+  QVERIFY( keys.contains( MapTileCache::TileKey{ 0, 0, 0 } ) );
+  QVERIFY( keys.contains( MapTileCache::TileKey{ 0, 1, 0 } ) );
+
+  keys = MapTileCache::tilesInExtent( QgsRectangle( -10, -10, 10, 10 ), 0 );
+  QCOMPARE( keys.count(), 4 );
+
+  QVERIFY( MapTileCache::tilesInExtent( QgsRectangle(), 0 ).isEmpty() );
+
+  // degenerate requests are refused
+  QVERIFY( MapTileCache::tilesInExtent( QgsRectangle( 0, 0, 1e6, 1e6 ), 0 ).isEmpty() );
+}
+
+void TestMapCanvas::testTilePrefetch()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  MapTileCache cache;
+  QSignalSpy spy( &cache, &MapTileCache::tileRendered );
+
+  const QgsMapSettings settings = tileTestSettings( &layer );
+  cache.prefetch( settings );
+
+  // visible tiles come first
+  const QList<MapTileCache::TileKey> visible = MapTileCache::tilesInExtent( settings.visibleExtent(), 0 );
+  QCOMPARE( visible.count(), 4 );
+
+  while ( spy.count() < visible.count() )
+    QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+
+  for ( const MapTileCache::TileKey &key : visible )
+  {
+    QVERIFY( cache.contains( key ) );
+    const MapTileCache::Tile *tile = cache.tile( key );
+    QVERIFY( tile );
+    QCOMPARE( tile->revision, cache.revision() );
+    QCOMPARE( tile->image.size(), QSize( MapTileCache::TILE_SIZE, MapTileCache::TILE_SIZE ) );
+  }
+
+  // the ring around the extent is rendered next
+  while ( !cache.contains( MapTileCache::TileKey{ 0, -1, -1 } ) )
+    QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+
+  // stale tiles are kept until they are rendered again
+  const int revision = cache.revision();
+  cache.setStale();
+  QCOMPARE( cache.revision(), revision + 1 );
+  QVERIFY( !cache.contains( visible.first() ) );
+  QVERIFY( cache.tile( visible.first() ) );
+  QCOMPARE( cache.tile( visible.first() )->revision, revision );
+
+  cache.prefetch( settings );
+  while ( !cache.contains( visible.first() ) )
+    QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+  QCOMPARE( cache.tile( visible.first() )->revision, revision + 1 );
+
+  // invalidation drops all tiles
+  cache.invalidate();
+  QCOMPARE( cache.revision(), revision + 2 );
+  QCOMPARE( cache.count(), 0 );
+  QVERIFY( !cache.tile( visible.first() ) );
+
+  // canvas invalidates tiles when a layer asks for a repaint
+  InputMapCanvasMap canvas;
+  InputMapSettings *ms = canvas.mapSettings();
+  ms->setDestinationCrs( settings.destinationCrs() );
+  ms->setExtent( settings.extent() );
+  ms->setOutputSize( settings.outputSize() );
+  ms->setLayers( QList<QgsMapLayer *>() << &layer );
+
+  const int canvasRevision = canvas.mTileCache->revision();
+  layer.triggerRepaint();
+  QVERIFY( canvas.mTileCache->revision() > canvasRevision );
+}
+
+void TestMapCanvas::testTileEviction()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  MapTileCache cache;
+  QSignalSpy spy( &cache, &MapTileCache::tileRendered );
+
+  // room for just two tiles
+  const QgsMapSettings settings = tileTestSettings( &layer );
+  const int tileSize = MapTileCache::TILE_SIZE * MapTileCache::TILE_SIZE * 4 * settings.devicePixelRatio() * settings.devicePixelRatio() / 1024;
+  cache.setMaxSize( 2 * tileSize );
+  QCOMPARE( cache.maxSize(), 2 * tileSize );
+
+  cache.prefetch( settings );
+
+  // only tiles which fit in the cache are rendered, visible ones first
+  while ( spy.count() < 2 )
+    QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+  QVERIFY( !spy.wait( 500 ) );
+  QCOMPARE( cache.count(), 2 );
+
+  const QList<MapTileCache::TileKey> visible = MapTileCache::tilesInExtent( settings.visibleExtent(), 0 );
+  QVERIFY( cache.contains( visible.at( 0 ) ) );
+  QVERIFY( cache.contains( visible.at( 1 ) ) );
+
+  // the least recently used tiles are gone once another extent is prefetched
+  QgsMapSettings movedSettings = settings;
+  movedSettings.setExtent( QgsRectangle( 2048, 2048, 2560, 2560 ) );
+  cache.prefetch( movedSettings );
+
+  while ( spy.count() < 4 )
+    QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+  QCOMPARE( cache.count(), 2 );
+  QVERIFY( !cache.tile( visible.at( 0 ) ) );
+  QVERIFY( !cache.tile( visible.at( 1 ) ) );
+}
+
+void TestMapCanvas::testTilePrefetchBudget()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  MapTileCache cache;
+  QSignalSpy spy( &cache, &MapTileCache::tileRendered );
+
+  // room for the visible tiles, their ring and the coarser level, but not for the finer level
+  const QgsMapSettings settings = tileTestSettings( &layer );
+  const int tileSize = MapTileCache::TILE_SIZE * MapTileCache::TILE_SIZE * 4 * settings.devicePixelRatio() * settings.devicePixelRatio() / 1024;
+  QgsRectangle ring = settings.visibleExtent();
+  ring.grow( MapTileCache::tileMapSize( 0 ) );
+  const int ringCount = MapTileCache::tilesInExtent( ring, 0 ).count();
+  const int coarserCount = MapTileCache::tilesInExtent( ring, 1 ).count();
+  cache.setMaxSize( ( ringCount + coarserCount ) * tileSize );
+
+  cache.prefetch( settings );
+
+  while ( spy.count() < ringCount + coarserCount )
+    QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+  QVERIFY( !spy.wait( 500 ) );
+  QCOMPARE( cache.count(), ringCount + coarserCount );
+
+  const QList<MapTileCache::TileKey> ringTiles = MapTileCache::tilesInExtent( ring, 0 );
+  for ( const MapTileCache::TileKey &key : ringTiles )
+    QVERIFY( cache.contains( key ) );
+  const QList<MapTileCache::TileKey> finerTiles = MapTileCache::tilesInExtent( settings.visibleExtent(), -1 );
+  for ( const MapTileCache::TileKey &key : finerTiles )
+    QVERIFY( !cache.tile( key ) );
+
+  // the finer level is prefetched when it fits
+  cache.setMaxSize( MapTileCache::DEFAULT_MAX_SIZE );
+  cache.prefetch( settings );
+  while ( !cache.contains( finerTiles.first() ) )
+    QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+}
+
+void TestMapCanvas::benchmarkLayerRepaint()
+{
+  // large raster basemap with a small vector layer above it
+  QTemporaryDir dir;
+  const QString rasterPath = dir.filePath( QStringLiteral( "basemap.png" ) );
+  QImage basemap( 4096, 4096, QImage::Format_RGB32 );
+  for ( int y = 0; y < basemap.height(); ++y )
+  {
+    QRgb *line = reinterpret_cast<QRgb *>( basemap.scanLine( y ) );
+    for ( int x = 0; x < basemap.width(); ++x )
+      line[x] = qRgb( x % 256, y % 256, ( x * y ) % 256 );
+  }
+  QVERIFY( basemap.save( rasterPath ) );
+
+  QFile worldFile( dir.filePath( QStringLiteral( "basemap.pgw" ) ) );
+  QVERIFY( worldFile.open( QIODevice::WriteOnly | QIODevice::Text ) );
+  worldFile.write( "1\n0\n0\n-1\n0.5\n4095.5\n" );
+  worldFile.close();
+
+  QgsRasterLayer raster( rasterPath, QStringLiteral( "basemap" ), QStringLiteral( "gdal" ) );
+  QVERIFY( raster.isValid() );
+  raster.setCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+
+  QgsVectorLayer points( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( points.isValid() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature f( points.fields() );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i * 40, i * 40 ) ) );
+    features << f;
+  }
+  QVERIFY( points.dataProvider()->addFeatures( features ) );
+
+  InputMapCanvasMap canvas;
+  QSignalSpy spy( &canvas, &InputMapCanvasMap::mapCanvasRefreshed );
+
+  InputMapSettings *ms = canvas.mapSettings();
+  ms->setDestinationCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+  ms->setExtent( QgsRectangle( 0, 0, 4096, 4096 ) );
+  ms->setOutputSize( QSize( 1024, 1024 ) );
+  ms->setLayers( QList<QgsMapLayer *>() << &points << &raster );
+
+  QVERIFY( spy.wait( TestUtils::LONG_REPLY ) );
+
+  // the canvas cache keeps images of both layers
+  QVERIFY( canvas.mCache->hasCacheImage( raster.id() ) );
+  QVERIFY( canvas.mCache->hasCacheImage( points.id() ) );
+
+  // edit of the vector layer - only its image is dropped, the basemap image is reused
+  points.triggerRepaint();
+  QVERIFY( !canvas.mCache->hasCacheImage( points.id() ) );
+  QVERIFY( canvas.mCache->hasCacheImage( raster.id() ) );
+  QVERIFY( spy.wait( TestUtils::LONG_REPLY ) );
+  QVERIFY( canvas.mCache->hasCacheImage( points.id() ) );
+
+  // tiles are stale after the repaint, the old ones are shown until they are rendered again
+  const int zoom = MapTileCache::zoomLevel( canvas.mImageMapSettings.mapUnitsPerPixel() );
+  const MapTileCache::TileKey key = MapTileCache::tilesInExtent( canvas.mImageMapSettings.visibleExtent(), zoom ).first();
+  QTRY_VERIFY( canvas.mTileCache->contains( key ) );
+
+  points.triggerRepaint();
+  QVERIFY( !canvas.mTileCache->contains( key ) );
+  QVERIFY( canvas.mTileCache->tile( key ) );
+  QTRY_VERIFY( canvas.mTileCache->contains( key ) );
+
+  // frame after an edit of the vector layer
+  QBENCHMARK
+  {
+    points.triggerRepaint();
+    QVERIFY( spy.wait( TestUtils::LONG_REPLY ) );
+  }
+}
+
+void TestMapCanvas::testPreviewRendering()
+{
+  QgsVectorLayer points( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( points.isValid() );
+
+  InputMapCanvasMap canvas;
+  QSignalSpy refreshedSpy( &canvas, &InputMapCanvasMap::mapCanvasRefreshed );
+  QSignalSpy previewSpy( &canvas, &InputMapCanvasMap::mapPreviewRendered );
+
+  InputMapSettings *ms = canvas.mapSettings();
+  ms->setDestinationCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+  ms->setDevicePixelRatio( 2 );
+  ms->setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+  ms->setOutputSize( QSize( 500, 500 ) );
+  ms->setLayers( QList<QgsMapLayer *>() << &points );
+
+  QVERIFY( refreshedSpy.wait( TestUtils::SHORT_REPLY ) );
+  canvas.mTileCache->invalidate();
+  QCOMPARE( canvas.mImage.size(), QSize( 1000, 1000 ) );
+
+  // no previews without incremental rendering
+  canvas.setFreeze( true );
+  canvas.pan( QPointF( 100, 100 ), QPointF( 150, 150 ) );
+  QVERIFY( !previewSpy.wait( 500 ) );
+  canvas.setFreeze( false );
+  QVERIFY( refreshedSpy.wait( TestUtils::SHORT_REPLY ) );
+
+  canvas.setIncrementalRendering( true );
+  canvas.setMapUpdateInterval( 10 );
+
+  // gesture renders a preview with half the pixel ratio and no labels
+  canvas.setFreeze( true );
+  canvas.pan( QPointF( 100, 100 ), QPointF( 150, 150 ) );
+  QVERIFY( previewSpy.wait( TestUtils::SHORT_REPLY ) );
+
+  QCOMPARE( canvas.mImage.size(), QSize( 500, 500 ) );
+  QCOMPARE( canvas.mImageMapSettings.devicePixelRatio(), 1.0 );
+  QVERIFY( !canvas.mImageMapSettings.testFlag( Qgis::MapSettingsFlag::DrawLabeling ) );
+  QVERIFY( !canvas.isRendering() );
+
+  // full quality render once the gesture is over
+  canvas.setFreeze( false );
+  QVERIFY( refreshedSpy.wait( TestUtils::SHORT_REPLY ) );
+
+  QCOMPARE( canvas.mImage.size(), QSize( 1000, 1000 ) );
+  QCOMPARE( canvas.mImageMapSettings.devicePixelRatio(), 2.0 );
+  QVERIFY( canvas.mImageMapSettings.testFlag( Qgis::MapSettingsFlag::DrawLabeling ) );
+}
+
+void TestMapCanvas::testRenderedLayersRect()
+{
+  QgsVectorLayer points( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( points.isValid() );
+
+  QgsFeature f1( points.fields() );
+  f1.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 100, 100 ) ) );
+  QgsFeature f2( points.fields() );
+  f2.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 200, 200 ) ) );
+  QVERIFY( points.dataProvider()->addFeatures( QgsFeatureList() << f1 << f2 ) );
+  points.updateExtents();
+
+  InputMapCanvasMap canvas;
+  InputMapSettings *ms = canvas.mapSettings();
+  ms->setDestinationCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+  ms->setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+  ms->setOutputSize( QSize( 500, 500 ) );
+  ms->setLayers( QList<QgsMapLayer *>() << &points );
+  canvas.stopRendering();
+
+  canvas.mImageMapSettings = ms->mapSettings();
+  canvas.mImage = QImage( canvas.mImageMapSettings.deviceOutputSize(), QImage::Format_ARGB32_Premultiplied );
+
+  // nothing rendered, nothing to upload
+  QVERIFY( canvas.renderedLayersRect().isEmpty() );
+
+  // features are at [50, 400] - [100, 450] px, the margin is clipped by the image
+  const int margin = InputMapCanvasMap::DIRTY_RECT_MARGIN;
+  canvas.mRenderedLayers << points.id();
+  QCOMPARE( canvas.renderedLayersRect(), QRect( QPoint( 0, 400 - margin ), QPoint( 99 + margin, 499 ) ) );
+
+  // unknown extent means the whole image
+  canvas.mRenderingLayers << QStringLiteral( "unknown layer" );
+  QCOMPARE( canvas.renderedLayersRect(), canvas.mImage.rect() );
+}
+
+void TestMapCanvas::testRenderProfiler()
+{
+  QgsVectorLayer points( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( points.isValid() );
+
+  QgsFeature f1;
+  f1.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 100, 100 ) ) );
+  QgsFeature f2;
+  f2.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 900, 900 ) ) );
+  QgsFeatureList features = QgsFeatureList() << f1 << f2;
+  QVERIFY( points.dataProvider()->addFeatures( features ) );
+
+  InputMapCanvasMap canvas;
+  MapRenderProfiler *profiler = canvas.renderProfiler();
+  QVERIFY( profiler );
+  profiler->setEnabled( true );
+
+  QSignalSpy refreshedSpy( &canvas, &InputMapCanvasMap::mapCanvasRefreshed );
+  QSignalSpy profileSpy( profiler, &MapRenderProfiler::profileChanged );
+
+  InputMapSettings *ms = canvas.mapSettings();
+  ms->setDestinationCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+  ms->setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+  ms->setOutputSize( QSize( 500, 500 ) );
+  ms->setLayers( QList<QgsMapLayer *>() << &points );
+
+  QVERIFY( refreshedSpy.wait( TestUtils::SHORT_REPLY ) );
+  QVERIFY( profileSpy.count() >= 1 );
+
+  QList<MapRenderProfiler::LayerProfile> profiles = profiler->layerProfiles();
+  QCOMPARE( profiles.count(), 1 );
+  QCOMPARE( profiles.at( 0 ).name, QStringLiteral( "points" ) );
+  QCOMPARE( profiles.at( 0 ).featureCount, 2 );
+  QVERIFY( !profiles.at( 0 ).cached );
+  QVERIFY( profiles.at( 0 ).renderingTime >= 0 );
+  QVERIFY( profiler->renderTime() >= profiles.at( 0 ).renderingTime );
+
+  // only the canvas render counts features, tiles and previews are rendered without the counter
+  QVERIFY( canvas.mImageMapSettings.renderedFeatureHandlers().isEmpty() );
+  QVERIFY( canvas.preparePreviewMapSettings().renderedFeatureHandlers().isEmpty() );
+  QTRY_VERIFY( canvas.mTileCache->count() > 0 );
+
+  // same extent again - the layer comes from the render cache
+  canvas.refresh();
+  QVERIFY( refreshedSpy.wait( TestUtils::SHORT_REPLY ) );
+
+  profiles = profiler->layerProfiles();
+  QCOMPARE( profiles.count(), 1 );
+  QVERIFY( profiles.at( 0 ).cached );
+  QCOMPARE( profiles.at( 0 ).renderingTime, 0 );
+  QCOMPARE( profiles.at( 0 ).featureCount, 0 );
+
+  const QVariantList layers = profiler->layers();
+  QCOMPARE( layers.count(), 1 );
+  QCOMPARE( layers.at( 0 ).toMap().value( QStringLiteral( "cached" ) ).toBool(), true );
+
+  QVERIFY( profiler->summary().contains( QStringLiteral( "points" ) ) );
+  QVERIFY( profiler->summary().contains( QStringLiteral( "cached 1/2" ) ) );
+
+  // features are not counted when the profiler is disabled
+  profiler->setEnabled( false );
+  canvas.clearCache();
+  canvas.refresh();
+  QVERIFY( refreshedSpy.wait( TestUtils::SHORT_REPLY ) );
+  QCOMPARE( profiler->layerProfiles().at( 0 ).featureCount, -1 );
+}
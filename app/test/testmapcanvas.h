@@ -0,0 +1,36 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TESTMAPCANVAS_H
+#define TESTMAPCANVAS_H
+
+#include <QObject>
+
+class TestMapCanvas : public QObject
+{
+    Q_OBJECT
+  public:
+    explicit TestMapCanvas( );
+    ~TestMapCanvas();
+
+  private slots:
+    void init();
+    void cleanup();
+
+    void testTileGrid();
+    void testTilePrefetch();
+    void testTileEviction();
+    void testTilePrefetchBudget();
+    void benchmarkLayerRepaint();
+    void testPreviewRendering();
+    void testRenderedLayersRect();
+    void testRenderProfiler();
+};
+
+#endif // TESTMAPCANVAS_H
@@ -19,6 +19,7 @@
 #include "qgsmultipolygon.h"
 #include "qgslinestring.h"
 #include "qgsgeometry.h"
+#include "qgsvectorlayereditbuffer.h"
 
 #include "inputmapcanvasmap.h"
 #include "inputmapsettings.h"
@@ -109,6 +110,16 @@ void TestMapTools::testSnapping()
 
   su.getsnap();
 
+  // snapping index is built in background, the position is snapped once it is ready
+  QTRY_VERIFY( su.snapped() );
+
+  // index covers the whole layer, it is still there after the map is panned
+  extent.setXMinimum( extent.xMinimum() + 1 );
+  extent.setXMaximum( extent.xMaximum() + 1 );
+  ms->setExtent( extent );
+  su.setCenterPosition( ms->coordinateToScreen( center ) );
+  su.getsnap();
+
   QVERIFY( su.snapped() );
 
   su.setUseSnapping( false );
@@ -2583,3 +2594,237 @@ void TestMapTools::testSmallTracking()
   QVERIFY( mapTool.recordedGeometry().constGet()->nCoordinates() == 1 );
   QCOMPARE( mapTool.recordedGeometry().vertexAt( 0 ), mPositionKit->positionCoordinate() );
 }
+
+void TestMapTools::testLargeGeometryVertices()
+{
+  QgsProject *project = TestUtils::loadPlanesTestProject();
+  QVERIFY( project && !project->homePath().isEmpty() );
+
+  InputMapCanvasMap canvas;
+  InputMapSettings *ms = canvas.mapSettings();
+  setupMapSettings( ms, project, QgsRectangle( -107.54331499504026226, 21.62302175066136556, -72.73224633912816728, 51.49933451998575151 ), QSize( 600, 1096 ) );
+
+  // vertices collected from scratch for the geometry must match the ones updated in place
+  auto compareWithCollected = [ms]( QgsVectorLayer * layer, const RecordingMapTool & mapTool )
+  {
+    RecordingMapTool freshTool;
+    freshTool.setMapSettings( ms );
+    freshTool.setActiveLayer( layer );
+
+    QgsFeature feature;
+    feature.setGeometry( mapTool.recordedGeometry() );
+    freshTool.setActiveFeature( feature );
+
+    const QVector<Vertex> expected = freshTool.collectedVertices();
+    const QVector<Vertex> actual = mapTool.collectedVertices();
+    if ( expected.count() != actual.count() )
+      return false;
+
+    for ( int i = 0; i < expected.count(); ++i )
+    {
+      if ( expected.at( i ) != actual.at( i ) )
+        return false;
+    }
+    return true;
+  };
+
+  // polygon with 5000 vertices
+  QgsVectorLayer *polygonLayer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:4326" ), QStringLiteral( "polygons" ), QStringLiteral( "memory" ) );
+  QVERIFY( polygonLayer->isValid() );
+
+  const int vertexCount = 5000;
+  QgsPointSequence points;
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    const double angle = 2 * M_PI * i / vertexCount;
+    points << QgsPoint( -90 + 10 * std::cos( angle ), 36 + 10 * std::sin( angle ) );
+  }
+  QgsLineString *ring = new QgsLineString( points );
+  ring->close();
+
+  QgsFeature polygonFeature;
+  polygonFeature.setGeometry( QgsGeometry( new QgsPolygon( ring ) ) );
+  polygonLayer->dataProvider()->addFeatures( QgsFeatureList() << polygonFeature );
+
+  RecordingMapTool mapTool;
+  mapTool.setMapSettings( ms );
+  mapTool.setActiveLayer( polygonLayer );
+  mapTool.setActiveFeature( polygonFeature );
+
+  QCOMPARE( mapTool.collectedVertices().count(), 2 * vertexCount );
+
+  // grab a vertex
+  mapTool.lookForVertex( ms->coordinateToScreen( points.at( 1250 ) ) );
+
+  QVERIFY( mapTool.activeVertex().isValid() );
+  QCOMPARE( mapTool.activeVertex().type(), Vertex::Existing );
+  QCOMPARE( mapTool.activeVertex().vertexId().vertex, 1250 );
+  QCOMPARE( mapTool.state(), RecordingMapTool::MapToolState::Grab );
+
+  // move it and its neighbouring midpoints
+  mapTool.updateVertex( mapTool.activeVertex(), QgsPoint( -90, 40 ) );
+  QCOMPARE( mapTool.recordedGeometry().vertexAt( 1250 ), QgsPoint( -90, 40 ) );
+  QVERIFY( compareWithCollected( polygonLayer, mapTool ) );
+
+  // the moved vertex is found at the new position
+  mapTool.setState( RecordingMapTool::MapToolState::View );
+  mapTool.lookForVertex( ms->coordinateToScreen( QgsPoint( -90, 40 ) ) );
+  QCOMPARE( mapTool.activeVertex().vertexId().vertex, 1250 );
+
+  // the first vertex moves also the closing one
+  mapTool.updateVertex( Vertex( QgsVertexId( 0, 0, 0 ), points.at( 0 ), Vertex::Existing ), QgsPoint( -81, 36 ) );
+  QCOMPARE( mapTool.recordedGeometry().vertexAt( vertexCount ), QgsPoint( -81, 36 ) );
+  QVERIFY( compareWithCollected( polygonLayer, mapTool ) );
+
+  // line - moving the first vertex moves the start handle too
+  QgsVectorLayer *lineLayer = new QgsVectorLayer( QStringLiteral( "LineString?crs=epsg:4326" ), QStringLiteral( "lines" ), QStringLiteral( "memory" ) );
+  QVERIFY( lineLayer->isValid() );
+
+  QgsFeature lineFeature;
+  lineFeature.setGeometry( QgsGeometry::fromPolyline( { QgsPoint( -100, 30 ), QgsPoint( -95, 35 ), QgsPoint( -90, 30 ) } ) );
+  lineLayer->dataProvider()->addFeatures( QgsFeatureList() << lineFeature );
+
+  RecordingMapTool lineTool;
+  lineTool.setMapSettings( ms );
+  lineTool.setActiveLayer( lineLayer );
+  lineTool.setActiveFeature( lineFeature );
+
+  lineTool.updateVertex( Vertex( QgsVertexId( 0, 0, 0 ), QgsPoint( -100, 30 ), Vertex::Existing ), QgsPoint( -101, 28 ) );
+  QVERIFY( compareWithCollected( lineLayer, lineTool ) );
+
+  lineTool.updateVertex( Vertex( QgsVertexId( 0, 0, 2 ), QgsPoint( -90, 30 ), Vertex::Existing ), QgsPoint( -89, 31 ) );
+  QVERIFY( compareWithCollected( lineLayer, lineTool ) );
+
+  // adding a vertex changes structure of the vertices
+  lineTool.addPointAtPosition( Vertex( QgsVertexId( 0, 0, 1 ), QgsPoint( -98, 32 ), Vertex::MidPoint ), QgsPoint( -98, 32 ) );
+  QCOMPARE( lineTool.collectedVertices().count(), 2 * 4 + 1 );
+  QVERIFY( compareWithCollected( lineLayer, lineTool ) );
+
+  delete project;
+  delete polygonLayer;
+  delete lineLayer;
+}
+
+void TestMapTools::testStreamedPointsAppend()
+{
+  QgsProject *project = TestUtils::loadPlanesTestProject();
+  QVERIFY( project && !project->homePath().isEmpty() );
+
+  InputMapCanvasMap canvas;
+  InputMapSettings *ms = canvas.mapSettings();
+  setupMapSettings( ms, project, QgsRectangle( -107.54331499504026226, 21.62302175066136556, -72.73224633912816728, 51.49933451998575151 ), QSize( 600, 1096 ) );
+
+  QgsVectorLayer *streamLayer = new QgsVectorLayer( QStringLiteral( "LineString?crs=epsg:4326" ), QStringLiteral( "stream" ), QStringLiteral( "memory" ) );
+  QVERIFY( streamLayer->isValid() );
+
+  RecordingMapTool streamTool;
+  streamTool.setMapSettings( ms );
+  streamTool.setActiveLayer( streamLayer );
+  streamTool.setRecordingType( RecordingMapTool::StreamMode );
+
+  QSignalSpy geometryChangedSpy( &streamTool, &RecordingMapTool::recordedGeometryChanged );
+  QSignalSpy geometryAppendedSpy( &streamTool, &RecordingMapTool::recordedGeometryAppended );
+  QSignalSpy verticesAppendedSpy( &streamTool, &RecordingMapTool::existingVerticesAppended );
+  QSignalSpy midPointsAppendedSpy( &streamTool, &RecordingMapTool::midPointsAppended );
+
+  const int streamedCount = 2000;
+  for ( int i = 0; i < streamedCount; ++i )
+  {
+    streamTool.addPoint( QgsPoint( -100 + 0.01 * i, 30 + std::sin( i / 100.0 ) ) );
+  }
+
+  // the first two points create the line and its handles, the rest is appended without emitting the whole geometry
+  QCOMPARE( geometryChangedSpy.count(), 2 );
+  QCOMPARE( geometryAppendedSpy.count(), streamedCount - 2 );
+  QCOMPARE( verticesAppendedSpy.count(), streamedCount - 2 );
+  QCOMPARE( midPointsAppendedSpy.count(), streamedCount - 2 );
+
+  const QgsGeometry segment = geometryAppendedSpy.last().at( 0 ).value<QgsGeometry>();
+  QCOMPARE( segment.constGet()->nCoordinates(), 2 );
+  QCOMPARE( segment.vertexAt( 1 ), streamTool.recordedGeometry().vertexAt( streamedCount - 1 ) );
+
+  QCOMPARE( streamTool.recordedGeometry().constGet()->nCoordinates(), streamedCount );
+  QCOMPARE( streamTool.collectedVertices().count(), 2 * streamedCount + 1 );
+  QVERIFY( streamTool.hasValidGeometry() );
+  QVERIFY( streamTool.hasChanges() );
+
+  // points are written to the layer in small batches, not one undo command per point
+  const QgsFeatureId fid = streamTool.activeFeature().id();
+  QVERIFY( streamLayer->undoStack()->count() <= streamedCount / 10 + 2 );
+  QVERIFY( streamLayer->editBuffer()->addedFeatures()[ fid ].geometry().constGet()->nCoordinates() <= streamedCount );
+
+  // stopping the stream writes the rest and sends the whole geometry to highlights
+  streamTool.setRecordingType( RecordingMapTool::Manual );
+  QCOMPARE( geometryChangedSpy.count(), 3 );
+  QCOMPARE( streamLayer->editBuffer()->addedFeatures()[ fid ].geometry().constGet()->nCoordinates(), streamedCount );
+  QCOMPARE( streamTool.existingVertices().constGet()->partCount(), streamedCount );
+  QCOMPARE( streamTool.midPoints().constGet()->partCount(), streamedCount - 1 );
+  QVERIFY( streamTool.hasValidGeometry() );
+
+  // undo removes points streamed since the last commit together
+  streamTool.setRecordingType( RecordingMapTool::StreamMode );
+  for ( int i = 0; i < 5; ++i )
+  {
+    streamTool.addPoint( QgsPoint( -80 + 0.01 * i, 30 ) );
+  }
+  QCOMPARE( streamTool.recordedGeometry().constGet()->nCoordinates(), streamedCount + 5 );
+
+  streamTool.undo();
+  QCOMPARE( streamTool.recordedGeometry().constGet()->nCoordinates(), streamedCount );
+  QCOMPARE( streamLayer->editBuffer()->addedFeatures()[ fid ].geometry().constGet()->nCoordinates(), streamedCount );
+
+  // batches do not grow with the line, undo of a long line removes only the last few points
+  streamTool.undo();
+  QVERIFY( streamTool.recordedGeometry().constGet()->nCoordinates() >= streamedCount - 10 );
+  QVERIFY( streamTool.recordedGeometry().constGet()->nCoordinates() < streamedCount );
+
+  delete project;
+  delete streamLayer;
+}
+
+void TestMapTools::testStreamedTail()
+{
+  QgsProject project;
+  project.setCrs( QgsCoordinateReferenceSystem::fromEpsgId( 3857 ) );
+  project.writeEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/Enabled" ), true );
+
+  QgsVectorLayer *streamLayer = new QgsVectorLayer( QStringLiteral( "LineString?crs=epsg:3857" ), QStringLiteral( "stream" ), QStringLiteral( "memory" ) );
+  QVERIFY( streamLayer->isValid() );
+  project.addMapLayer( streamLayer );
+
+  InputMapCanvasMap canvas;
+  InputMapSettings *ms = canvas.mapSettings();
+  setupMapSettings( ms, &project, QgsRectangle( -100, -100, 100, 100 ), QSize( 600, 600 ) );
+
+  RecordingMapTool streamTool;
+  streamTool.setMapSettings( ms );
+  streamTool.setActiveLayer( streamLayer );
+  streamTool.setRecordingType( RecordingMapTool::StreamMode );
+
+  QSignalSpy tailSpy( &streamTool, &RecordingMapTool::streamedTailChanged );
+
+  streamTool.addPoint( QgsPoint( 0, 0 ) );
+  QVERIFY( streamTool.streamedTail().isEmpty() );
+  QCOMPARE( tailSpy.count(), 0 );
+
+  // fixes held back by the simplification are displayed, but they are not vertices of the line
+  streamTool.addPoint( QgsPoint( 10, 0 ) );
+  QCOMPARE( streamTool.streamedTail().asWkt(), QStringLiteral( "LineString (0 0, 10 0)" ) );
+  QCOMPARE( streamTool.recordedGeometry().constGet()->nCoordinates(), 1 );
+
+  streamTool.addPoint( QgsPoint( 20, 0 ) );
+  QCOMPARE( streamTool.streamedTail().asWkt(), QStringLiteral( "LineString (0 0, 20 0)" ) );
+  QCOMPARE( streamTool.recordedGeometry().constGet()->nCoordinates(), 1 );
+  QCOMPARE( tailSpy.count(), 2 );
+
+  // sharp turn releases the held back fix, the tail starts from it
+  streamTool.addPoint( QgsPoint( 20, 30 ) );
+  QCOMPARE( streamTool.recordedGeometry().asWkt(), QStringLiteral( "LineString (0 0, 20 0)" ) );
+  QCOMPARE( streamTool.streamedTail().asWkt(), QStringLiteral( "LineString (20 0, 20 30)" ) );
+
+  // stopping the stream adds the held back fix to the line
+  streamTool.setRecordingType( RecordingMapTool::Manual );
+  QCOMPARE( streamTool.recordedGeometry().asWkt(), QStringLiteral( "LineString (0 0, 20 0, 20 30)" ) );
+  QVERIFY( streamTool.streamedTail().isEmpty() );
+  QCOMPARE( tailSpy.count(), 4 );
+}
@@ -51,6 +51,10 @@ class TestMapTools : public QObject
     void testAntennaHeight();
     void testSmallTracking();
 
+    void testLargeGeometryVertices();
+    void testStreamedPointsAppend();
+    void testStreamedTail();
+
   private:
     PositionKit *mPositionKit;
     AppSettings *mAppSettings;
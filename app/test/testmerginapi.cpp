@@ -398,6 +398,159 @@ void TestMerginApi::testCreateDeleteProject()
   QVERIFY( !_findProjectByName( projectNamespace, projectName, projects ).isValid() );
 }
 
+void TestMerginApi::testWarmUpSslConfiguration()
+{
+  // requests only reuse the warmed up connection when it negotiated HTTP/2, so h2 must be offered first
+  const QList<QByteArray> protocols = MerginApi::warmUpSslConfiguration().allowedNextProtocols();
+  QCOMPARE( protocols.size(), 2 );
+  QCOMPARE( protocols.at( 0 ), QByteArray( QSslConfiguration::ALPNProtocolHTTP2 ) );
+  QCOMPARE( protocols.at( 1 ), QByteArray( QSslConfiguration::NextProtocolHttp1_1 ) );
+
+  // warming up the connection must not disturb the following requests
+  mApi->warmUpConnection();
+  QSignalSpy spy( mApi, &MerginApi::listProjectsFinished );
+  mApi->listProjects( QString() );
+  QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+  QCOMPARE( spy.count(), 1 );
+}
+
+void TestMerginApi::testCompressedUploadMockServer()
+{
+  // compressible file of a project which exists only on the mock server
+  const QString projectFullName = QStringLiteral( "%1/testCompressedUploadMockServer" ).arg( mWorkspaceName );
+  QTemporaryDir projectDir;
+  const QByteArray content = QByteArray( "id,name\n1,compressed upload\n" ).repeated( 1000 );
+  writeFileContent( projectDir.filePath( QStringLiteral( "data.csv" ) ), content );
+
+  MockHttpServer server( []( const MockHttpServer::Request & request )
+  {
+    MockHttpServer::Response response;
+    if ( request.path.contains( "/v1/project/push/chunk/" ) )
+    {
+      // the server announced gzip, but rejects the encoded chunk after all
+      if ( request.headers.value( "content-encoding" ) == "gzip" )
+        response.status = 415;
+    }
+    else if ( request.path.contains( "/v1/project/push/finish/" ) )
+    {
+      response.status = 400;
+      response.body = "{\"detail\": \"Mock server does not create versions\"}";
+    }
+    else if ( request.path.contains( "/v1/project/push/" ) )
+    {
+      response.headers << qMakePair( QByteArray( "Content-Type" ), QByteArray( "application/json" ) );
+      response.headers << qMakePair( QByteArray( "Accept-Encoding" ), QByteArray( "gzip" ) );
+      response.body = "{\"transaction\": \"mock-transaction\"}";
+    }
+    else
+    {
+      response.status = 404;
+    }
+    return response;
+  } );
+  QVERIFY( server.isListening() );
+
+  const QString apiRoot = mApi->mApiRoot;
+  auto restoreApiRoot = qScopeGuard( [this, apiRoot] { mApi->mApiRoot = apiRoot; } );
+  mApi->mApiRoot = server.url();
+
+  MerginFile file;
+  file.path = QStringLiteral( "data.csv" );
+  file.size = content.size();
+  file.chunks << QStringLiteral( "mock-chunk" );
+
+  TransactionStatus transaction;
+  transaction.type = TransactionStatus::Push;
+  transaction.projectDir = projectDir.path();
+  transaction.totalSize = content.size();
+  transaction.pushQueue << file;
+  mApi->mTransactionalStatus.insert( projectFullName, transaction );
+
+  QSignalSpy finishSpy( mApi, &MerginApi::syncProjectFinished );
+  mApi->pushStart( projectFullName, QByteArrayLiteral( "{}" ) );
+  QVERIFY( finishSpy.wait( TestUtils::SHORT_REPLY ) );
+  QVERIFY( !finishSpy.first().at( 1 ).toBool() ); // finish is refused by the mock server
+  QVERIFY( !mApi->mTransactionalStatus.contains( projectFullName ) );
+
+  // push start, compressed chunk, the same chunk uncompressed and finish
+  const QList<MockHttpServer::Request> requests = server.requests();
+  QCOMPARE( requests.count(), 4 );
+
+  // transport compression of the responses is negotiated by the network manager
+  QVERIFY( CoreUtils::acceptsContentCoding( requests.at( 0 ).headers.value( "accept-encoding" ), "gzip" ) );
+
+  QVERIFY( requests.at( 1 ).path.contains( "/v1/project/push/chunk/mock-transaction/mock-chunk" ) );
+  QCOMPARE( requests.at( 1 ).headers.value( "content-encoding" ), QByteArray( "gzip" ) );
+  QVERIFY( requests.at( 1 ).body.startsWith( QByteArray( "\x1f\x8b" ) ) );
+  QVERIFY( requests.at( 1 ).body.size() < content.size() );
+
+  // 415 turns the compression off and the chunk is uploaded again
+  QVERIFY( requests.at( 2 ).path.contains( "/v1/project/push/chunk/mock-transaction/mock-chunk" ) );
+  QVERIFY( !requests.at( 2 ).headers.contains( "content-encoding" ) );
+  QCOMPARE( requests.at( 2 ).body, content );
+
+  QVERIFY( requests.at( 3 ).path.contains( "/v1/project/push/finish/mock-transaction" ) );
+}
+
+void TestMerginApi::testMaxParallelDownloads()
+{
+  TransactionStatus transaction;
+  QCOMPARE( transaction.maxParallelDownloads(), TransactionStatus::MAX_PARALLEL_DOWNLOADS );
+
+  transaction.http2Used = true;
+  QCOMPARE( transaction.maxParallelDownloads(), TransactionStatus::MAX_PARALLEL_DOWNLOADS_HTTP2 );
+
+  // a reply which came over HTTP/1.1 keeps the transaction at the lower limit
+  MockHttpServer server( []( const MockHttpServer::Request & )
+  {
+    return MockHttpServer::Response();
+  } );
+  QVERIFY( server.isListening() );
+
+  TransactionStatus http1Transaction;
+  QNetworkReply *reply = mApi->mManager->get( QNetworkRequest( QUrl( server.url() ) ) );
+  mApi->startRequestTiming( reply );
+  QSignalSpy finishedSpy( reply, &QNetworkReply::finished );
+  QVERIFY( finishedSpy.wait( TestUtils::SHORT_REPLY ) );
+  QCOMPARE( reply->error(), QNetworkReply::NoError );
+
+  mApi->recordRequestTiming( http1Transaction, reply );
+  reply->deleteLater();
+
+  QCOMPARE( http1Transaction.requestCount, 1 );
+  QVERIFY( !http1Transaction.http2Used );
+  QCOMPARE( http1Transaction.maxParallelDownloads(), TransactionStatus::MAX_PARALLEL_DOWNLOADS );
+}
+
+void TestMerginApi::testWarmUpConnectionReuse()
+{
+  MockHttpServer server( []( const MockHttpServer::Request & )
+  {
+    return MockHttpServer::Response();
+  } );
+  QVERIFY( server.isListening() );
+
+  const QString apiRoot = mApi->mApiRoot;
+  auto restoreApiRoot = qScopeGuard( [this, apiRoot] { mApi->mApiRoot = apiRoot; } );
+  mApi->mApiRoot = server.url();
+
+  mApi->warmUpConnection();
+  QTRY_COMPARE( server.connectionCount(), 1 );
+
+  // the following requests go over the warmed up connection instead of opening new ones
+  for ( int i = 0; i < 2; ++i )
+  {
+    QNetworkReply *reply = mApi->mManager->get( QNetworkRequest( QUrl( server.url() + QStringLiteral( "v1/ping" ) ) ) );
+    QSignalSpy finishedSpy( reply, &QNetworkReply::finished );
+    QVERIFY( finishedSpy.wait( TestUtils::SHORT_REPLY ) );
+    QCOMPARE( reply->error(), QNetworkReply::NoError );
+    reply->deleteLater();
+  }
+
+  QCOMPARE( server.requests().count(), 2 );
+  QCOMPARE( server.connectionCount(), 1 );
+}
+
 void TestMerginApi::testUploadProject()
 {
   QString projectName = "testUploadProject";
@@ -1168,6 +1321,54 @@ void TestMerginApi::testDiffSubdirsUpload()
   QVERIFY( !MerginApi::hasLocalProjectChanges( projectDir ) );
 }
 
+void TestMerginApi::testDiffMultipleFilesUpload()
+{
+  // changesets of several diffable files are prepared in parallel before push start
+  QString projectName = "testDiffMultipleFilesUpload";
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+
+  const QStringList files = { "base.gpkg", "second.gpkg", "third.gpkg", "subdir/fourth.gpkg" };
+
+  QTemporaryDir sourceDir;
+  QVERIFY( sourceDir.isValid() );
+  QVERIFY( QDir( sourceDir.path() ).mkpath( "subdir" ) );
+  for ( const QString &file : files )
+  {
+    QVERIFY( QFile::copy( mTestDataPath + "/diff_project/base.gpkg", sourceDir.path() + "/" + file ) );
+  }
+
+  createRemoteProject( mApiExtra, mWorkspaceName, projectName, sourceDir.path() + "/" );
+
+  downloadRemoteProject( mApi, mWorkspaceName, projectName );
+
+  QCOMPARE( MerginApi::localProjectChanges( projectDir ), ProjectDiff() );  // no local changes expected
+
+  // make sure the files get a different timestamp or their checksums will be read from the cache
+  QTest::qSleep( 1000 );
+  for ( const QString &file : files )
+  {
+    QVERIFY( QFile::remove( projectDir + "/" + file ) );
+    QVERIFY( QFile::copy( mTestDataPath + "/modified_1_geom.gpkg", projectDir + "/" + file ) );
+  }
+
+  ProjectDiff diff = MerginApi::localProjectChanges( projectDir );
+  ProjectDiff expectedDiff;
+  expectedDiff.localUpdated = QSet<QString>( files.begin(), files.end() );
+  QVERIFY2( diff == expectedDiff, diff.dump().toStdString().c_str() );
+
+  uploadRemoteProject( mApi, mWorkspaceName, projectName );
+
+  QCOMPARE( MerginApi::localProjectChanges( projectDir ), ProjectDiff() );  // no local changes expected
+  QVERIFY( !MerginApi::hasLocalProjectChanges( projectDir ) );
+
+  // no diff files are left behind
+  for ( const QString &file : files )
+  {
+    const QFileInfo fileInfo( projectDir + "/.mergin/" + file );
+    QVERIFY( fileInfo.dir().entryList( { fileInfo.fileName() + "-diff-*" }, QDir::Files ).isEmpty() );
+  }
+}
+
 void TestMerginApi::testDiffUpdateBasic()
 {
   // test case where there is no local change in a gpkg, it is only modified on the server
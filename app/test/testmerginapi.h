@@ -12,6 +12,10 @@
 
 #include <QObject>
 #include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <functional>
 
 #include "inputconfig.h"
 #include <qgsvectorlayer.h>
@@ -88,6 +92,116 @@ class MockNetworkManager : public QNetworkAccessManager
     QNetworkReply::NetworkError mErrorCode;
 };
 
+/**
+ * Minimal local HTTP/1.1 server for tests which need to check the requests on the wire.
+ * Requests are answered by the handler and recorded, connections are kept alive.
+ */
+class MockHttpServer : public QTcpServer
+{
+  public:
+    struct Request
+    {
+      QByteArray method;
+      QByteArray path;
+      QHash<QByteArray, QByteArray> headers; //!< names in lower case
+      QByteArray body;
+    };
+
+    struct Response
+    {
+      int status = 200;
+      QList<QPair<QByteArray, QByteArray>> headers;
+      QByteArray body;
+    };
+
+    using Handler = std::function<Response( const Request & )>;
+
+    explicit MockHttpServer( Handler handler, QObject *parent = nullptr )
+      : QTcpServer( parent )
+      , mHandler( std::move( handler ) )
+    {
+      connect( this, &QTcpServer::newConnection, this, [this]()
+      {
+        while ( QTcpSocket *socket = nextPendingConnection() )
+        {
+          ++mConnectionCount;
+          connect( socket, &QTcpSocket::readyRead, this, [this, socket]() { readRequests( socket ); } );
+          connect( socket, &QTcpSocket::disconnected, this, [this, socket]()
+          {
+            mBuffers.remove( socket );
+            socket->deleteLater();
+          } );
+        }
+      } );
+
+      listen( QHostAddress::LocalHost );
+    }
+
+    //! Returns URL of the server root, ending with a slash like the API root
+    QString url() const { return QStringLiteral( "http://127.0.0.1:%1/" ).arg( serverPort() ); }
+
+    //! Returns number of accepted connections
+    int connectionCount() const { return mConnectionCount; }
+
+    //! Returns all received requests
+    QList<Request> requests() const { return mRequests; }
+
+  private:
+    void readRequests( QTcpSocket *socket )
+    {
+      QByteArray &buffer = mBuffers[socket];
+      buffer += socket->readAll();
+
+      while ( true )
+      {
+        const qsizetype headerEnd = buffer.indexOf( "\r\n\r\n" );
+        if ( headerEnd < 0 )
+          return;
+
+        Request request;
+        const QList<QByteArray> lines = buffer.left( headerEnd ).split( '\n' );
+        const QList<QByteArray> requestLine = lines.first().trimmed().split( ' ' );
+        if ( requestLine.size() < 2 )
+        {
+          socket->disconnectFromHost();
+          return;
+        }
+
+        request.method = requestLine.at( 0 );
+        request.path = requestLine.at( 1 );
+        for ( qsizetype i = 1; i < lines.size(); ++i )
+        {
+          const qsizetype colon = lines.at( i ).indexOf( ':' );
+          if ( colon > 0 )
+            request.headers.insert( lines.at( i ).left( colon ).trimmed().toLower(), lines.at( i ).mid( colon + 1 ).trimmed() );
+        }
+
+        // wait for the rest of the body
+        const qsizetype bodyLength = request.headers.value( "content-length", "0" ).toLongLong();
+        if ( buffer.size() < headerEnd + 4 + bodyLength )
+          return;
+
+        request.body = buffer.mid( headerEnd + 4, bodyLength );
+        buffer.remove( 0, headerEnd + 4 + bodyLength );
+        mRequests << request;
+
+        const Response response = mHandler( request );
+        QByteArray data = "HTTP/1.1 " + QByteArray::number( response.status ) + " Mock\r\n";
+        for ( const QPair<QByteArray, QByteArray> &header : response.headers )
+          data += header.first + ": " + header.second + "\r\n";
+        data += "Content-Length: " + QByteArray::number( response.body.size() ) + "\r\n";
+        data += "Connection: keep-alive\r\n\r\n";
+        data += response.body;
+        socket->write( data );
+      }
+    }
+
+    Handler mHandler;
+    QHash<QTcpSocket *, QByteArray> mBuffers;
+    QList<Request> mRequests;
+    int mConnectionCount = 0;
+};
+
 class TestMerginApi: public QObject
 {
     Q_OBJECT
@@ -114,6 +228,10 @@ class TestMerginApi: public QObject
     void testCreateProjectTwice();
     void testDeleteNonExistingProject();
     void testCreateDeleteProject();
+    void testWarmUpSslConfiguration();
+    void testCompressedUploadMockServer();
+    void testMaxParallelDownloads();
+    void testWarmUpConnectionReuse();
     void testUploadProject();
     void testMultiChunkUploadDownload();
     void testEmptyFileUploadDownload();
@@ -130,6 +248,7 @@ class TestMerginApi: public QObject
     void testUploadWithUpdate();
     void testDiffUpload();
     void testDiffSubdirsUpload();
+    void testDiffMultipleFilesUpload();
     void testDiffUpdateBasic();
     void testDiffUpdateWithRebase();
     void testDiffUpdateWithRebaseFailed();
@@ -10,12 +10,37 @@
 #include "testmodels.h"
 #include "testutils.h"
 #include "featuresmodel.h"
+#include "featuresearchindex.h"
+#include "lookuptable.h"
 #include "valuerelationfeaturesmodel.h"
 #include "projectsmodel.h"
 #include "projectsproxymodel.h"
+#include "localprojectsmanager.h"
+#include "qgsvectorlayerfeatureiterator.h"
+#include "qgsexpressioncontextutils.h"
 
 #include <QtTest/QtTest>
 
+#include "qgsexpressionfunction.h"
+
+//! Expression function counting its evaluations, used in a virtual field to count features read from a layer
+class CountReadsFunction : public QgsScalarFunction
+{
+  public:
+    CountReadsFunction()
+      : QgsScalarFunction( QStringLiteral( "test_count_reads" ), 0, QStringLiteral( "Test" ) )
+    {}
+
+    QVariant func( const QVariantList &, const QgsExpressionContext *, QgsExpression *, const QgsExpressionNodeFunction * ) override
+    {
+      return ++sCount;
+    }
+
+    static int sCount;
+};
+
+int CountReadsFunction::sCount = 0;
+
 
 void TestModels::init()
 {
@@ -57,6 +82,66 @@ void TestModels::testFeaturesModel()
   QCOMPARE( title, QStringLiteral( "First" ) );
 }
 
+void TestModels::testFeaturesModelTitleCache()
+{
+  FeaturesModel fModel;
+  QSignalSpy spy( &fModel, &FeaturesModel::fetchingResultsChanged );
+
+  QString projectDir = TestUtils::testDataDir() + "/project_value_relations";
+  QgsVectorLayer *layer = new QgsVectorLayer( projectDir + "/db.gpkg|layername=main", "base", "ogr" );
+
+  QVERIFY( layer && layer->isValid() );
+
+  fModel.setLayer( layer );
+  fModel.reloadFeatures();
+  spy.wait();
+
+  QVERIFY( fModel.rowCount() > 0 );
+  QCOMPARE( fModel.data( fModel.index( 0 ), FeaturesModel::FeatureTitle ), QStringLiteral( "First" ) );
+  QCOMPARE( fModel.data( fModel.index( 0 ), Qt::DisplayRole ), QStringLiteral( "First" ) );
+
+  // the display expression is prepared once per layer and titles are memoized
+  QCOMPARE( fModel.mDisplayExpressions.count(), 1 );
+  QCOMPARE( fModel.mFeatureTitles.count(), 1 );
+
+  // changing the display expression invalidates cached titles
+  QSignalSpy dataChangedSpy( &fModel, &FeaturesModel::dataChanged );
+  layer->setDisplayExpression( QStringLiteral( "'Title ' || $id" ) );
+
+  QCOMPARE( dataChangedSpy.count(), 1 );
+  QVERIFY( fModel.mFeatureTitles.isEmpty() );
+
+  QgsFeatureId fid = fModel.data( fModel.index( 0 ), FeaturesModel::FeatureId ).toLongLong();
+  QCOMPARE( fModel.data( fModel.index( 0 ), FeaturesModel::FeatureTitle ), QStringLiteral( "Title %1" ).arg( fid ) );
+
+  // static model with features of another layer
+  QgsVectorLayer *staticLayer = new QgsVectorLayer( projectDir + "/db.gpkg|layername=main", "static", "ogr" );
+  QVERIFY( staticLayer && staticLayer->isValid() );
+
+  FeaturesModel staticModel;
+  staticModel.populateStaticModel( { FeatureLayerPair( staticLayer->getFeature( fid ), staticLayer ) } );
+  QCOMPARE( staticModel.data( staticModel.index( 0 ), FeaturesModel::FeatureTitle ), QStringLiteral( "First" ) );
+  QCOMPARE( staticModel.mDisplayExpressions.count(), 1 );
+  QVERIFY( staticModel.mDisplayExpressions.contains( staticLayer->id() ) );
+
+  // display expression of a layer of the static model is watched too
+  staticLayer->setDisplayExpression( QStringLiteral( "'Static ' || $id" ) );
+  QCOMPARE( staticModel.data( staticModel.index( 0 ), FeaturesModel::FeatureTitle ), QStringLiteral( "Static %1" ).arg( fid ) );
+
+  // repopulating drops the cached expressions
+  staticModel.populateStaticModel( {} );
+  QVERIFY( staticModel.mDisplayExpressions.isEmpty() );
+
+  // and so does destroying the layer
+  staticModel.populateStaticModel( { FeatureLayerPair( staticLayer->getFeature( fid ), staticLayer ) } );
+  QCOMPARE( staticModel.data( staticModel.index( 0 ), FeaturesModel::FeatureTitle ), QStringLiteral( "Static %1" ).arg( fid ) );
+  delete staticLayer;
+  QVERIFY( staticModel.mDisplayExpressions.isEmpty() );
+  QVERIFY( staticModel.mFeatureTitles.isEmpty() );
+
+  delete layer;
+}
+
 void TestModels::testFeaturesModelSorted()
 {
   FeaturesModel model;
@@ -124,6 +209,188 @@ void TestModels::testFeaturesModelSorted()
   QCOMPARE( model.data( model.index( 8, 0 ), FeaturesModel::ModelRoles::FeatureId ), 100000000 );
 }
 
+void TestModels::testFeaturesModelIncrementalUpdates()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?field=name:string" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer && layer->isValid() );
+  layer->setDisplayExpression( QStringLiteral( "name" ) );
+
+  QgsFeatureList features;
+  for ( const QString &name : { QStringLiteral( "A" ), QStringLiteral( "B" ), QStringLiteral( "C" ) } )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttribute( QStringLiteral( "name" ), name );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  FeaturesModel model;
+  QSignalSpy fetchSpy( &model, &FeaturesModel::fetchingResultsChanged );
+  model.setLayer( layer );
+  model.reloadFeatures();
+  fetchSpy.wait();
+
+  QCOMPARE( model.rowCount(), 3 );
+  QCOMPARE( model.rowFromRoleValue( FeaturesModel::FeatureId, 2 ), 1 );
+
+  QSignalSpy resetSpy( &model, &FeaturesModel::modelReset );
+  QSignalSpy dataChangedSpy( &model, &FeaturesModel::dataChanged );
+
+  // attribute change of a listed feature only updates its row
+  layer->startEditing();
+  layer->changeAttributeValue( 2, 0, QStringLiteral( "B2" ) );
+  QVERIFY( dataChangedSpy.wait() );
+  QCOMPARE( model.data( model.index( 1 ), FeaturesModel::FeatureTitle ), QStringLiteral( "B2" ) );
+
+  // deleted feature is removed from the model
+  layer->deleteFeature( 1 );
+  QCOMPARE( model.rowCount(), 2 );
+  QCOMPARE( model.rowFromRoleValue( FeaturesModel::FeatureId, 3 ), 1 );
+
+  // added feature appears once committed
+  QSignalSpy insertSpy( &model, &FeaturesModel::rowsInserted );
+  QgsFeature f( layer->fields() );
+  f.setAttribute( QStringLiteral( "name" ), QStringLiteral( "D" ) );
+  layer->addFeature( f );
+  layer->commitChanges();
+  QVERIFY( insertSpy.wait() );
+  QCOMPARE( model.rowCount(), 3 );
+  QCOMPARE( model.data( model.index( 2 ), FeaturesModel::FeatureTitle ), QStringLiteral( "D" ) );
+
+  QCOMPARE( resetSpy.count(), 0 );
+
+  delete layer;
+}
+
+void TestModels::testFeaturesModelPaged()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?field=name:string&field=note:string" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer && layer->isValid() );
+  layer->setDisplayExpression( QStringLiteral( "name" ) );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttribute( QStringLiteral( "name" ), QStringLiteral( "F%1" ).arg( i ) );
+    f.setAttribute( QStringLiteral( "note" ), QStringLiteral( "note" ) );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  FeaturesModel model;
+  model.mPagedFetching = true;
+  QSignalSpy spy( &model, &FeaturesModel::fetchingResultsChanged );
+  model.setLayer( layer );
+  model.reloadFeatures();
+  spy.wait();
+
+  // only the first page is in the model, all matching ids are known
+  QCOMPARE( model.rowCount(), model.PAGE_SIZE );
+  QCOMPARE( model.mFeatureIds.count(), 2500 );
+  QVERIFY( model.canFetchMore( QModelIndex() ) );
+
+  // attributes of the page are loaded in the background
+  QSignalSpy dataChangedSpy( &model, &FeaturesModel::dataChanged );
+  QTRY_COMPARE( model.data( model.index( 0 ), FeaturesModel::FeatureTitle ), QStringLiteral( "F0" ) );
+  QVERIFY( dataChangedSpy.count() >= 1 );
+
+  // complete feature is provided for the feature pair
+  FeatureLayerPair pair = model.data( model.index( 0 ), FeaturesModel::FeaturePair ).value<FeatureLayerPair>();
+  QVERIFY( pair.feature().hasGeometry() );
+  QCOMPARE( pair.feature().attribute( QStringLiteral( "note" ) ), QStringLiteral( "note" ) );
+
+  while ( model.canFetchMore( QModelIndex() ) )
+  {
+    model.fetchMore( QModelIndex() );
+  }
+  QCOMPARE( model.rowCount(), 2500 );
+  QTRY_VERIFY( model.mLoadingPages.isEmpty() && model.mRequestedPages.isEmpty() );
+
+  // old pages get evicted and are loaded again in the background when needed, titles stay memoized
+  QCOMPARE( model.mLoadedPages.count(), model.MAX_LOADED_PAGES );
+  QVERIFY( !model.mFeatures.at( 1 ).feature().isValid() );
+  QCOMPARE( model.data( model.index( 0 ), FeaturesModel::FeatureTitle ), QStringLiteral( "F0" ) );
+  QCOMPARE( model.data( model.index( 1 ), FeaturesModel::SearchResult ), QString() );
+  QVERIFY( !model.mFeatures.at( 1 ).feature().isValid() );
+  QTRY_VERIFY( model.mFeatures.at( 1 ).feature().isValid() );
+  QCOMPARE( model.mLoadedPages.first(), 0 );
+
+  // feature ids of all rows are known, also of the rows not fetched to the model
+  QCOMPARE( model.mFeatureRows.count(), 2500 );
+  const QgsFeatureId lastFid = model.mFeatureIds.last();
+  QCOMPARE( model.mFeatureRows.value( lastFid ), 2499 );
+
+  // a deleted feature is never provided as a placeholder
+  const QgsFeatureId firstFid = model.mFeatureIds.first();
+  layer->dataProvider()->deleteFeatures( QgsFeatureIds() << firstFid );
+  QCOMPARE( model.data( model.index( 0 ), FeaturesModel::Feature ), QVariant() );
+  QCOMPARE( model.data( model.index( 0 ), FeaturesModel::FeaturePair ), QVariant() );
+
+  delete layer;
+}
+
+void TestModels::testFeatureSearchIndex()
+{
+  QCOMPARE( FeatureSearchIndex::tokenize( QStringLiteral( "Second-hand  Shop" ) ), QStringList( { "second-hand", "second", "hand", "shop" } ) );
+
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?field=name:string&field=count:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer && layer->isValid() );
+
+  QgsFeatureList features;
+  const QList<QPair<QString, int>> values = { { "Oak tree", 12 }, { "Old oak", 3 }, { "Birch", 120 } };
+  for ( const auto &value : values )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( { value.first, value.second } );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  FeatureSearchIndex *index = FeatureSearchIndex::forLayer( layer );
+  QVERIFY( index );
+  QCOMPARE( FeatureSearchIndex::forLayer( layer ), index );
+
+  QSignalSpy readySpy( index, &FeatureSearchIndex::ready );
+  QVERIFY( readySpy.wait() );
+  QVERIFY( index->isReady() );
+
+  QCOMPARE( index->matchingFeatures( { "oa" } ), QgsFeatureIds( { 1, 2 } ) );
+  QCOMPARE( index->matchingFeatures( { "OAK", "tr" } ), QgsFeatureIds( { 1 } ) );
+  QCOMPARE( index->matchingFeatures( { "12" } ), QgsFeatureIds( { 1, 3 } ) );
+  QVERIFY( index->matchingFeatures( { "ak" } ).isEmpty() );
+
+  // index follows edits of the layer
+  layer->startEditing();
+  layer->changeAttributeValue( 3, 0, QStringLiteral( "Oak sapling" ) );
+  layer->deleteFeature( 2 );
+  QCOMPARE( index->matchingFeatures( { "oak" } ), QgsFeatureIds( { 1, 3 } ) );
+  layer->rollBack();
+
+  // features model uses the index for search
+  FeaturesModel model;
+  model.mUseSearchIndex = true;
+  QSignalSpy fetchSpy( &model, &FeaturesModel::fetchingResultsChanged );
+  model.setLayer( layer );
+  model.setSearchExpression( QStringLiteral( "bir" ) );
+  fetchSpy.wait();
+  QCOMPARE( model.rowCount(), 1 );
+  QCOMPARE( model.data( model.index( 0 ), FeaturesModel::FeatureId ), 3 );
+
+  // canceled build stops without reading the remaining features
+  std::shared_ptr<std::atomic_bool> canceled = std::make_shared<std::atomic_bool>( true );
+  const FeatureSearchIndex::Tokens tokens = FeatureSearchIndex::buildTokens( new QgsVectorLayerFeatureSource( layer ), layer->fields(), canceled );
+  QVERIFY( tokens.tokensByFeature.isEmpty() );
+
+  // rebuild of the index is still running when the layer (and its index) gets deleted, nothing waits for it
+  index->rebuild();
+  QVERIFY( !index->isReady() );
+  QPointer<FeatureSearchIndex> indexPtr( index );
+  delete layer;
+  QVERIFY( indexPtr.isNull() );
+}
+
 void TestModels::testValueRelationFeaturesModel()
 {
   QString projectDir = TestUtils::testDataDir() + "/project_value_relations";
@@ -243,6 +510,121 @@ void TestModels::testValueRelationFeaturesModel()
   QCOMPARE( model.data( model.index( 6, 0 ), FeaturesModel::ModelRoles::FeatureId ), 7 );
   QCOMPARE( model.data( model.index( 7, 0 ), FeaturesModel::ModelRoles::FeatureId ), 8 );
   QCOMPARE( model.data( model.index( 8, 0 ), FeaturesModel::ModelRoles::FeatureId ), 100000000 );
+
+  // conversions between keys, feature ids and titles
+  QCOMPARE( model.convertToKey( 3 ), QVariant( 3 ) );
+  QCOMPARE( model.convertToKey( 12345 ), QVariant() );
+  QCOMPARE( model.convertFromQgisType( 100000000, FeaturesModel::FeatureTitle ).toList(), QVariantList( { QStringLiteral( "VERYBIG" ) } ) );
+  QCOMPARE( model.convertFromQgisType( 2, FeaturesModel::FeatureId ).toList().count(), 1 );
+  QCOMPARE( model.convertFromQgisType( 2, FeaturesModel::FeatureId ).toList().first(), QVariant( 2 ) );
+}
+
+void TestModels::testLookupTable()
+{
+  QString projectDir = TestUtils::testDataDir() + "/project_value_relations";
+  QVERIFY( QgsProject::instance()->read( projectDir + "/proj.qgz" ) );
+
+  QgsVectorLayer *mainLayer = static_cast<QgsVectorLayer *>( QgsProject::instance()->mapLayersByName( QStringLiteral( "main" ) ).at( 0 ) );
+  QgsVectorLayer *subsubLayer = static_cast<QgsVectorLayer *>( QgsProject::instance()->mapLayersByName( QStringLiteral( "subsub" ) ).at( 0 ) );
+  QVERIFY( mainLayer && subsubLayer );
+
+  LookupTable *table = LookupTable::forLayer( subsubLayer, QStringLiteral( "fid" ), QStringLiteral( "Name" ) );
+  QVERIFY( table );
+  QCOMPARE( LookupTable::forLayer( subsubLayer, QStringLiteral( "fid" ), QStringLiteral( "Name" ) ), table );
+  QVERIFY( !LookupTable::forLayer( subsubLayer, QStringLiteral( "missing" ), QStringLiteral( "Name" ) ) );
+
+  if ( !table->isReady() )
+  {
+    QSignalSpy readySpy( table, &LookupTable::ready );
+    QVERIFY( readySpy.wait() );
+  }
+
+  QCOMPARE( table->count(), 9 );
+  QCOMPARE( table->rows( QStringLiteral( "subFk = 1" ) ).count(), 2 );
+  QVERIFY( table->mFilterRows.contains( QStringLiteral( "subFk = 1" ) ) );
+
+  // filters with variables or volatile functions are evaluated every time
+  QVERIFY( LookupTable::isCacheableFilter( QStringLiteral( "subFk = 1 and upper(\"Name\") like 'A%'" ) ) );
+  QVERIFY( !LookupTable::isCacheableFilter( QStringLiteral( "subFk = @lookup_key" ) ) );
+  QVERIFY( !LookupTable::isCacheableFilter( QStringLiteral( "to_date(now()) > '2020-01-01'" ) ) );
+  QVERIFY( !LookupTable::isCacheableFilter( QStringLiteral( "rand(0, 1) = 0" ) ) );
+
+  QgsExpressionContextUtils::setProjectVariable( QgsProject::instance(), QStringLiteral( "lookup_key" ), 1 );
+  QCOMPARE( table->rows( QStringLiteral( "subFk = @lookup_key" ) ).count(), 2 );
+  QgsExpressionContextUtils::setProjectVariable( QgsProject::instance(), QStringLiteral( "lookup_key" ), -1 );
+  QCOMPARE( table->rows( QStringLiteral( "subFk = @lookup_key" ) ).count(), 0 );
+  QVERIFY( !table->mFilterRows.contains( QStringLiteral( "subFk = @lookup_key" ) ) );
+  QCOMPARE( table->value( 100000000 ), QVariant( QStringLiteral( "VERYBIG" ) ) );
+
+  const QVector<int> sortedRows = table->rows( QString(), true );
+  FeatureLayerPairs pairs = table->features( sortedRows );
+  QCOMPARE( pairs.count(), 9 );
+  QCOMPARE( pairs.first().feature().attribute( QStringLiteral( "Name" ) ), QVariant( QStringLiteral( "A1" ) ) );
+
+  // value relation model is served from the table when the filter does not depend on the form
+  ValueRelationFeaturesModel model;
+  QVariantMap config =
+  {
+    { QStringLiteral( "Layer" ), subsubLayer->id() },
+    { QStringLiteral( "Key" ), QStringLiteral( "fid" ) },
+    { QStringLiteral( "Value" ), QStringLiteral( "Name" ) },
+    { QStringLiteral( "FilterExpression" ), QStringLiteral( "subFk = 1" ) },
+  };
+  model.setConfig( config );
+  model.setPair( FeatureLayerPair( mainLayer->getFeature( 1 ), mainLayer ) );
+
+  QVERIFY( model.mPopulatedFromLookupTable );
+  QCOMPARE( model.rowCount(), 2 );
+  QCOMPARE( model.convertFromQgisType( 100000000, FeaturesModel::FeatureTitle ).toList().count(), 0 );
+
+  // complete feature is read from the layer for the feature pair
+  FeatureLayerPair pair = model.data( model.index( 0 ), FeaturesModel::FeaturePair ).value<FeatureLayerPair>();
+  QVERIFY( pair.feature().attribute( QStringLiteral( "subFk" ) ).isValid() );
+
+  // features of a partial model are not read from the layer, only the feature pair is - a virtual field counts the reads
+  CountReadsFunction *countReads = new CountReadsFunction();
+  QVERIFY( QgsExpression::registerFunction( countReads, true ) );
+
+  QSignalSpy rebuiltSpy( table, &LookupTable::ready );
+  QVERIFY( subsubLayer->addExpressionField( QStringLiteral( "test_count_reads()" ), QgsField( QStringLiteral( "reads" ), QVariant::Int ) ) >= 0 );
+  QVERIFY( rebuiltSpy.wait() );
+  CountReadsFunction::sCount = 0;
+
+  // the model got rows of the rebuilt table
+  QVERIFY( model.mPopulatedFromLookupTable );
+  QCOMPARE( model.rowCount(), 2 );
+
+  for ( int row = 0; row < model.rowCount(); ++row )
+  {
+    const QgsFeature feature = model.data( model.index( row ), FeaturesModel::Feature ).value<QgsFeature>();
+    QVERIFY( feature.attribute( QStringLiteral( "fid" ) ).isValid() );
+  }
+
+  const QVariant fid = model.data( model.index( 1 ), FeaturesModel::FeatureId );
+  const QVariant key = model.convertToKey( fid );
+  QVERIFY( key.isValid() );
+  QCOMPARE( model.convertFromQgisType( key, FeaturesModel::FeatureId ).toList(), QVariantList( { fid } ) );
+  QCOMPARE( CountReadsFunction::sCount, 0 );
+
+  model.data( model.index( 0 ), FeaturesModel::FeaturePair );
+  QCOMPARE( CountReadsFunction::sCount, 1 );
+
+  QVERIFY( QgsExpression::unregisterFunction( QStringLiteral( "test_count_reads" ) ) );
+
+  // canceled build stops without reading the remaining features
+  std::shared_ptr<std::atomic_bool> canceled = std::make_shared<std::atomic_bool>( true );
+  const int keyIndex = subsubLayer->fields().indexOf( QStringLiteral( "fid" ) );
+  const LookupTable::Columns columns = LookupTable::readColumns( new QgsVectorLayerFeatureSource( subsubLayer ), keyIndex, -1,
+                                       subsubLayer->displayExpression(), QgsExpressionContext(), canceled );
+  QVERIFY( columns.fids.isEmpty() );
+
+  // the table is destroyed while it is being built, nothing waits for the build
+  QPointer<LookupTable> titlesTable( LookupTable::forLayer( subsubLayer, QStringLiteral( "fid" ), QString() ) );
+  QVERIFY( titlesTable );
+  titlesTable->rebuild();
+  QVERIFY( !titlesTable->isReady() );
+  delete titlesTable;
+  QVERIFY( titlesTable.isNull() );
 }
 
 void TestModels::testProjectsModel()
@@ -290,6 +672,101 @@ void TestModels::testProjectsModel()
   QVERIFY( model.data( model.index( 2 ), ProjectsModel::Roles::ProjectIsActiveProject ).toBool() );
 }
 
+void TestModels::testProjectsModelApplyDelta()
+{
+  auto createProject = []( const QString & name )
+  {
+    Project p;
+    p.local.projectNamespace = QStringLiteral( "namespace" );
+    p.local.projectName = name;
+    p.local.projectDir = name + QStringLiteral( "_dir" );
+    return p;
+  };
+
+  Project pA = createProject( QStringLiteral( "project_A" ) );
+  Project pB = createProject( QStringLiteral( "project_B" ) );
+  Project pC = createProject( QStringLiteral( "project_C" ) );
+  Project pD = createProject( QStringLiteral( "project_D" ) );
+
+  ProjectsModel model;
+  model.setModelType( ProjectsModel::LocalProjectsModel );
+
+  QSignalSpy resetSpy( &model, &ProjectsModel::modelReset );
+  QSignalSpy insertSpy( &model, &ProjectsModel::rowsInserted );
+  QSignalSpy removeSpy( &model, &ProjectsModel::rowsRemoved );
+  QSignalSpy moveSpy( &model, &ProjectsModel::rowsMoved );
+
+  model.applyProjects( { pA, pB, pC } );
+  QCOMPARE( model.rowCount(), 3 );
+  QCOMPARE( insertSpy.count(), 3 );
+
+  // the same listing again does not touch the rows
+  insertSpy.clear();
+  model.applyProjects( { pA, pB, pC } );
+  QCOMPARE( insertSpy.count(), 0 );
+  QCOMPARE( removeSpy.count(), 0 );
+  QCOMPARE( moveSpy.count(), 0 );
+
+  // B removed, D added, C and A swapped
+  model.applyProjects( { pC, pA, pD } );
+  QCOMPARE( model.rowCount(), 3 );
+  QCOMPARE( removeSpy.count(), 1 );
+  QCOMPARE( insertSpy.count(), 1 );
+  QCOMPARE( moveSpy.count(), 1 );
+
+  QCOMPARE( model.data( model.index( 0 ), ProjectsModel::ProjectId ).toString(), pC.id() );
+  QCOMPARE( model.data( model.index( 1 ), ProjectsModel::ProjectId ).toString(), pA.id() );
+  QCOMPARE( model.data( model.index( 2 ), ProjectsModel::ProjectId ).toString(), pD.id() );
+
+  model.applyProjects( {} );
+  QCOMPARE( model.rowCount(), 0 );
+
+  // model is never reset
+  QCOMPARE( resetSpy.count(), 0 );
+}
+
+void TestModels::testProjectsModelNewSearch()
+{
+  auto createProject = []( const QString & name )
+  {
+    MerginProject p;
+    p.projectNamespace = QStringLiteral( "namespace" );
+    p.projectName = name;
+    return p;
+  };
+
+  QTemporaryDir dataDir;
+  LocalProjectsManager localProjectsManager( dataDir.path() );
+
+  ProjectsModel model;
+  model.mModelType = ProjectsModel::WorkspaceProjectsModel;
+  model.mLocalProjectsManager = &localProjectsManager;
+
+  QSignalSpy resetSpy( &model, &ProjectsModel::modelReset );
+
+  // first listing of a search
+  model.mRequestedSearchExpression = QStringLiteral( "project" );
+  model.applyListedPage( { createProject( "project_A" ), createProject( "project_B" ) }, 3, 1 );
+  QCOMPARE( model.rowCount(), 2 );
+  QCOMPARE( resetSpy.count(), 1 );
+
+  model.applyListedPage( { createProject( "project_C" ) }, 3, 2 );
+  QCOMPARE( model.rowCount(), 3 );
+
+  // the first page of the same search (e.g. revalidated after the cached one) is applied as a delta
+  model.applyListedPage( { createProject( "project_B" ), createProject( "project_A" ) }, 3, 1 );
+  QCOMPARE( model.rowCount(), 2 );
+  QCOMPARE( resetSpy.count(), 1 );
+
+  // the first page of another search replaces everything
+  model.mRequestedSearchExpression = QStringLiteral( "other" );
+  model.applyListedPage( { createProject( "other_A" ) }, 1, 1 );
+  QCOMPARE( resetSpy.count(), 2 );
+  QCOMPARE( model.rowCount(), 1 );
+  QCOMPARE( model.data( model.index( 0 ), ProjectsModel::ProjectName ).toString(), QStringLiteral( "other_A" ) );
+  QVERIFY( !model.hasMoreProjects() );
+}
+
 void TestModels::testProjectsProxyModel()
 {
   Project p0;
@@ -24,8 +24,15 @@ class TestModels : public QObject
 
     void testFeaturesModel();
     void testFeaturesModelSorted();
+    void testFeaturesModelTitleCache();
+    void testFeaturesModelIncrementalUpdates();
+    void testFeaturesModelPaged();
+    void testFeatureSearchIndex();
     void testValueRelationFeaturesModel();
+    void testLookupTable();
     void testProjectsModel();
+    void testProjectsModelApplyDelta();
+    void testProjectsModelNewSearch();
     void testProjectsProxyModel();
 
 };
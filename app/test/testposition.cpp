@@ -12,6 +12,9 @@
 #include <QApplication>
 #include <QScreen>
 #include <QSignalSpy>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTemporaryDir>
 
 #include "qgsapplication.h"
 #include "appsettings.h"
@@ -30,6 +33,7 @@
 #include "position/tracking/positiontrackingmanager.h"
 #include "position/tracking/internaltrackingbackend.h"
 #include "position/tracking/positiontrackinghighlight.h"
+#include "position/tracking/tracksimplifier.h"
 
 #include "testutils.h"
 
@@ -487,3 +491,152 @@ void TestPosition::testPositionTrackingHighlight()
 
   QVERIFY( trackingHighlight.highlightGeometry().isEmpty() );
 }
+
+void TestPosition::testTrackSimplifier()
+{
+  const QgsCoordinateReferenceSystem crs = QgsCoordinateReferenceSystem::fromEpsgId( 3857 );
+
+  // settings from the project
+  QgsProject project;
+  TrackSimplifier::Settings settings = TrackSimplifier::readSettings( &project );
+  QVERIFY( !settings.enabled );
+
+  project.writeEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/Enabled" ), true );
+  project.writeEntry( QStringLiteral( "Mergin" ), QStringLiteral( "TrackSimplification/Tolerance" ), 5.0 );
+  settings = TrackSimplifier::readSettings( &project );
+  QVERIFY( settings.enabled );
+  QCOMPARE( settings.tolerance, 5.0 );
+  QCOMPARE( settings.minDistance, 1.0 );
+
+  // raw tracks are not written to the synchronized project directory
+  QTemporaryDir projectDir;
+  project.setFileName( QDir( projectDir.path() ).filePath( QStringLiteral( "my project/project.qgz" ) ) );
+  const QString projectRawTrackPath = TrackSimplifier::rawTrackFilePath( &project, QStringLiteral( "tracking" ) );
+  QVERIFY( !projectRawTrackPath.isEmpty() );
+  QVERIFY( projectRawTrackPath.startsWith( QStandardPaths::writableLocation( QStandardPaths::AppDataLocation ) ) );
+  QVERIFY( !projectRawTrackPath.startsWith( project.homePath() ) );
+  QVERIFY( projectRawTrackPath.endsWith( QStringLiteral( "/raw_tracks/my_project/tracking.txt" ) ) );
+
+  // disabled simplification passes all fixes
+  TrackSimplifier simplifier;
+  simplifier.setup( TrackSimplifier::Settings(), crs );
+  QCOMPARE( simplifier.addPoint( QgsPoint( 0, 0 ) ).count(), 1 );
+  QCOMPARE( simplifier.addPoint( QgsPoint( 0, 0 ) ).count(), 1 );
+  QVERIFY( simplifier.flush().isEmpty() );
+
+  QTemporaryDir tempDir;
+  const QString rawTrackPath = tempDir.filePath( QStringLiteral( "raw_tracks/track.txt" ) );
+
+  settings = TrackSimplifier::Settings();
+  settings.enabled = true;
+  settings.tolerance = 2;
+  settings.minDistance = 1;
+  settings.maxAngle = 45;
+  settings.keepRawTrack = true;
+  simplifier.setup( settings, crs, rawTrackPath );
+  QCOMPARE( simplifier.rawTrackPath(), rawTrackPath );
+
+  // the first fix starts the track
+  QCOMPARE( simplifier.addPoint( QgsPoint( 0, 0 ) ), QgsPointSequence() << QgsPoint( 0, 0 ) );
+
+  // stationary fix
+  QVERIFY( simplifier.addPoint( QgsPoint( 0.5, 0 ) ).isEmpty() );
+
+  QVERIFY( !simplifier.hasPendingPoint() );
+
+  // fixes on a (nearly) straight line are held back, the last one can be displayed
+  QVERIFY( simplifier.addPoint( QgsPoint( 10, 0 ) ).isEmpty() );
+  QVERIFY( simplifier.addPoint( QgsPoint( 20, 0.5 ) ).isEmpty() );
+  QCOMPARE( simplifier.pendingPoint(), QgsPoint( 20, 0.5 ) );
+  QVERIFY( simplifier.addPoint( QgsPoint( 100, 0 ) ).isEmpty() );
+  QVERIFY( simplifier.hasPendingPoint() );
+  QCOMPARE( simplifier.pendingPoint(), QgsPoint( 100, 0 ) );
+
+  // sharp turn keeps the corner
+  QCOMPARE( simplifier.addPoint( QgsPoint( 100, 50 ) ), QgsPointSequence() << QgsPoint( 100, 0 ) );
+
+  // gentle turn keeps the vertex once the track deviates more than the tolerance
+  QCOMPARE( simplifier.addPoint( QgsPoint( 106, 100 ) ), QgsPointSequence() << QgsPoint( 100, 50 ) );
+
+  // the held back fix ends the track
+  QCOMPARE( simplifier.pendingPoint(), QgsPoint( 106, 100 ) );
+  QCOMPARE( simplifier.flush(), QgsPointSequence() << QgsPoint( 106, 100 ) );
+  QVERIFY( simplifier.flush().isEmpty() );
+  QVERIFY( !simplifier.hasPendingPoint() );
+  QVERIFY( simplifier.pendingPoint().isEmpty() );
+
+  // all fixes are in the raw track
+  QFile rawTrack( rawTrackPath );
+  QVERIFY( rawTrack.open( QIODevice::ReadOnly | QIODevice::Text ) );
+  const QStringList lines = QString( rawTrack.readAll() ).split( '\n', Qt::SkipEmptyParts );
+  QCOMPARE( lines.count(), 1 + 7 ); // header + fixes
+  QCOMPARE( lines.first(), QStringLiteral( "# EPSG:3857" ) );
+  QVERIFY( lines.at( 2 ).startsWith( QStringLiteral( "0.5 0 " ) ) );
+  rawTrack.close();
+
+  auto rawTrackLines = [&rawTrackPath]()
+  {
+    QFile file( rawTrackPath );
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+      return QStringList();
+    return QString( file.readAll() ).split( '\n', Qt::SkipEmptyParts );
+  };
+
+  // continued track (e.g. after the app restarts) appends only live fixes, replayed ones are in the file already
+  simplifier.setup( settings, crs, rawTrackPath, true );
+  simplifier.addPoint( QgsPoint( 0, 0 ), true );
+  simplifier.addPoint( QgsPoint( 100, 0 ), true );
+  simplifier.addPoint( QgsPoint( 200, 0 ) );
+  QCOMPARE( rawTrackLines().count(), 1 + 7 + 1 );
+  QVERIFY( rawTrackLines().last().startsWith( QStringLiteral( "200 0 " ) ) );
+
+  // a new track starts the file again
+  simplifier.setup( settings, crs, rawTrackPath );
+  simplifier.addPoint( QgsPoint( 0, 0 ) );
+  QCOMPARE( rawTrackLines().count(), 1 + 1 );
+
+  // finished track is kept under a timestamped name
+  simplifier.finishRawTrack();
+  QVERIFY( simplifier.rawTrackPath().isEmpty() );
+  QVERIFY( !QFile::exists( rawTrackPath ) );
+  const QDir rawTracksDir( tempDir.filePath( QStringLiteral( "raw_tracks" ) ) );
+  QCOMPARE( rawTracksDir.entryList( { QStringLiteral( "track_*.txt" ) }, QDir::Files ).count(), 1 );
+
+  // discarded track is removed
+  simplifier.setup( settings, crs, rawTrackPath );
+  simplifier.addPoint( QgsPoint( 0, 0 ) );
+  QVERIFY( QFile::exists( rawTrackPath ) );
+  simplifier.removeRawTrack();
+  QVERIFY( simplifier.rawTrackPath().isEmpty() );
+  QVERIFY( !QFile::exists( rawTrackPath ) );
+  QCOMPARE( rawTracksDir.entryList( QDir::Files ).count(), 1 );
+
+  // finished tracks expire
+  QFile expiredTrack( rawTracksDir.filePath( QStringLiteral( "track_20000101_000000.txt" ) ) );
+  QVERIFY( expiredTrack.open( QIODevice::WriteOnly ) );
+  QVERIFY( expiredTrack.setFileTime( QDateTime::currentDateTime().addDays( -TrackSimplifier::RAW_TRACK_RETENTION_DAYS - 1 ), QFileDevice::FileModificationTime ) );
+  expiredTrack.close();
+  simplifier.setup( settings, crs, rawTrackPath );
+  QVERIFY( !expiredTrack.exists() );
+  QCOMPARE( rawTracksDir.entryList( { QStringLiteral( "track_*.txt" ) }, QDir::Files ).count(), 1 );
+  simplifier.removeRawTrack();
+
+  // long straight track is split by the size of the window
+  settings.keepRawTrack = false;
+  simplifier.setup( settings, crs );
+  QVERIFY( simplifier.rawTrackPath().isEmpty() );
+
+  QgsPointSequence simplified;
+  for ( int i = 0; i <= TrackSimplifier::MAX_WINDOW_SIZE + 1; ++i )
+  {
+    simplified << simplifier.addPoint( QgsPoint( 10 * i, 0 ) );
+  }
+  QCOMPARE( simplified, QgsPointSequence() << QgsPoint( 0, 0 ) << QgsPoint( 10 * TrackSimplifier::MAX_WINDOW_SIZE, 0 ) );
+
+  // geographic coordinates - 0.00001 degree is about 1 m
+  simplifier.setup( settings, QgsCoordinateReferenceSystem::fromEpsgId( 4326 ) );
+  QCOMPARE( simplifier.addPoint( QgsPoint( 17.1, 48.1 ) ).count(), 1 );
+  QVERIFY( simplifier.addPoint( QgsPoint( 17.100005, 48.1 ) ).isEmpty() ); // stationary
+  QVERIFY( simplifier.addPoint( QgsPoint( 17.1001, 48.1 ) ).isEmpty() );
+  QCOMPARE( simplifier.flush(), QgsPointSequence() << QgsPoint( 17.1001, 48.1 ) );
+}
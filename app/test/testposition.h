@@ -38,6 +38,7 @@ class TestPosition: public QObject
 
     void testPositionTracking();
     void testPositionTrackingHighlight();
+    void testTrackSimplifier();
 
   private:
     PositionKit *positionKit;
@@ -136,3 +136,75 @@ void TestProjectChecksumCache::testFilesCheckum()
   QDateTime cacheModifiedTime3 = QFileInfo( cacheFilePath ).lastModified();
   QCOMPARE( cacheModifiedTime2, cacheModifiedTime3 );
 }
+
+void TestProjectChecksumCache::testMultipleInstances()
+{
+  QString projectName = QStringLiteral( "testMultipleInstances" );
+  QString projectDir = QDir::tempPath() + "/" + projectName;
+
+  InputUtils::cpDir( TestUtils::testDataDir() + "/planes", projectDir );
+  InputUtils::copyFile( TestUtils::testDataDir() + "/photo.jpg", projectDir + "/photo.jpg" );
+
+  QString cacheFilePath = projectDir + "/.mergin/checksum.cache";
+  InputUtils::removeFile( cacheFilePath );
+
+  {
+    // e.g. sync and background indexing working with the same project at the same time
+    ProjectChecksumCache cacheA( projectDir );
+    ProjectChecksumCache cacheB( projectDir );
+
+    QVERIFY( !cacheA.get( "lines.qml" ).isEmpty() );
+    QVERIFY( !cacheB.get( "photo.jpg" ).isEmpty() );
+
+    // B is saved first, A must not throw its entries away
+  }
+
+  ProjectChecksumCache cache( projectDir );
+  QCOMPARE( cache.mCache.count(), 2 );
+  QVERIFY( cache.mCache.contains( "lines.qml" ) );
+  QVERIFY( cache.mCache.contains( "photo.jpg" ) );
+  QCOMPARE( cache.mCache.value( "photo.jpg" ).checksum, QString( CoreUtils::calculateChecksum( projectDir + "/photo.jpg" ) ) );
+
+  {
+    // A has read the old entry of the file, B calculates the entry of its newer version
+    ProjectChecksumCache cacheA( projectDir );
+    QVERIFY( cacheA.mCache.contains( "lines.qml" ) );
+
+    QFile file( projectDir + "/lines.qml" );
+    QVERIFY( file.open( QIODevice::Append ) );
+    file.write( "<!-- changed -->" );
+    QVERIFY( file.setFileTime( QDateTime::currentDateTime().addSecs( 60 ), QFileDevice::FileModificationTime ) );
+    file.close();
+
+    {
+      ProjectChecksumCache cacheB( projectDir );
+      QVERIFY( !cacheB.get( "lines.qml" ).isEmpty() );
+    }
+
+    // A is saved last, its stale entry must not replace the newer one
+    QVERIFY( !cacheA.get( "photo.jpg" ).isEmpty() );
+    cacheA.mCacheModified = true;
+  }
+
+  ProjectChecksumCache mergedCache( projectDir );
+  QCOMPARE( mergedCache.mCache.value( "lines.qml" ).checksum, QString( CoreUtils::calculateChecksum( projectDir + "/lines.qml" ) ) );
+}
+
+void TestProjectChecksumCache::testCanceledChecksum()
+{
+  QString projectName = QStringLiteral( "testCanceledChecksum" );
+  QString projectDir = QDir::tempPath() + "/" + projectName;
+
+  InputUtils::copyFile( TestUtils::testDataDir() + "/TreeAutumn.png", projectDir + "/TreeAutumn.png" );
+
+  std::atomic_bool canceled( true );
+  QVERIFY( CoreUtils::calculateChecksum( projectDir + "/TreeAutumn.png", &canceled ).isEmpty() );
+
+  ProjectChecksumCache cache( projectDir );
+
+  // canceled checksum is not cached
+  QVERIFY( cache.get( "TreeAutumn.png", &canceled ).isEmpty() );
+
+  canceled = false;
+  QCOMPARE( cache.get( "TreeAutumn.png", &canceled ), QString( CoreUtils::calculateChecksum( projectDir + "/TreeAutumn.png" ) ) );
+}
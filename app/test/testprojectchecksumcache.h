@@ -24,6 +24,8 @@ class TestProjectChecksumCache : public QObject
     void cleanup();
 
     void testFilesCheckum();
+    void testMultipleInstances();
+    void testCanceledChecksum();
 };
 
 #endif // TESTPROJECTCHECKSUMCACHE_H
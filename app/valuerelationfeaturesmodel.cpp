@@ -16,6 +16,12 @@
 ValueRelationFeaturesModel::ValueRelationFeaturesModel( QObject *parent )
   : FeaturesModel( parent )
 {
+  // key index is rebuilt lazily on the next conversion once the rows change
+  auto markKeyRowsDirty = [this]() { mKeyRowsDirty = true; };
+  connect( this, &QAbstractItemModel::modelReset, this, markKeyRowsDirty );
+  connect( this, &QAbstractItemModel::rowsInserted, this, markKeyRowsDirty );
+  connect( this, &QAbstractItemModel::rowsRemoved, this, markKeyRowsDirty );
+  connect( this, &QAbstractItemModel::dataChanged, this, markKeyRowsDirty );
 }
 
 ValueRelationFeaturesModel::~ValueRelationFeaturesModel() = default;
@@ -70,6 +76,12 @@ void ValueRelationFeaturesModel::setup()
       mFilterExpression = mConfig.value( QStringLiteral( "FilterExpression" ) ).toString();
       FeaturesModel::setLayer( layer );
 
+      if ( mLookupTable )
+        disconnect( mLookupTable, nullptr, this, nullptr );
+      mLookupTable = LookupTable::forLayer( layer, mKeyField, mTitleField );
+      if ( mLookupTable )
+        connect( mLookupTable, &LookupTable::ready, this, &ValueRelationFeaturesModel::onLookupTableReady );
+
       mAllowMulti = mConfig.value( QStringLiteral( "AllowMulti" ) ).toBool();
       mIsInitialized = true;
     }
@@ -87,9 +99,65 @@ void ValueRelationFeaturesModel::reset()
   mPair = FeatureLayerPair();
   mConfig = QVariantMap();
   mIsInitialized = false;
+  mKeyRows.clear();
+  mKeyRowsDirty = true;
+  if ( mLookupTable )
+    disconnect( mLookupTable, nullptr, this, nullptr );
+  mLookupTable = nullptr;
+  mPopulatedFromLookupTable = false;
   FeaturesModel::reset();
 }
 
+void ValueRelationFeaturesModel::populate()
+{
+  LookupTable *table = usableLookupTable();
+  mPopulatedFromLookupTable = table;
+
+  if ( table )
+  {
+    const bool orderByValue = mConfig.value( QStringLiteral( "OrderByValue" ) ).toBool();
+    setFeatures( table->features( table->rows( mFilterExpression, orderByValue ) ), true );
+    return;
+  }
+
+  FeaturesModel::populate();
+}
+
+LookupTable *ValueRelationFeaturesModel::usableLookupTable() const
+{
+  if ( !mIsInitialized || !mLookupTable || !mLookupTable->isReady() || !searchExpression().isEmpty() )
+    return nullptr;
+
+  // filters depending on the edited feature have to be evaluated for each form
+  if ( QgsValueRelationFieldFormatter::expressionRequiresFormScope( mFilterExpression ) ||
+       QgsValueRelationFieldFormatter::expressionRequiresParentFormScope( mFilterExpression ) )
+    return nullptr;
+
+  return mLookupTable;
+}
+
+void ValueRelationFeaturesModel::onLookupTableReady()
+{
+  // table got rebuilt after the lookup layer changed
+  if ( mPopulatedFromLookupTable )
+    populate();
+}
+
+void ValueRelationFeaturesModel::updateKeyRows()
+{
+  if ( !mKeyRowsDirty )
+    return;
+
+  mKeyRows.clear();
+  const int rows = FeaturesModel::rowCount();
+  mKeyRows.reserve( rows );
+  for ( int row = 0; row < rows; ++row )
+  {
+    mKeyRows.insert( rowAttribute( row, mKeyField ).toString(), row );
+  }
+  mKeyRowsDirty = false;
+}
+
 QVariant ValueRelationFeaturesModel::featureTitle( const FeatureLayerPair &pair ) const
 {
   if ( !mTitleField.isEmpty() )
@@ -102,8 +170,11 @@ QVariant ValueRelationFeaturesModel::featureTitle( const FeatureLayerPair &pair
 
 QVariant ValueRelationFeaturesModel::convertToKey( const QVariant &id )
 {
-  QgsFeature f = FeaturesModel::convertRoleValue( FeaturesModel::FeatureId, id, Feature ).value<QgsFeature>();
-  return f.attribute( mKeyField );
+  const int row = FeaturesModel::rowFromRoleValue( FeaturesModel::FeatureId, id );
+  if ( row < 0 )
+    return QVariant();
+
+  return rowAttribute( row, mKeyField );
 }
 
 QVariant ValueRelationFeaturesModel::convertToQgisType( const QVariantList &featureIds )
@@ -146,28 +217,23 @@ QVariant ValueRelationFeaturesModel::convertFromQgisType( QVariant qgsValue, Mod
 
   QList<QVariant> roleList;
 
-  // optimize it a little bit
-  QMap<QVariant, QVariant> keyMap;
-  for ( const QString &key : keyList )
+  updateKeyRows();
+
+  QList<int> rows;
+  const QSet<QString> keys( keyList.constBegin(), keyList.constEnd() );
+  for ( const QString &key : keys )
   {
-    keyMap.insert( key, QLatin1String() );
+    rows << mKeyRows.values( key );
   }
 
-  for ( int ix = 0; ix < FeaturesModel::rowCount(); ++ix )
-  {
-    QgsFeature f = FeaturesModel::data( index( ix, 0 ), Feature ).value<QgsFeature>();
+  // keep the order of the model
+  std::sort( rows.begin(), rows.end() );
 
-    if ( keyMap.contains( f.attribute( mKeyField ).toString() ) )
-    {
-      if ( toRole == FeatureId )
-        roleList.append( f.id() );
-      else
-      {
-        QVariant attr = FeaturesModel::convertRoleValue( FeatureId, f.id(), toRole );
-        if ( !attr.isNull() )
-          roleList.append( attr );
-      }
-    }
+  for ( int row : std::as_const( rows ) )
+  {
+    QVariant attr = FeaturesModel::data( index( row, 0 ), toRole );
+    if ( !attr.isNull() )
+      roleList.append( attr );
   }
 
   if ( roleList.isEmpty() && !qgsValue.isNull() )
@@ -13,8 +13,10 @@
 #include "inputconfig.h"
 #include "featuresmodel.h"
 #include "featurelayerpair.h"
+#include "lookuptable.h"
 
 #include <QObject>
+#include <QPointer>
 
 
 /**
@@ -35,6 +37,7 @@ class ValueRelationFeaturesModel : public FeaturesModel
 
     void setup() override;
     void reset() override;
+    void populate() override;
     void setupFeatureRequest( QgsFeatureRequest &request ) override;
     QVariant featureTitle( const FeatureLayerPair &pair ) const override;
 
@@ -54,8 +57,19 @@ class ValueRelationFeaturesModel : public FeaturesModel
     void invalidate(); // invalidate signal is emitted when value to convert is not present in model
 
   private:
+    //! Rebuilds key -> rows index if the rows have changed since the last conversion
+    void updateKeyRows();
+
+    //! Returns the shared lookup table if it can serve the current filter and search, nullptr otherwise
+    LookupTable *usableLookupTable() const;
+
+    void onLookupTableReady();
+
     QMap<QVariant, QVariant> mCache;
 
+    QMultiHash<QString, int> mKeyRows; //!< key (as string) -> rows with that key
+    bool mKeyRowsDirty = true;
+
     QVariantMap mConfig;
     FeatureLayerPair mPair; // feature layer pair that has opened the form
 
@@ -65,6 +79,11 @@ class ValueRelationFeaturesModel : public FeaturesModel
     QString mFilterExpression;
 
     bool mIsInitialized = false; // model successfully read config and is ready to use
+
+    QPointer<LookupTable> mLookupTable;
+    bool mPopulatedFromLookupTable = false;
+
+    friend class TestModels;
 };
 
 #endif // VALUERELATIONFEATURESMODEL_H
@@ -1,5 +1,12 @@
 # GPLv2 Licence
 
+find_path(
+  ZLIB_INCLUDE_DIR
+  zlib.h
+  "${INPUT_SDK_PATH_MULTI}/include"
+  NO_DEFAULT_PATH
+)
+
 find_library(
   ZLIB_LIBRARY
   NAMES z zlib libz
@@ -7,11 +14,19 @@ find_library(
   NO_DEFAULT_PATH
 )
 
-find_package_handle_standard_args(ZLIB REQUIRED_VARS ZLIB_LIBRARY)
+find_package_handle_standard_args(ZLIB REQUIRED_VARS ZLIB_LIBRARY ZLIB_INCLUDE_DIR)
+
+if (ZLIB_FOUND)
+  set(ZLIB_INCLUDE_DIRS "${ZLIB_INCLUDE_DIR}")
+  set(ZLIB_LIBRARIES "${ZLIB_LIBRARY}")
+endif ()
 
 if (ZLIB_FOUND AND NOT TARGET ZLIB::ZLIB)
   add_library(ZLIB::ZLIB UNKNOWN IMPORTED)
-  set_target_properties(ZLIB::ZLIB PROPERTIES IMPORTED_LOCATION "${ZLIB_LIBRARY}")
+  set_target_properties(
+    ZLIB::ZLIB PROPERTIES IMPORTED_LOCATION "${ZLIB_LIBRARY}"
+                          INTERFACE_INCLUDE_DIRECTORIES "${ZLIB_INCLUDE_DIR}"
+  )
 endif ()
 
-mark_as_advanced(ZLIB_LIBRARY)
+mark_as_advanced(ZLIB_LIBRARY ZLIB_INCLUDE_DIR)
@@ -23,9 +23,13 @@
 #include <QStorageInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QFileInfo>
+#include <QSet>
 
 #include "qcoreapplication.h"
 
+#include <zlib.h>
+
 const QString CoreUtils::QSETTINGS_APP_GROUP_NAME = QStringLiteral( "inputApp" );
 const QString CoreUtils::LOG_TO_DEVNULL = QStringLiteral();
 const QString CoreUtils::LOG_TO_STDOUT = QStringLiteral( "TO_STDOUT" );
@@ -193,7 +197,7 @@ QString CoreUtils::findUniquePath( const QString &path )
   return uniquePath;
 }
 
-QByteArray CoreUtils::calculateChecksum( const QString &filePath )
+QByteArray CoreUtils::calculateChecksum( const QString &filePath, const std::atomic_bool *canceled )
 {
   QFile f( filePath );
   if ( f.open( QFile::ReadOnly ) )
@@ -202,6 +206,9 @@ QByteArray CoreUtils::calculateChecksum( const QString &filePath )
     QByteArray chunk = f.read( CHECKSUM_CHUNK_SIZE );
     while ( !chunk.isEmpty() )
     {
+      if ( canceled && *canceled )
+        return QByteArray();
+
       hash.addData( chunk );
       chunk = f.read( CHECKSUM_CHUNK_SIZE );
     }
@@ -263,6 +270,68 @@ bool CoreUtils::hasProjectFileExtension( const QString filePath )
   return filePath.contains( ".qgs", Qt::CaseInsensitive ) || filePath.contains( ".qgz", Qt::CaseInsensitive );
 }
 
+bool CoreUtils::hasCompressedFileExtension( const QString &filePath )
+{
+  static const QSet<QString> compressedSuffixes =
+  {
+    QStringLiteral( "jpg" ), QStringLiteral( "jpeg" ), QStringLiteral( "png" ), QStringLiteral( "webp" ),
+    QStringLiteral( "heic" ), QStringLiteral( "mbtiles" ), QStringLiteral( "mp3" ), QStringLiteral( "mp4" ),
+    QStringLiteral( "m4a" ), QStringLiteral( "zip" ), QStringLiteral( "gz" ), QStringLiteral( "qgz" )
+  };
+
+  return compressedSuffixes.contains( QFileInfo( filePath ).suffix().toLower() );
+}
+
+QByteArray CoreUtils::gzipCompress( const QByteArray &data )
+{
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+
+  // window bits 15 + 16 makes zlib write gzip header and trailer instead of the zlib ones
+  if ( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+    return QByteArray();
+
+  QByteArray output;
+  output.resize( static_cast<qsizetype>( deflateBound( &stream, static_cast<uLong>( data.size() ) ) ) );
+
+  stream.next_in = reinterpret_cast<Bytef *>( const_cast<char *>( data.constData() ) );
+  stream.avail_in = static_cast<uInt>( data.size() );
+  stream.next_out = reinterpret_cast<Bytef *>( output.data() );
+  stream.avail_out = static_cast<uInt>( output.size() );
+
+  int res = deflate( &stream, Z_FINISH );
+  deflateEnd( &stream );
+
+  if ( res != Z_STREAM_END )
+    return QByteArray();
+
+  output.resize( static_cast<qsizetype>( stream.total_out ) );
+  return output;
+}
+
+bool CoreUtils::acceptsContentCoding( const QByteArray &acceptEncoding, const QByteArray &coding )
+{
+  const QList<QByteArray> codings = acceptEncoding.split( ',' );
+  for ( const QByteArray &entry : codings )
+  {
+    const QList<QByteArray> params = entry.split( ';' );
+    if ( params.first().trimmed().toLower() != coding.toLower() )
+      continue;
+
+    // "q=0" explicitly rejects the coding
+    for ( int i = 1; i < params.size(); ++i )
+    {
+      const QByteArray param = params.at( i ).trimmed().toLower();
+      if ( param.startsWith( "q=" ) && param.mid( 2 ).toDouble() <= 0 )
+        return false;
+    }
+    return true;
+  }
+  return false;
+}
+
 bool CoreUtils::isValidName( const QString &name )
 {
   static QRegularExpression reForbiddenmNames( R"([@#$%^&*\(\)\{\}\[\]\\\/\|\+=<>~\?:;,`\'\"]|^[\s^\.].*$|^CON$|^PRN$|^AUX$|^NUL$|^COM\d$|^LPT\d|^support$|^helpdesk$|^merginmaps$|^lutraconsulting$|^mergin$|^lutra$|^input$|^sales$|^admin$)", QRegularExpression::CaseInsensitiveOption );
@@ -17,6 +17,8 @@
 #include <QtGlobal>
 #include <QUuid>
 
+#include <atomic>
+
 
 class CoreUtils
 {
@@ -43,8 +45,9 @@ class CoreUtils
      * Returns Sha1 checksum of file (no-caching)
      * This is potentially resourcing-costly operation
      * \param filePath full path to the file on disk
+     * \param canceled when set, it is checked between the chunks of the file and empty checksum is returned once it is true
      */
-    static QByteArray calculateChecksum( const QString &filePath );
+    static QByteArray calculateChecksum( const QString &filePath, const std::atomic_bool *canceled = nullptr );
 
     /**
     * Returns given path if it does not exist yet, otherwise adds a number to the path in format:
@@ -88,6 +91,24 @@ class CoreUtils
     //! Checks whether file path has a QGIS project suffix (qgs or qgz)
     static bool hasProjectFileExtension( const QString filePath );
 
+    /**
+     * Checks whether the file is stored in an already compressed format (e.g. jpg, png, mbtiles),
+     * so there is no point in compressing it again for the transport
+     */
+    static bool hasCompressedFileExtension( const QString &filePath );
+
+    /**
+     * Compresses data to the gzip format (RFC 1952), suitable for "Content-Encoding: gzip"
+     * Returns empty array on failure
+     */
+    static QByteArray gzipCompress( const QByteArray &data );
+
+    /**
+     * Checks whether the Accept-Encoding header value (e.g. "gzip, br;q=0.5") allows the content \a coding.
+     * Servers list the codings they accept in requests this way in their responses (RFC 7694)
+     */
+    static bool acceptsContentCoding( const QByteArray &acceptEncoding, const QByteArray &coding );
+
     /**
      * Check whether given project/user name is valid
      */
@@ -60,6 +60,27 @@ GEODIFF_ContextH GeodiffContext::handle() const
   return mHandle;
 }
 
+//! Log messages of the geodiff context used by the current worker thread (see createChangesetInWorker())
+static thread_local QStringList *sWorkerLogMessages = nullptr;
+
+static QString logPrefix( GEODIFF_LoggerLevel level )
+{
+  switch ( level )
+  {
+    case LevelError: return QStringLiteral( "GEODIFF error" );
+    case LevelWarning: return QStringLiteral( "GEODIFF warning" );
+    case LevelInfo: return QStringLiteral( "GEODIFF info" );
+    case LevelDebug: return QStringLiteral( "GEODIFF debug" );
+    default: return QString();
+  }
+}
+
+static void logWorker( GEODIFF_LoggerLevel level, const char *msg )
+{
+  if ( sWorkerLogMessages )
+    sWorkerLogMessages->append( QStringLiteral( "%1: %2" ).arg( logPrefix( level ), QString::fromUtf8( msg ) ) );
+}
+
 void GeodiffUtils::init()
 {
   Q_UNUSED( GeodiffContext::instance() );
@@ -99,14 +120,39 @@ QString GeodiffUtils::diffableFilePendingChanges( const QString &projectDir, con
 }
 
 
-int GeodiffUtils::createChangeset( const QString &projectDir, const QString &fileName, QString &diffName )
+QString GeodiffUtils::diffFileName( const QString &fileName )
 {
   QString uuid = CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
-  diffName = fileName + "-diff-" + uuid;
+  return fileName + "-diff-" + uuid;
+}
+
+static int createChangesetInContext( GEODIFF_ContextH context, const QString &projectDir, const QString &fileName, const QString &diffName )
+{
   QString modifiedAbsPath = projectDir + "/" + fileName;
   QString baseAbsPath = projectDir + "/.mergin/" + fileName;
   QString diffAbsPath = projectDir + "/.mergin/" + diffName;
-  return GEODIFF_createChangeset( GeodiffContext::instance().handle(), baseAbsPath.toUtf8(), modifiedAbsPath.toUtf8(), diffAbsPath.toUtf8() );
+  return GEODIFF_createChangeset( context, baseAbsPath.toUtf8(), modifiedAbsPath.toUtf8(), diffAbsPath.toUtf8() );
+}
+
+int GeodiffUtils::createChangeset( const QString &projectDir, const QString &fileName, QString &diffName )
+{
+  diffName = diffFileName( fileName );
+  return createChangesetInContext( GeodiffContext::instance().handle(), projectDir, fileName, diffName );
+}
+
+int GeodiffUtils::createChangesetInWorker( const QString &projectDir, const QString &fileName, const QString &diffName, QStringList &logMessages )
+{
+  // the shared context is not meant to be used from several threads at once
+  GEODIFF_ContextH context = GEODIFF_createContext();
+  GEODIFF_CX_setLoggerCallback( context, &logWorker );
+  GEODIFF_CX_setMaximumLoggerLevel( context, GEODIFF_LoggerLevel::LevelDebug );
+
+  sWorkerLogMessages = &logMessages;
+  int res = createChangesetInContext( context, projectDir, fileName, diffName );
+  sWorkerLogMessages = nullptr;
+
+  GEODIFF_CX_destroy( context );
+  return res;
 }
 
 bool GeodiffUtils::hasPendingChanges( const QString &projectDir, const QString &filePath )
@@ -176,14 +222,5 @@ bool GeodiffUtils::rebase( const QString &base, const QString &modified_their, c
 
 void GeodiffUtils::log( GEODIFF_LoggerLevel level, const char *msg )
 {
-  QString prefix;
-  switch ( level )
-  {
-    case LevelError: prefix = "GEODIFF error"; break;
-    case LevelWarning: prefix = "GEODIFF warning"; break;
-    case LevelInfo: prefix = "GEODIFF info"; break;
-    case LevelDebug: prefix = "GEODIFF debug"; break;
-    default: break;
-  }
-  CoreUtils::log( prefix, msg );
+  CoreUtils::log( logPrefix( level ), msg );
 }
@@ -12,6 +12,7 @@
 
 #include <QMap>
 #include <QString>
+#include <QStringList>
 
 #include <geodiff.h>
 
@@ -57,6 +58,17 @@ class GeodiffUtils
      */
     static int createChangeset( const QString &projectDir, const QString &fileName, QString &diffName );
 
+    //! Returns name of a new diff file of \a fileName (RELATIVE to "projectDir/.mergin/" DIR)
+    static QString diffFileName( const QString &fileName );
+
+    /**
+     * Same as createChangeset() writing to the given \a diffName, but safe to call from worker threads.
+     * Geodiff runs in its own context and its log messages are returned in \a logMessages instead
+     * of being written to the log, so that the caller can log them from the main thread.
+     * \returns geodiff return value - zero on success
+     */
+    static int createChangesetInWorker( const QString &projectDir, const QString &fileName, const QString &diffName, QStringList &logMessages );
+
     //! Takes "src" file and applies a sequence of changesets for the list in "diffFiles"
     static bool applyDiffs( const QString &src, const QStringList &diffFiles );
 
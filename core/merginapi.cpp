@@ -19,6 +19,8 @@
 #include <QUuid>
 #include <QtMath>
 #include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QStandardPaths>
 
 #include "projectchecksumcache.h"
 #include "coreutils.h"
@@ -50,6 +52,7 @@ MerginApi::MerginApi( LocalProjectsManager &localProjects, QObject *parent )
   , mSubscriptionInfo( new MerginSubscriptionInfo )
   , mUserAuth( new MerginUserAuth )
   , mManager( new QNetworkAccessManager( this ) )
+  , mProjectsListCache( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + QStringLiteral( "/projects_list" ) )
 {
   // load cached data if there are any
   QSettings cache;
@@ -65,6 +68,8 @@ MerginApi::MerginApi( LocalProjectsManager &localProjects, QObject *parent )
 
   qRegisterMetaType<Transactions>();
 
+  mNetworkTimer.start();
+
   QObject::connect( this, &MerginApi::authChanged, this, &MerginApi::saveAuthData );
   QObject::connect( this, &MerginApi::apiRootChanged, this, &MerginApi::pingMergin );
   QObject::connect( this, &MerginApi::apiRootChanged, this, &MerginApi::getServerConfig );
@@ -200,6 +205,23 @@ QString MerginApi::listProjects( const QString &searchExpression, const QString
 
   QString requestId = CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
 
+  QString cacheKey = projectsListCacheKey( url.toString() );
+  request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrCacheKey ), cacheKey );
+
+  MerginProjectsListCache::Entry cached = mProjectsListCache.get( cacheKey );
+  if ( cached.isValid() )
+  {
+    setConditionalRequestHeaders( request, cached );
+
+    // show the last known listing right away, the caller needs to get request id first though
+    QTimer::singleShot( 0, this, [this, cached, page, requestId]()
+    {
+      QJsonDocument doc = QJsonDocument::fromJson( cached.data );
+      int projectCount = doc.isObject() ? doc.object().value( "count" ).toInt() : -1;
+      emit listProjectsLoadedFromCache( parseProjectsFromJson( doc ), projectCount, page, requestId );
+    } );
+  }
+
   QNetworkReply *reply = mManager->get( request );
   CoreUtils::log( "list projects", QStringLiteral( "Requesting: " ) + url.toString() );
   connect( reply, &QNetworkReply::finished, this, [this, requestId]() {this->listProjectsReplyFinished( requestId );} );
@@ -249,6 +271,22 @@ QString MerginApi::listProjectsByName( const QStringList &projectNames )
 
   QString requestId = CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
 
+  QStringList sortedNames = projectNamesToRequest;
+  sortedNames.sort();
+  QString cacheKey = projectsListCacheKey( url.toString() + "?" + sortedNames.join( "," ) );
+  request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrCacheKey ), cacheKey );
+
+  MerginProjectsListCache::Entry cached = mProjectsListCache.get( cacheKey );
+  if ( cached.isValid() )
+  {
+    setConditionalRequestHeaders( request, cached );
+
+    QTimer::singleShot( 0, this, [this, cached, requestId]()
+    {
+      emit listProjectsByNameLoadedFromCache( parseProjectsFromJson( QJsonDocument::fromJson( cached.data ) ), requestId );
+    } );
+  }
+
   QNetworkReply *reply = mManager->post( request, body.toJson() );
   CoreUtils::log( "list projects by name", QStringLiteral( "Requesting: " ) + url.toString() );
   connect( reply, &QNetworkReply::finished, this, [this, requestId]() {this->listProjectsByNameReplyFinished( requestId );} );
@@ -287,7 +325,21 @@ void MerginApi::downloadNextItem( const QString &projectFullName )
     request.setRawHeader( "Range", range.toUtf8() );
   }
 
+  if ( CoreUtils::hasCompressedFileExtension( item.filePath ) && !item.downloadDiff )
+  {
+    // media are already compressed, do not let the server spend time on compressing them again.
+    // Other items (diffs, project files, ...) use transport compression negotiated by the network manager
+    request.setRawHeader( "Accept-Encoding", "identity" );
+  }
+
+  // (re)create the temporary file, the content is streamed to it as it arrives
+  QString tempFilePath = getTempProjectDir( projectFullName ) + "/" + item.tempFileName;
+  createPathIfNotExists( tempFilePath );
+  QFile::remove( tempFilePath );
+
   QNetworkReply *reply = mManager->get( request );
+  startRequestTiming( reply );
+  connect( reply, &QNetworkReply::readyRead, this, [reply, tempFilePath]() { writeDownloadedData( reply, tempFilePath ); } );
   connect( reply, &QNetworkReply::finished, this, [this, item]() { downloadItemReplyFinished( item ); } );
 
   transaction.replyPullItems.insert( reply );
@@ -296,6 +348,24 @@ void MerginApi::downloadNextItem( const QString &projectFullName )
                   ( !range.isEmpty() ? " Range: " + range : QString() ) );
 }
 
+bool MerginApi::writeDownloadedData( QNetworkReply *reply, const QString &tempFilePath )
+{
+  // error replies carry server message in the body, keep it in the reply for later processing
+  int httpCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+  if ( httpCode < 200 || httpCode >= 300 )
+    return true;
+
+  // the network manager already decompressed the content if it was transport-compressed,
+  // so we can stream it to the disk without keeping the whole item in memory
+  QFile file( tempFilePath );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Append ) )
+    return false;
+
+  file.write( reply->readAll() );
+  file.close();
+  return true;
+}
+
 void MerginApi::removeProjectsTempFolder( const QString &projectNamespace, const QString &projectName )
 {
   if ( projectNamespace.isEmpty() || projectName.isEmpty() )
@@ -318,6 +388,56 @@ QNetworkRequest MerginApi::getDefaultRequest( bool withAuth )
   return request;
 }
 
+void MerginApi::warmUpConnection()
+{
+  QUrl url( mApiRoot );
+  if ( !url.isValid() || url.host().isEmpty() )
+    return;
+
+  // connections are kept alive by the network manager, so the requests of the transaction will reuse this one
+  if ( url.scheme() == QStringLiteral( "https" ) )
+    mManager->connectToHostEncrypted( url.host(), url.port( 443 ), warmUpSslConfiguration() );
+  else
+    mManager->connectToHost( url.host(), url.port( 80 ) );
+}
+
+QSslConfiguration MerginApi::warmUpSslConfiguration()
+{
+  // Mergin requests go through our own network manager, the HTTP/1 workaround for QGIS requests (see main.cpp)
+  // does not apply here. The connection is only reused by the (HTTP/2 allowed) requests if h2 is negotiated,
+  // HTTP/2 then lets the parallel pull requests share a single multiplexed connection
+  QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+  config.setAllowedNextProtocols( { QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1 } );
+  return config;
+}
+
+void MerginApi::startRequestTiming( QNetworkReply *reply )
+{
+  reply->setProperty( "requestStartedMs", mNetworkTimer.elapsed() );
+  connect( reply, &QNetworkReply::metaDataChanged, this, [this, reply]()
+  {
+    if ( !reply->property( "headersReceivedMs" ).isValid() )
+      reply->setProperty( "headersReceivedMs", mNetworkTimer.elapsed() );
+  } );
+}
+
+void MerginApi::recordRequestTiming( TransactionStatus &transaction, QNetworkReply *reply )
+{
+  const QVariant started = reply->property( "requestStartedMs" );
+  if ( !started.isValid() )
+    return;
+
+  const qint64 finishedMs = mNetworkTimer.elapsed();
+  const qint64 headersMs = reply->property( "headersReceivedMs" ).isValid() ? reply->property( "headersReceivedMs" ).toLongLong() : finishedMs;
+
+  transaction.requestCount++;
+  transaction.requestSetupMs += headersMs - started.toLongLong();
+  transaction.requestTransferMs += finishedMs - headersMs;
+
+  if ( reply->attribute( QNetworkRequest::Http2WasUsedAttribute ).toBool() )
+    transaction.http2Used = true;
+}
+
 bool MerginApi::projectFileHasBeenUpdated( const ProjectDiff &diff )
 {
   for ( QString filePath : diff.remoteAdded )
@@ -387,23 +507,18 @@ void MerginApi::downloadItemReplyFinished( DownloadQueueItem item )
 
   if ( r->error() == QNetworkReply::NoError )
   {
-    QByteArray data = r->readAll();
-    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Downloaded item (%1 bytes)" ).arg( data.size() ) );
     QString tempFolder = getTempProjectDir( projectFullName );
     QString tempFilePath = tempFolder + "/" + tempFileName;
-    createPathIfNotExists( tempFilePath );
-    // save to a tmp file, assemble at the end
-    QFile file( tempFilePath );
-    if ( file.open( QIODevice::WriteOnly ) )
-    {
-      file.write( data );
-      file.close();
-    }
-    else
+    // save the rest of the data to a tmp file, assemble at the end
+    if ( !writeDownloadedData( r, tempFilePath ) )
     {
-      CoreUtils::log( "pull " + projectFullName, "Failed to open for writing: " + file.fileName() );
+      CoreUtils::log( "pull " + projectFullName, "Failed to open for writing: " + tempFilePath );
     }
-    transaction.transferedSize += data.size();
+
+    qint64 size = QFileInfo( tempFilePath ).size();
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Downloaded item (%1 bytes)" ).arg( size ) );
+    recordRequestTiming( transaction, r );
+    transaction.transferedSize += size;
     emit syncProjectStatusChanged( projectFullName, transaction.transferedSize / transaction.totalSize );
     transaction.replyPullItems.remove( r );
 
@@ -411,8 +526,12 @@ void MerginApi::downloadItemReplyFinished( DownloadQueueItem item )
 
     if ( !transaction.downloadQueue.isEmpty() )
     {
-      // one request finished, let's start another one
-      downloadNextItem( projectFullName );
+      // one request finished, let's start another one (or more if the connection turned out to be multiplexed)
+      const int maxParallelDownloads = transaction.maxParallelDownloads();
+      while ( transaction.replyPullItems.count() < maxParallelDownloads && !transaction.downloadQueue.isEmpty() )
+      {
+        downloadNextItem( projectFullName );
+      }
     }
 
     else if ( transaction.replyPullItems.isEmpty() )
@@ -574,8 +693,20 @@ void MerginApi::pushFile( const QString &projectFullName, const QString &transac
   request.setRawHeader( "Content-Type", "application/octet-stream" );
   request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ), projectFullName );
 
+  if ( transaction.compressedUploads && !CoreUtils::hasCompressedFileExtension( file.path ) )
+  {
+    QByteArray compressed = CoreUtils::gzipCompress( data );
+    if ( !compressed.isEmpty() && compressed.size() < data.size() )
+    {
+      CoreUtils::log( "push " + projectFullName, QStringLiteral( "Compressed chunk from %1 to %2 bytes" ).arg( data.size() ).arg( compressed.size() ) );
+      data = compressed;
+      request.setRawHeader( "Content-Encoding", "gzip" );
+    }
+  }
+
   Q_ASSERT( !transaction.replyPushFile );
   transaction.replyPushFile = mManager->post( request, data );
+  startRequestTiming( transaction.replyPushFile );
   connect( transaction.replyPushFile, &QNetworkReply::finished, this, &MerginApi::pushFileReplyFinished );
 
   CoreUtils::log( "push " + projectFullName, QStringLiteral( "Uploading item: " ) + url.toString() );
@@ -624,6 +755,11 @@ void MerginApi::cancelPush( const QString &projectFullName )
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting project info request" ) );
     transaction.replyPushProjectInfo->abort();  // will trigger uploadInfoReplyFinished slot and emit sync finished
   }
+  else if ( transaction.pushDiffWatcher )
+  {
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting preparation of diffs" ) );
+    transaction.pushDiffWatcher->cancel();  // will trigger pushDiffsPrepared and emit sync finished
+  }
   else if ( transaction.replyPushStart )
   {
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting upload start" ) );
@@ -728,6 +864,8 @@ bool MerginApi::pullProject( const QString &projectNamespace, const QString &pro
 
   CoreUtils::log( "pull " + projectFullName, "### Starting ###" );
 
+  warmUpConnection();
+
   QNetworkReply *reply = getProjectInfo( projectFullName, withAuth );
   if ( reply )
   {
@@ -759,6 +897,8 @@ bool MerginApi::pushProject( const QString &projectNamespace, const QString &pro
 
   CoreUtils::log( "push " + projectFullName, "### Starting ###" );
 
+  warmUpConnection();
+
   QNetworkReply *reply = getProjectInfo( projectFullName );
   if ( reply )
   {
@@ -1057,6 +1197,7 @@ void MerginApi::getServiceInfoReplyFinished()
 
 void MerginApi::clearAuth()
 {
+  mProjectsListCache.clear();
   mUserAuth->clear();
   mUserInfo->clear();
   mUserInfo->clearCachedWorkspacesInfo();
@@ -1765,12 +1906,12 @@ void MerginApi::listProjectsReplyFinished( QString requestId )
   int requestedPage = 1;
   MerginProjectsList projectList;
 
+  QUrlQuery query( r->request().url().query() );
+  requestedPage = query.queryItemValue( "page" ).toInt();
+
   if ( r->error() == QNetworkReply::NoError )
   {
-    QUrlQuery query( r->request().url().query() );
-    requestedPage = query.queryItemValue( "page" ).toInt();
-
-    QByteArray data = r->readAll();
+    QByteArray data = readProjectsListReply( r );
     QJsonDocument doc = QJsonDocument::fromJson( data );
 
     if ( doc.isObject() )
@@ -1789,6 +1930,15 @@ void MerginApi::listProjectsReplyFinished( QString requestId )
     CoreUtils::log( "list projects", QStringLiteral( "FAILED - %1" ).arg( message ) );
 
     emit listProjectsFailed();
+
+    // keep showing the last known listing (e.g. when offline)
+    QString cacheKey = r->request().attribute( static_cast<QNetworkRequest::Attribute>( AttrCacheKey ) ).toString();
+    QJsonDocument doc = QJsonDocument::fromJson( mProjectsListCache.get( cacheKey ).data );
+    if ( doc.isObject() )
+    {
+      projectCount = doc.object().value( "count" ).toInt();
+      projectList = parseProjectsFromJson( doc );
+    }
   }
 
   r->deleteLater();
@@ -1796,6 +1946,40 @@ void MerginApi::listProjectsReplyFinished( QString requestId )
   emit listProjectsFinished( projectList, projectCount, requestedPage, requestId );
 }
 
+QString MerginApi::projectsListCacheKey( const QString &requestUrl ) const
+{
+  // listings differ per user (e.g. private projects), the url contains workspace, search expression and page
+  return mUserAuth->username() + "@" + requestUrl;
+}
+
+void MerginApi::setConditionalRequestHeaders( QNetworkRequest &request, const MerginProjectsListCache::Entry &cached )
+{
+  if ( !cached.etag.isEmpty() )
+    request.setRawHeader( "If-None-Match", cached.etag );
+  if ( !cached.lastModified.isEmpty() )
+    request.setRawHeader( "If-Modified-Since", cached.lastModified );
+}
+
+QByteArray MerginApi::readProjectsListReply( QNetworkReply *reply )
+{
+  QString cacheKey = reply->request().attribute( static_cast<QNetworkRequest::Attribute>( AttrCacheKey ) ).toString();
+  int httpCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+
+  if ( httpCode == 304 )
+  {
+    // listing has not changed since we cached it
+    return mProjectsListCache.get( cacheKey ).data;
+  }
+
+  MerginProjectsListCache::Entry entry;
+  entry.data = reply->readAll();
+  entry.etag = reply->rawHeader( "ETag" );
+  entry.lastModified = reply->rawHeader( "Last-Modified" );
+  mProjectsListCache.store( cacheKey, entry );
+
+  return entry.data;
+}
+
 void MerginApi::listProjectsByNameReplyFinished( QString requestId )
 {
   QNetworkReply *r = qobject_cast<QNetworkReply *>( sender() );
@@ -1805,7 +1989,7 @@ void MerginApi::listProjectsByNameReplyFinished( QString requestId )
 
   if ( r->error() == QNetworkReply::NoError )
   {
-    QByteArray data = r->readAll();
+    QByteArray data = readProjectsListReply( r );
     QJsonDocument json = QJsonDocument::fromJson( data );
     projectList = parseProjectsFromJson( json );
     CoreUtils::log( "list projects by name", QStringLiteral( "Success - got %1 projects" ).arg( projectList.count() ) );
@@ -1818,6 +2002,10 @@ void MerginApi::listProjectsByNameReplyFinished( QString requestId )
     CoreUtils::log( "list projects by name", QStringLiteral( "FAILED - %1" ).arg( message ) );
 
     emit listProjectsFailed();
+
+    // keep showing the last known listing (e.g. when offline)
+    QString cacheKey = r->request().attribute( static_cast<QNetworkRequest::Attribute>( AttrCacheKey ) ).toString();
+    projectList = parseProjectsFromJson( QJsonDocument::fromJson( mProjectsListCache.get( cacheKey ).data ) );
   }
 
   r->deleteLater();
@@ -2077,6 +2265,9 @@ void MerginApi::pushStartReplyFinished()
   {
     QByteArray data = r->readAll();
 
+    // servers accepting gzip-encoded request bodies list it in Accept-Encoding of their responses (RFC 7694)
+    transaction.compressedUploads = CoreUtils::acceptsContentCoding( r->rawHeader( "Accept-Encoding" ), "gzip" );
+
     transaction.replyPushStart->deleteLater();
     transaction.replyPushStart = nullptr;
 
@@ -2180,6 +2371,7 @@ void MerginApi::pushFileReplyFinished()
   if ( r->error() == QNetworkReply::NoError )
   {
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "Uploaded successfully: " ) + chunkID );
+    recordRequestTiming( transaction, r );
 
     transaction.replyPushFile->deleteLater();
     transaction.replyPushFile = nullptr;
@@ -2208,6 +2400,18 @@ void MerginApi::pushFileReplyFinished()
       }
     }
   }
+  else if ( transaction.compressedUploads && r->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt() == 415 )
+  {
+    // the server does not accept the encoded chunk after all, send it again without compression
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Compressed upload rejected, uploading uncompressed: " ) + chunkID );
+    transaction.compressedUploads = false;
+
+    transaction.replyPushFile->deleteLater();
+    transaction.replyPushFile = nullptr;
+
+    MerginFile currentFile = transaction.pushQueue.first();
+    pushFile( projectFullName, transactionUUID, currentFile, currentFile.chunks.indexOf( chunkID ) );
+  }
   else
   {
     QString serverMsg = extractServerErrorMsg( r->readAll() );
@@ -2242,6 +2446,9 @@ void MerginApi::pullInfoReplyFinished()
     QByteArray data = r->readAll();
     CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Downloaded project info." ) );
 
+    // the file requests will go through the same connection, if it is multiplexed we can run more of them at once
+    transaction.http2Used = r->attribute( QNetworkRequest::Http2WasUsedAttribute ).toBool();
+
     transaction.replyPullProjectInfo->deleteLater();
     transaction.replyPullProjectInfo = nullptr;
 
@@ -2445,7 +2652,8 @@ void MerginApi::startProjectPull( const QString &projectFullName )
   }
   else
   {
-    while ( transaction.replyPullItems.count() < 5 && !transaction.downloadQueue.isEmpty() )
+    const int maxParallelDownloads = transaction.maxParallelDownloads();
+    while ( transaction.replyPullItems.count() < maxParallelDownloads && !transaction.downloadQueue.isEmpty() )
     {
       downloadNextItem( projectFullName );
     }
@@ -2669,9 +2877,8 @@ void MerginApi::pushInfoReplyFinished()
 
     // TODO: make sure there are no remote files to add/update/remove nor conflicts
 
-    QList<MerginFile> filesToUpload;
     QList<MerginFile> addedMerginFiles, updatedMerginFiles, deletedMerginFiles;
-    QList<MerginFile> diffFiles;
+    QList<PushDiffPreparation> pendingDiffs;
     for ( QString filePath : transaction.diff.localAdded )
     {
       MerginFile merginFile = findFile( filePath, localFiles );
@@ -2686,35 +2893,12 @@ void MerginApi::pushInfoReplyFinished()
 
       if ( MerginApi::isFileDiffable( filePath ) )
       {
-        // try to create a diff
-        QString diffName;
-        int geodiffRes = GeodiffUtils::createChangeset( transaction.projectDir, filePath, diffName );
-        QString diffPath = transaction.projectDir + "/.mergin/" + diffName;
-        QString basePath = transaction.projectDir + "/.mergin/" + filePath;
-
-        if ( geodiffRes == GEODIFF_SUCCESS )
-        {
-          QByteArray checksumDiff = CoreUtils::calculateChecksum( diffPath );
-
-          // TODO: this is ugly. our basefile may not need to have the same checksum as the server's
-          // basefile (because each of them have applied the diff independently) so we have to fake it
-          QByteArray checksumBase = serverProject.fileInfo( filePath ).checksum.toLatin1();
-
-          merginFile.diffName = diffName;
-          merginFile.diffChecksum = QString::fromLatin1( checksumDiff.data(), checksumDiff.size() );
-          merginFile.diffSize = QFileInfo( diffPath ).size();
-          merginFile.chunks = generateChunkIdsForSize( merginFile.diffSize );
-          merginFile.diffBaseChecksum = QString::fromLatin1( checksumBase.data(), checksumBase.size() );
-
-          diffFiles.append( merginFile );
-
-          CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 successful: total size %2 bytes" ).arg( filePath ).arg( merginFile.diffSize ) );
-        }
-        else
-        {
-          // TODO: remove the diff file (if exists)
-          CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 FAILED with error %2 (will do full upload)" ).arg( filePath ).arg( geodiffRes ) );
-        }
+        // try to create a diff (later, in the thread pool), the name is known upfront
+        // so that the diff file can be removed if the preparation gets canceled
+        PushDiffPreparation pendingDiff;
+        pendingDiff.filePath = filePath;
+        pendingDiff.diffName = GeodiffUtils::diffFileName( filePath );
+        pendingDiffs.append( pendingDiff );
       }
 
       updatedMerginFiles.append( merginFile );
@@ -2736,44 +2920,22 @@ void MerginApi::pushInfoReplyFinished()
       return;
     }
 
-    QJsonArray added = prepareUploadChangesJSON( addedMerginFiles );
-    filesToUpload.append( addedMerginFiles );
-
-    QJsonArray modified = prepareUploadChangesJSON( updatedMerginFiles );
-    filesToUpload.append( updatedMerginFiles );
-
-    QJsonArray removed = prepareUploadChangesJSON( deletedMerginFiles );
-    // removed not in filesToUpload
+    // changesets of individual files do not depend on each other, so let's create them
+    // (and calculate their checksums) in parallel and send push start once all are ready
+    QFutureWatcher<PushDiffPreparation> *watcher = new QFutureWatcher<PushDiffPreparation>( this );
+    transaction.pushDiffWatcher = watcher;
 
-    QJsonObject changes;
-    changes.insert( "added", added );
-    changes.insert( "removed", removed );
-    changes.insert( "updated", modified );
-    changes.insert( "renamed", QJsonArray() );
-
-    qint64 totalSize = 0;
-    for ( MerginFile file : filesToUpload )
+    connect( watcher, &QFutureWatcher<PushDiffPreparation>::finished, this,
+             [this, projectFullName, serverProject, addedMerginFiles, updatedMerginFiles, deletedMerginFiles, pendingDiffs]()
     {
-      if ( !file.diffName.isEmpty() )
-        totalSize += file.diffSize;
-      else
-        totalSize += file.size;
-    }
-
-    CoreUtils::log( "push " + projectFullName, QStringLiteral( "%1 items to upload (total size %2 bytes)" )
-                    .arg( filesToUpload.count() ).arg( totalSize ) );
-
-    transaction.totalSize = totalSize;
-    transaction.pushQueue = filesToUpload;
-    transaction.pushDiffFiles = diffFiles;
+      pushDiffsPrepared( projectFullName, serverProject, addedMerginFiles, updatedMerginFiles, deletedMerginFiles, pendingDiffs );
+    } );
 
-    QJsonObject json;
-    json.insert( QStringLiteral( "changes" ), changes );
-    json.insert( QStringLiteral( "version" ), QString( "v%1" ).arg( serverProject.version ) );
-    QJsonDocument jsonDoc;
-    jsonDoc.setObject( json );
-
-    pushStart( projectFullName, jsonDoc.toJson( QJsonDocument::Compact ) );
+    const QString projectDir = transaction.projectDir;
+    watcher->setFuture( QtConcurrent::mapped( pendingDiffs, [projectDir]( const PushDiffPreparation & pendingDiff )
+    {
+      return preparePushDiff( projectDir, pendingDiff );
+    } ) );
   }
   else
   {
@@ -2794,6 +2956,134 @@ void MerginApi::pushInfoReplyFinished()
   }
 }
 
+PushDiffPreparation MerginApi::preparePushDiff( const QString &projectDir, PushDiffPreparation prepared )
+{
+  PushDiffPreparation result = prepared;
+  result.geodiffResult = GeodiffUtils::createChangesetInWorker( projectDir, result.filePath, result.diffName, result.geodiffLog );
+
+  if ( result.geodiffResult == GEODIFF_SUCCESS )
+  {
+    QString diffPath = projectDir + "/.mergin/" + result.diffName;
+    QByteArray checksumDiff = CoreUtils::calculateChecksum( diffPath );
+    result.diffChecksum = QString::fromLatin1( checksumDiff.data(), checksumDiff.size() );
+    result.diffSize = QFileInfo( diffPath ).size();
+  }
+
+  return result;
+}
+
+void MerginApi::pushDiffsPrepared( const QString &projectFullName, const MerginProjectMetadata &serverProject,
+                                   const QList<MerginFile> &addedMerginFiles, QList<MerginFile> updatedMerginFiles,
+                                   const QList<MerginFile> &deletedMerginFiles, const QList<PushDiffPreparation> &pendingDiffs )
+{
+  if ( !mTransactionalStatus.contains( projectFullName ) )
+    return;
+
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+  QFutureWatcher<PushDiffPreparation> *watcher = transaction.pushDiffWatcher;
+  Q_ASSERT( watcher );
+
+  transaction.pushDiffWatcher = nullptr;
+  watcher->deleteLater();
+
+  if ( watcher->isCanceled() )
+  {
+    // results of the canceled future are not reliable, remove any diff which may have been created
+    for ( const PushDiffPreparation &pendingDiff : pendingDiffs )
+    {
+      QFile::remove( transaction.projectDir + "/.mergin/" + pendingDiff.diffName );
+    }
+
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "FAILED - preparation of diffs canceled" ) );
+    emit networkErrorOccurred( sSyncCanceledMessage, QStringLiteral( "Mergin API error: pushInfo" ), 0, projectFullName );
+    finishProjectSync( projectFullName, false );
+    return;
+  }
+
+  QHash<QString, PushDiffPreparation> preparedDiffs;
+  const QList<PushDiffPreparation> results = watcher->future().results();
+  for ( const PushDiffPreparation &prepared : results )
+  {
+    for ( const QString &message : prepared.geodiffLog )
+    {
+      CoreUtils::log( "push " + projectFullName, message );
+    }
+    preparedDiffs.insert( prepared.filePath, prepared );
+  }
+
+  QList<MerginFile> filesToUpload;
+  QList<MerginFile> diffFiles;
+
+  for ( MerginFile &merginFile : updatedMerginFiles )
+  {
+    auto it = preparedDiffs.constFind( merginFile.path );
+    if ( it == preparedDiffs.constEnd() )
+      continue;
+
+    const PushDiffPreparation &prepared = it.value();
+    if ( prepared.geodiffResult == GEODIFF_SUCCESS )
+    {
+      // TODO: this is ugly. our basefile may not need to have the same checksum as the server's
+      // basefile (because each of them have applied the diff independently) so we have to fake it
+      QByteArray checksumBase = serverProject.fileInfo( merginFile.path ).checksum.toLatin1();
+
+      merginFile.diffName = prepared.diffName;
+      merginFile.diffChecksum = prepared.diffChecksum;
+      merginFile.diffSize = prepared.diffSize;
+      merginFile.chunks = generateChunkIdsForSize( merginFile.diffSize );
+      merginFile.diffBaseChecksum = QString::fromLatin1( checksumBase.data(), checksumBase.size() );
+
+      diffFiles.append( merginFile );
+
+      CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 successful: total size %2 bytes" ).arg( merginFile.path ).arg( merginFile.diffSize ) );
+    }
+    else
+    {
+      QFile::remove( transaction.projectDir + "/.mergin/" + prepared.diffName );
+      CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 FAILED with error %2 (will do full upload)" ).arg( merginFile.path ).arg( prepared.geodiffResult ) );
+    }
+  }
+
+  QJsonArray added = prepareUploadChangesJSON( addedMerginFiles );
+  filesToUpload.append( addedMerginFiles );
+
+  QJsonArray modified = prepareUploadChangesJSON( updatedMerginFiles );
+  filesToUpload.append( updatedMerginFiles );
+
+  QJsonArray removed = prepareUploadChangesJSON( deletedMerginFiles );
+  // removed not in filesToUpload
+
+  QJsonObject changes;
+  changes.insert( "added", added );
+  changes.insert( "removed", removed );
+  changes.insert( "updated", modified );
+  changes.insert( "renamed", QJsonArray() );
+
+  qint64 totalSize = 0;
+  for ( MerginFile file : filesToUpload )
+  {
+    if ( !file.diffName.isEmpty() )
+      totalSize += file.diffSize;
+    else
+      totalSize += file.size;
+  }
+
+  CoreUtils::log( "push " + projectFullName, QStringLiteral( "%1 items to upload (total size %2 bytes)" )
+                  .arg( filesToUpload.count() ).arg( totalSize ) );
+
+  transaction.totalSize = totalSize;
+  transaction.pushQueue = filesToUpload;
+  transaction.pushDiffFiles = diffFiles;
+
+  QJsonObject json;
+  json.insert( QStringLiteral( "changes" ), changes );
+  json.insert( QStringLiteral( "version" ), QString( "v%1" ).arg( serverProject.version ) );
+  QJsonDocument jsonDoc;
+  jsonDoc.setObject( json );
+
+  pushStart( projectFullName, jsonDoc.toJson( QJsonDocument::Compact ) );
+}
+
 void MerginApi::pushFinishReplyFinished()
 {
   QNetworkReply *r = qobject_cast<QNetworkReply *>( sender() );
@@ -3396,6 +3686,15 @@ void MerginApi::finishProjectSync( const QString &projectFullName, bool syncSucc
 
   emit syncProjectStatusChanged( projectFullName, -1 );   // -1 means there's no sync going on
 
+  if ( transaction.requestCount > 0 )
+  {
+    CoreUtils::log( "sync " + projectFullName, QStringLiteral( "Network: %1 file requests over %2, request setup %3 ms, transfer %4 ms" )
+                    .arg( transaction.requestCount )
+                    .arg( transaction.http2Used ? QStringLiteral( "HTTP/2" ) : QStringLiteral( "HTTP/1.1" ) )
+                    .arg( transaction.requestSetupMs )
+                    .arg( transaction.requestTransferMs ) );
+  }
+
   if ( syncSuccessful )
   {
     // update the local metadata file
@@ -23,6 +23,9 @@
 #include <QSet>
 #include <QByteArray>
 #include <QDateTime>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QSslConfiguration>
 
 #include "merginapistatus.h"
 #include "merginservertype.h"
@@ -35,6 +38,7 @@
 #include "merginuserinfo.h"
 #include "merginworkspaceinfo.h"
 #include "merginuserauth.h"
+#include "merginprojectslistcache.h"
 
 struct ProjectDiff
 {
@@ -112,6 +116,21 @@ struct DownloadQueueItem
 };
 
 
+/**
+ * Result of preparing a single diffable file for push: the changeset against the basefile
+ * with its checksum and size. It is computed in a worker thread before the push is started.
+ */
+struct PushDiffPreparation
+{
+  QString filePath;          //!< path within the project
+  int geodiffResult = -1;    //!< result code of the changeset creation (GEODIFF_SUCCESS on success)
+  QString diffName;          //!< name of the diff file in the .mergin folder
+  QString diffChecksum;      //!< checksum of the diff file
+  qint64 diffSize = 0;       //!< size of the diff file in bytes
+  QStringList geodiffLog;    //!< messages of geodiff, written to the log from the main thread
+};
+
+
 /**
  * Entry for each file that will be updated. At the end of a successful pull of new data,
  * all the tasks are executed.
@@ -156,6 +175,7 @@ struct TransactionStatus
   QPointer<QNetworkReply> replyPushStart;
   QPointer<QNetworkReply> replyPushFile;
   QPointer<QNetworkReply> replyPushFinish;
+  QPointer<QFutureWatcher<PushDiffPreparation>> pushDiffWatcher;  //!< changesets being prepared before push start
 
   // pull-related data
   QList<DownloadQueueItem> downloadQueue;  //!< pending list of stuff to download - chunks of project files or diff files (at the end of transaction it is empty)
@@ -170,6 +190,22 @@ struct TransactionStatus
   int retryCount = 0;  //!< current number of retry attempts for failed network requests
   static const int MAX_RETRY_COUNT = 5;  //!< maximum number of retry attempts for failed network requests
 
+  // parallel downloads
+  bool http2Used = false;  //!< true when the server multiplexes the transfers over a single HTTP/2 connection
+  static const int MAX_PARALLEL_DOWNLOADS = 5;  //!< maximum number of concurrent download requests over HTTP/1.1
+  static const int MAX_PARALLEL_DOWNLOADS_HTTP2 = 16;  //!< maximum number of concurrent download requests over HTTP/2
+
+  //! Returns number of download requests to run at once, more of them share the connection when it is multiplexed
+  int maxParallelDownloads() const { return http2Used ? MAX_PARALLEL_DOWNLOADS_HTTP2 : MAX_PARALLEL_DOWNLOADS; }
+
+  // upload compression
+  bool compressedUploads = false;  //!< true when the server announced it accepts gzip-encoded upload chunks
+
+  // network instrumentation
+  int requestCount = 0;  //!< number of finished file transfer requests (download items and upload chunks)
+  qint64 requestSetupMs = 0;  //!< time spent from sending the requests until the response headers arrived (connection setup + server latency)
+  qint64 requestTransferMs = 0;  //!< time spent from receiving the response headers until the requests finished (payload transfer)
+
   QString projectDir;
   QByteArray projectMetadata;  //!< metadata of the new project (not parsed)
   bool firstTimeDownload = false;   //!< only for update. whether this is first time to download the project (on failure we would also remove the project folder)
@@ -492,6 +528,12 @@ class MerginApi: public QObject
     // Returns true for files that are under .mergin folder or contains ignored extension from sIgnoreExtensions
     static bool isInIgnore( const QFileInfo &info );
 
+    /**
+     * Returns paths (relative to the project directory) of all project files that are subject of sync
+     * \param projectPath path to the project directory, including the trailing slash
+     */
+    static QSet<QString> listFiles( const QString &projectPath );
+
     /**
      * Performs checks and returns if a given file is excluded from the sync.
      * If selective-sync-enabled is true, it checks if a file extension is from exlcudeSync extension list.
@@ -600,6 +642,13 @@ class MerginApi: public QObject
     void listProjectsFinished( const MerginProjectsList &merginProjects, int projectCount, int page, QString requestId );
     void listProjectsFailed();
     void listProjectsByNameFinished( const MerginProjectsList &merginProjects, QString requestId );
+
+    /**
+     * Emitted right after listProjects()/listProjectsByName() when there is a cached listing for the same request.
+     * The regular finished signal with the same request id follows once the listing is revalidated with the server.
+     */
+    void listProjectsLoadedFromCache( const MerginProjectsList &merginProjects, int projectCount, int page, QString requestId );
+    void listProjectsByNameLoadedFromCache( const MerginProjectsList &merginProjects, QString requestId );
     void syncProjectFinished( const QString &projectFullName, bool successfully, int version );
     void projectReloadNeededAfterSync( const QString &projectFullName );
     /**
@@ -750,11 +799,25 @@ class MerginApi: public QObject
 
     void sendPushCancelRequest( const QString &projectFullName, const QString &transactionUUID );
 
+    /**
+     * Creates changeset of a diffable file (to the diff name already set in \a prepared)
+     * and calculates its checksum and size.
+     * Runs in a worker thread, so it must not touch any state of MerginApi.
+     */
+    static PushDiffPreparation preparePushDiff( const QString &projectDir, PushDiffPreparation prepared );
+
+    /**
+     * Called when all changesets of the push transaction have been prepared.
+     * Assembles the list of changes and sends the push start request.
+     * When the preparation got canceled, diff files of \a pendingDiffs are removed.
+     */
+    void pushDiffsPrepared( const QString &projectFullName, const MerginProjectMetadata &serverProject,
+                            const QList<MerginFile> &addedMerginFiles, QList<MerginFile> updatedMerginFiles,
+                            const QList<MerginFile> &deletedMerginFiles, const QList<PushDiffPreparation> &pendingDiffs );
+
     bool writeData( const QByteArray &data, const QString &path );
     void createPathIfNotExists( const QString &filePath );
 
-    static QSet<QString> listFiles( const QString &projectPath );
-
     bool validateAuth();
     void checkMerginVersion( QString apiVersion, bool serverSupportsSubscriptions, QString msg = QStringLiteral() );
 
@@ -804,6 +867,13 @@ class MerginApi: public QObject
     //! Starts download request of another item
     void downloadNextItem( const QString &projectFullName );
 
+    /**
+     * Appends data received so far by the download reply to the temporary file.
+     * Data of replies with error HTTP status are kept in the reply.
+     * \returns false if the temporary file could not be opened
+     */
+    static bool writeDownloadedData( QNetworkReply *reply, const QString &tempFilePath );
+
     //! Removes temp folder for project
     void removeProjectsTempFolder( const QString &projectNamespace, const QString &projectName );
 
@@ -820,6 +890,34 @@ class MerginApi: public QObject
 
     QNetworkRequest getDefaultRequest( bool withAuth = true );
 
+    /**
+     * Opens the connection to the Mergin server ahead of the first request of a transaction,
+     * so that the DNS lookup, TCP and TLS handshakes overlap with the local work of the transaction.
+     * Following requests reuse the already established connection.
+     */
+    void warmUpConnection();
+
+    //! Returns SSL configuration of the warmed up connection, it offers HTTP/2 through ALPN
+    static QSslConfiguration warmUpSslConfiguration();
+
+    /**
+     * Starts to measure timing of the \a reply - the time until its response headers arrive
+     * (request setup) and the time from then until it finishes (payload transfer).
+     */
+    void startRequestTiming( QNetworkReply *reply );
+
+    //! Adds timing of the finished \a reply to the network statistics of the \a transaction
+    void recordRequestTiming( TransactionStatus &transaction, QNetworkReply *reply );
+
+    //! Returns key of the cached projects listing for the request url
+    QString projectsListCacheKey( const QString &requestUrl ) const;
+
+    //! Adds headers so that the server only sends the listing when it changed since it was cached
+    static void setConditionalRequestHeaders( QNetworkRequest &request, const MerginProjectsListCache::Entry &cached );
+
+    //! Returns listing data from the reply (or from the cache when not modified) and updates the cache
+    QByteArray readProjectsListReply( QNetworkReply *reply );
+
     bool projectFileHasBeenUpdated( const ProjectDiff &diff );
 
     //! Checks if retrieving the project role from the server was successful and
@@ -833,6 +931,7 @@ class MerginApi: public QObject
     QString getCachedProjectRole( const QString &projectFullName ) const;
 
     QNetworkAccessManager *mManager = nullptr;
+    QElapsedTimer mNetworkTimer; //!< monotonic clock for request timing instrumentation
 
     QString mApiRoot;
     LocalProjectsManager &mLocalProjects;
@@ -848,7 +947,8 @@ class MerginApi: public QObject
       AttrProjectFullName = QNetworkRequest::User,
       AttrTempFileName    = QNetworkRequest::User + 1,
       AttrWorkspaceName   = QNetworkRequest::User + 2,
-      AttrAcceptFlag      = QNetworkRequest::User + 3
+      AttrAcceptFlag      = QNetworkRequest::User + 3,
+      AttrCacheKey        = QNetworkRequest::User + 4
     };
 
     Transactions mTransactionalStatus; //projectFullname -> transactionStatus
@@ -869,6 +969,8 @@ class MerginApi: public QObject
 
     MerginServerType::ServerType mServerType = MerginServerType::ServerType::OLD;
 
+    MerginProjectsListCache mProjectsListCache;
+
     friend class TestMerginApi;
 };
 
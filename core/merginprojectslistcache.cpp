@@ -0,0 +1,100 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "merginprojectslistcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+
+#include "coreutils.h"
+
+MerginProjectsListCache::MerginProjectsListCache( const QString &cacheDir )
+  : mCacheDir( cacheDir )
+{
+}
+
+QString MerginProjectsListCache::entryPath( const QString &key ) const
+{
+  // key may contain any characters (search expressions), so let's use its hash as a file name
+  QByteArray hash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  return mCacheDir + "/" + QString::fromLatin1( hash ) + ".cache";
+}
+
+MerginProjectsListCache::Entry MerginProjectsListCache::get( const QString &key ) const
+{
+  Entry entry;
+
+  QFile f( entryPath( key ) );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return entry;
+
+  QDataStream stream( &f );
+  stream.setVersion( QDataStream::Qt_6_5 );
+
+  QString storedKey;
+  stream >> storedKey >> entry.etag >> entry.lastModified >> entry.data;
+
+  if ( stream.status() != QDataStream::Ok || storedKey != key )
+    return Entry();
+
+  // modification time of the file is the time of the last use
+  f.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+
+  return entry;
+}
+
+void MerginProjectsListCache::store( const QString &key, const Entry &entry )
+{
+  QDir dir;
+  if ( !dir.exists( mCacheDir ) )
+    dir.mkpath( mCacheDir );
+
+  QSaveFile f( entryPath( key ) );
+  if ( !f.open( QIODevice::WriteOnly ) )
+  {
+    CoreUtils::log( "projects list cache", QStringLiteral( "Unable to save cache %1" ).arg( f.fileName() ) );
+    return;
+  }
+
+  QDataStream stream( &f );
+  stream.setVersion( QDataStream::Qt_6_5 );
+  stream << key << entry.etag << entry.lastModified << entry.data;
+
+  if ( !f.commit() )
+  {
+    CoreUtils::log( "projects list cache", QStringLiteral( "Unable to save cache %1" ).arg( f.fileName() ) );
+    return;
+  }
+
+  evict();
+}
+
+void MerginProjectsListCache::evict()
+{
+  // most recently used first
+  const QFileInfoList files = QDir( mCacheDir ).entryInfoList( { QStringLiteral( "*.cache" ) }, QDir::Files, QDir::Time );
+
+  qint64 size = 0;
+  for ( int i = 0; i < files.count(); ++i )
+  {
+    size += files.at( i ).size();
+    if ( i >= MAX_ENTRIES || size > MAX_SIZE )
+    {
+      QFile::remove( files.at( i ).absoluteFilePath() );
+    }
+  }
+}
+
+void MerginProjectsListCache::clear()
+{
+  QDir( mCacheDir ).removeRecursively();
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef MERGINPROJECTSLISTCACHE_H
+#define MERGINPROJECTSLISTCACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Persistent cache of the raw server responses with lists of projects.
+ *
+ * Each listing (workspace, search expression, page, ...) is identified by a key
+ * and stored in its own file together with its validators (ETag and Last-Modified),
+ * so that it can be shown immediately and revalidated with a conditional request later.
+ * The number and total size of the listings are limited, the least recently used ones are
+ * removed first.
+ */
+class MerginProjectsListCache
+{
+  public:
+    struct Entry
+    {
+      QByteArray data; //!< raw json response of the server
+      QByteArray etag; //!< value of the ETag header of the response
+      QByteArray lastModified; //!< value of the Last-Modified header of the response
+
+      bool isValid() const { return !data.isEmpty(); }
+    };
+
+    //! Maximum number of cached listings
+    static constexpr int MAX_ENTRIES = 50;
+
+    //! Maximum total size of cached listings in bytes
+    static constexpr qint64 MAX_SIZE = 10 * 1024 * 1024;
+
+    explicit MerginProjectsListCache( const QString &cacheDir );
+
+    //! Returns cached listing for the key, invalid entry if there is none. The listing becomes the most recently used one.
+    Entry get( const QString &key ) const;
+
+    //! Stores (replaces) cached listing for the key, least recently used listings are removed when over the limits
+    void store( const QString &key, const Entry &entry );
+
+    //! Removes all cached listings, e.g. when user signs out
+    void clear();
+
+    //! Directory where the listings are stored
+    QString cacheDir() const { return mCacheDir; }
+
+  private:
+    QString entryPath( const QString &key ) const;
+
+    //! Removes least recently used listings over MAX_ENTRIES and MAX_SIZE
+    void evict();
+
+    QString mCacheDir;
+};
+
+#endif // MERGINPROJECTSLISTCACHE_H
@@ -11,12 +11,15 @@
 #include <QCryptographicHash>
 #include <QFileInfo>
 #include <QDataStream>
+#include <QSaveFile>
+#include <QDir>
 
 #include "projectchecksumcache.h"
 #include "coreutils.h"
 #include "merginapi.h"
 
 const QString ProjectChecksumCache::sCacheFile = QStringLiteral( "checksum.cache" );
+QMutex ProjectChecksumCache::sCacheFileMutex;
 
 QString ProjectChecksumCache::cacheFilePath() const
 {
@@ -31,25 +34,8 @@ QString ProjectChecksumCache::cacheDirPath() const
 ProjectChecksumCache::ProjectChecksumCache( const QString &projectDir )
   : mProjectDir( projectDir )
 {
-  QFile f( cacheFilePath() );
-
-  if ( f.open( QIODevice::ReadOnly ) )
-  {
-    QDataStream stream( &f );
-    stream.setVersion( QDataStream::Qt_6_5 );
-    QString path;
-    QString checksum;
-    QDateTime mtime;
-    CacheValue entry;
-
-    while ( stream.atEnd() == false )
-    {
-      stream >> path >> checksum >> mtime;
-      entry.checksum = checksum;
-      entry.mtime = mtime;
-      mCache.insert( path, entry );
-    }
-  }
+  QMutexLocker locker( &sCacheFileMutex );
+  readCacheFile( mCache );
 }
 
 ProjectChecksumCache::~ProjectChecksumCache()
@@ -57,13 +43,26 @@ ProjectChecksumCache::~ProjectChecksumCache()
   if ( !mCacheModified )
     return;
 
+  QMutexLocker locker( &sCacheFileMutex );
+
+  // keep entries that other instances stored since we have read the cache, an entry
+  // of a newer version of the file wins over the one we have read or calculated before
+  QHash<QString, CacheValue> storedCache;
+  readCacheFile( storedCache );
+  for ( auto it = storedCache.constBegin(); it != storedCache.constEnd(); ++it )
+  {
+    auto match = mCache.find( it.key() );
+    if ( match == mCache.end() || match.value().mtime < it.value().mtime )
+      mCache.insert( it.key(), it.value() );
+  }
+
   // Make sure the directory exists
   QDir dir;
   if ( !dir.exists( cacheDirPath() ) )
     dir.mkpath( cacheDirPath() );
 
-  QFile f( cacheFilePath() );
-  if ( f.open( QIODevice::WriteOnly ) ) // implies Truncate
+  QSaveFile f( cacheFilePath() );
+  if ( f.open( QIODevice::WriteOnly ) )
   {
     QDataStream stream( &f );
     stream.setVersion( QDataStream::Qt_6_5 );
@@ -73,13 +72,37 @@ ProjectChecksumCache::~ProjectChecksumCache()
       stream << it.key() << it.value().checksum << it.value().mtime;
     }
   }
-  else
+
+  if ( !f.commit() )
   {
     CoreUtils::log( "projectchecksumcache", QStringLiteral( "Unable to save cache %1" ).arg( cacheFilePath() ) );
   }
 }
 
-QString ProjectChecksumCache::get( const QString &path )
+void ProjectChecksumCache::readCacheFile( QHash<QString, CacheValue> &cache ) const
+{
+  QFile f( cacheFilePath() );
+
+  if ( f.open( QIODevice::ReadOnly ) )
+  {
+    QDataStream stream( &f );
+    stream.setVersion( QDataStream::Qt_6_5 );
+    QString path;
+    QString checksum;
+    QDateTime mtime;
+    CacheValue entry;
+
+    while ( stream.atEnd() == false )
+    {
+      stream >> path >> checksum >> mtime;
+      entry.checksum = checksum;
+      entry.mtime = mtime;
+      cache.insert( path, entry );
+    }
+  }
+}
+
+QString ProjectChecksumCache::get( const QString &path, const std::atomic_bool *canceled )
 {
   QDateTime localLastModified = QFileInfo( mProjectDir + "/" + path ).lastModified();
 
@@ -93,7 +116,10 @@ QString ProjectChecksumCache::get( const QString &path )
     }
   }
 
-  QByteArray localChecksumBytes = CoreUtils::calculateChecksum( mProjectDir + "/" + path );
+  QByteArray localChecksumBytes = CoreUtils::calculateChecksum( mProjectDir + "/" + path, canceled );
+  if ( canceled && *canceled )
+    return QString();
+
   QString localChecksum = QString::fromLatin1( localChecksumBytes.data(), localChecksumBytes.size() );
 
   CacheValue entry;
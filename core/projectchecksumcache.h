@@ -14,6 +14,9 @@
 #include <QString>
 #include <QDateTime>
 #include <QHash>
+#include <QMutex>
+
+#include <atomic>
 
 #include "inputconfig.h"
 
@@ -23,6 +26,11 @@ class TestProjectChecksumCache;
 
 /**
  * Calculates the checksums of local files and store the results in the local binary file
+ *
+ * Multiple instances for the same project may exist at the same time (e.g. sync and background
+ * precomputation in another thread). Reading and writing of the cache file is serialized and
+ * entries stored by other instances meanwhile are kept when the cache is saved - for the same
+ * file, the entry with the newer modification date wins.
  */
 class ProjectChecksumCache
 {
@@ -34,8 +42,9 @@ class ProjectChecksumCache
      * Returns Sha1 checksum of file (with-caching)
      * Recalculates checksum for an entry not in cache
      * \param path relative path of the file to mProjectDir
+     * \param canceled when set and it becomes true during the calculation, empty checksum is returned and not cached
      */
-    QString get( const QString &path );
+    QString get( const QString &path, const std::atomic_bool *canceled = nullptr );
 
     //! Name of the file in which the cache for the project is stored
     static const QString sCacheFile;
@@ -54,9 +63,14 @@ class ProjectChecksumCache
       QString checksum; //!< calculated checksum
     };
 
+    //! Reads entries stored in the cache file to the cache
+    void readCacheFile( QHash<QString, CacheValue> &cache ) const;
+
     QString mProjectDir;
     QHash<QString, CacheValue> mCache; //!< key -> file relative path to mProjectDir
     bool mCacheModified = false;
+
+    static QMutex sCacheFileMutex; //!< guards reading and writing of cache files
 };
 
 #endif // PROJECTCHECKSUMCACHE_H